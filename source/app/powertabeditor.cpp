@@ -89,6 +89,7 @@
 #include <app/tuningdictionary.h>
 
 #include <audio/midiplayer.h>
+#include <audio/playbackmetrics.h>
 #include <audio/settings.h>
 
 #include <boost/range/algorithm/transform.hpp>
@@ -126,12 +127,16 @@
 
 #include <formats/fileformatmanager.h>
 
+#include <midi/midifile.h>
+#include <midi/scoretimeline.h>
+
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDesktopServices>
 #include <QDockWidget>
 #include <QFileDialog>
 #include <QFontDatabase>
+#include <QGuiApplication>
 #include <QKeyEvent>
 #include <QMenuBar>
 #include <QMessageBox>
@@ -139,8 +144,10 @@
 #include <QPrinter>
 #include <QPrintDialog>
 #include <QPrintPreviewDialog>
+#include <QScreen>
 #include <QScrollArea>
 #include <QTabBar>
+#include <QTimer>
 #include <QUrl>
 #include <QVBoxLayout>
 
@@ -163,6 +170,11 @@ PowerTabEditor::PowerTabEditor()
       myUndoManager(new UndoManager()),
       myTuningDictionary(new TuningDictionary()),
       myIsPlaying(false),
+      myPlaybackCaretTimer(new QTimer(this)),
+      myPlaybackLocationCount(0),
+      myCaretUpdateCount(0),
+      myMergedLocationUpdates(0),
+      myPlaybackDiagnosticsTimer(new QTimer(this)),
       myRecentFiles(nullptr),
       myActiveDurationType(Position::EighthNote),
       myTabWidget(nullptr),
@@ -192,6 +204,31 @@ PowerTabEditor::PowerTabEditor()
     connect(myUndoManager.get(), &UndoManager::cleanChanged, this,
             &PowerTabEditor::updateModified);
 
+    // Regenerate the events for the player when the score is edited during
+    // playback.
+    auto update_player = [this]() {
+        if (myIsPlaying && myMidiPlayer && myMidiPlayer->isRunning())
+            myMidiPlayer->updateScore();
+    };
+    connect(myUndoManager.get(), &UndoManager::redrawNeeded, this,
+            update_player);
+    connect(myUndoManager.get(), &UndoManager::fullRedrawNeeded, this,
+            update_player);
+
+    // During playback, the caret is updated at most once per frame rather
+    // than for every event played by the MIDI thread.
+    const QScreen *screen = QGuiApplication::primaryScreen();
+    const qreal refresh_rate = screen ? screen->refreshRate() : 60.0;
+    myPlaybackCaretTimer->setTimerType(Qt::PreciseTimer);
+    myPlaybackCaretTimer->setInterval(
+        std::max(1, qRound(1000.0 / std::max(refresh_rate, 1.0))));
+    connect(myPlaybackCaretTimer, &QTimer::timeout, this,
+            &PowerTabEditor::updatePlaybackCaret);
+
+    myPlaybackDiagnosticsTimer->setInterval(500);
+    connect(myPlaybackDiagnosticsTimer, &QTimer::timeout, this,
+            &PowerTabEditor::updatePlaybackDiagnostics);
+
     myTuningDictionary->loadInBackground();
     mySettingsManager->load(Paths::getConfigDir());
 
@@ -309,6 +346,8 @@ void PowerTabEditor::switchTab(int index)
     if (index != -1)
     {
         const Document &doc = myDocumentManager->getCurrentDocument();
+        myScoreTimeline = std::make_unique<ScoreTimeline>(
+            doc.getScore(), MidiFile::DEFAULT_PPQ);
         myMixer->reset(doc.getScore());
         myInstrumentPanel->reset(doc.getScore());
         myPlaybackWidget->reset(doc);
@@ -316,6 +355,7 @@ void PowerTabEditor::switchTab(int index)
     }
     else
     {
+        myScoreTimeline.reset();
         myMixer->clear();
         myInstrumentPanel->clear();
     }
@@ -348,6 +388,7 @@ bool PowerTabEditor::closeTab(int index)
             return false;
     }
 
+    // Stopping playback releases the player, which refers to the score.
     if (myDocumentManager->getDocument(index).getCaret().isInPlaybackMode())
         startStopPlayback();
 
@@ -586,6 +627,31 @@ void PowerTabEditor::editFileInformation()
     }
 }
 
+/// Formats the timing measurements in milliseconds.
+static QString formatPlaybackMetrics(const PlaybackMetrics::Summary &summary)
+{
+    auto ms = [](int64_t us) { return QString::number(us / 1000.0, 'f', 1); };
+
+    const QString first_note = (summary.myTimeToFirstNote >= 0)
+                                   ? ms(summary.myTimeToFirstNote)
+                                   : QStringLiteral("-");
+
+    return QCoreApplication::translate(
+               "PowerTabEditor",
+               "Generation: %1 ms, First Note: %2 ms, Lateness "
+               "(p50/p95/p99/max): %3/%4/%5/%6 ms, Drift Corrections: %7 "
+               "(%8 ms), Messages: %9/s")
+        .arg(ms(summary.myGenerationTime))
+        .arg(first_note)
+        .arg(ms(summary.myLatenessP50))
+        .arg(ms(summary.myLatenessP95))
+        .arg(ms(summary.myLatenessP99))
+        .arg(ms(summary.myLatenessMax))
+        .arg(summary.myDriftCorrections)
+        .arg(ms(summary.myDriftCorrectionTotal))
+        .arg(qRound(summary.myMessagesPerSecond));
+}
+
 void PowerTabEditor::startStopPlayback(bool from_measure_start)
 {
     myIsPlaying = !myIsPlaying;
@@ -604,19 +670,24 @@ void PowerTabEditor::startStopPlayback(bool from_measure_start)
 
         getCaret().setIsInPlaybackMode(true);
         myPlaybackWidget->setPlaybackMode(true);
-        enableEditing(false);
+
+        // The score can still be edited during playback, and the changes are
+        // heard once playback reaches the next bar. However, the document
+        // can't be switched or closed while it is being played.
+        enableDocumentSwitching(false);
+        myPlayFromStartOfMeasureCommand->setEnabled(false);
+        myStopCommand->setEnabled(true);
 
         const ScoreLocation &location = getLocation();
         myMidiPlayer.reset(
             new MidiPlayer(*mySettingsManager, location,
                            myPlaybackWidget->getPlaybackSpeed()));
 
-        connect(myMidiPlayer.get(), &MidiPlayer::playbackSystemChanged, this,
-                &PowerTabEditor::moveCaretToSystem);
-        connect(myMidiPlayer.get(), &MidiPlayer::playbackPositionChanged, this,
-                &PowerTabEditor::moveCaretToPosition);
-        connect(myMidiPlayer.get(), &MidiPlayer::finished, this,
-                [this]() { startStopPlayback(); });
+        connect(myMidiPlayer.get(), &MidiPlayer::finished, this, [this]() {
+            // Catch up with any location changes since the last poll.
+            updatePlaybackCaret();
+            startStopPlayback();
+        });
         connect(myPlaybackWidget, &PlaybackWidget::playbackSpeedChanged,
                 myMidiPlayer.get(), &MidiPlayer::changePlaybackSpeed);
 
@@ -624,12 +695,48 @@ void PowerTabEditor::startStopPlayback(bool from_measure_start)
             QMessageBox::critical(this, tr("Midi Error"), msg);
         });
 
+        // Loop over the selected bars, or the current bar if there isn't a
+        // selection.
+        if (myLoopCommand->isChecked())
+        {
+            const int system = location.getSystemIndex();
+            const int position = location.getPositionIndex();
+            const int selection_start = location.getSelectionStart();
+
+            myMidiPlayer->setLoopRange(
+                SystemLocation(system, std::min(position, selection_start)),
+                SystemLocation(system, std::max(position, selection_start)));
+        }
+
+        myPlaybackLocationCount = 0;
+        myCaretUpdateCount = 0;
+        myMergedLocationUpdates = 0;
+        myPlaybackCaretTimer->start();
+        myPlaybackDiagnosticsTimer->start();
+        updatePlaybackDiagnostics();
+
         myMidiPlayer->start();
     }
     else
     {
-        // If we manually stop playback, tell the midi thread to finish.
-        if (myMidiPlayer && myMidiPlayer->isRunning())
+        myPlaybackCaretTimer->stop();
+
+        // Show the final measurements before the player is destroyed.
+        myPlaybackDiagnosticsTimer->stop();
+        updatePlaybackDiagnostics();
+        if (myMidiPlayer && myPlaybackDiagnosticsCommand->isChecked())
+        {
+            qDebug() << "Playback caret updates:" << myCaretUpdateCount
+                     << "merged location changes:" << myMergedLocationUpdates;
+            qDebug().noquote() << "Playback timing:"
+                               << formatPlaybackMetrics(
+                                      myMidiPlayer->getMetrics()->getSummary());
+        }
+
+        // Release the player, which also tells the midi thread to finish if
+        // playback was stopped manually. The player refers to the document's
+        // score, so it must not outlive the playback.
+        if (myMidiPlayer)
         {
             // Avoid recursion from the finished() signal being called.
             myMidiPlayer->disconnect(this);
@@ -645,11 +752,49 @@ void PowerTabEditor::startStopPlayback(bool from_measure_start)
     }
 }
 
+void PowerTabEditor::updatePlaybackCaret()
+{
+    if (!myMidiPlayer)
+        return;
+
+    // Load the count before the location, so that the location is at least as
+    // recent as the count.
+    const uint64_t count = myMidiPlayer->getLocationChangeCount();
+    if (count == myPlaybackLocationCount)
+        return;
+
+    myMergedLocationUpdates += count - myPlaybackLocationCount - 1;
+    myPlaybackLocationCount = count;
+    ++myCaretUpdateCount;
+
+    const SystemLocation location = myMidiPlayer->getPlaybackLocation();
+    if (location.getSystem() != getLocation().getSystemIndex())
+        moveCaretToSystem(location.getSystem());
+
+    moveCaretToPosition(location.getPosition());
+}
+
+void PowerTabEditor::updatePlaybackDiagnostics()
+{
+    if (!myMidiPlayer)
+        return;
+
+    if (myPlaybackDiagnosticsCommand->isChecked())
+    {
+        myPlaybackWidget->updateDiagnostics(
+            formatPlaybackMetrics(myMidiPlayer->getMetrics()->getSummary()));
+    }
+}
+
 void PowerTabEditor::redrawSystem(int index)
 {
     getCaret().moveToValidPosition();
     getScoreArea()->redrawSystem(index);
     updateCommands();
+
+    if (myScoreTimeline)
+        myScoreTimeline->updateSystem(index);
+    updateLocationLabel();
 }
 
 void PowerTabEditor::redrawScore()
@@ -663,6 +808,10 @@ void PowerTabEditor::redrawScore()
     myMixer->reset(doc.getScore());
     myInstrumentPanel->reset(doc.getScore());
     myPlaybackWidget->reset(doc);
+
+    if (myScoreTimeline)
+        myScoreTimeline->update();
+    updateLocationLabel();
 }
 
 void PowerTabEditor::moveCaretToStart()
@@ -1764,10 +1913,6 @@ void PowerTabEditor::editViewFilters()
 
 bool PowerTabEditor::eventFilter(QObject *object, QEvent *event)
 {
-    // Don't handle key presses during playback.
-    if (myIsPlaying)
-        return QMainWindow::eventFilter(object, event);
-
     ScoreArea *scorearea = getScoreArea();
     if (scorearea && event->type() == QEvent::KeyPress)
     {
@@ -2019,6 +2164,20 @@ void PowerTabEditor::createCommands()
     connect(myMetronomeCommand, &QAction::triggered, this,
             &PowerTabEditor::toggleMetronome);
 
+    myLoopCommand = new Command(tr("Loop Selection"), "Playback.Loop",
+                                QKeySequence(), this);
+    myLoopCommand->setCheckable(true);
+
+    myPlaybackDiagnosticsCommand =
+        new Command(tr("Show Playback Diagnostics"), "Playback.Diagnostics",
+                    QKeySequence(), this);
+    myPlaybackDiagnosticsCommand->setCheckable(true);
+    connect(myPlaybackDiagnosticsCommand, &QAction::toggled, this,
+            [this](bool visible) {
+                myPlaybackWidget->setDiagnosticsVisible(visible);
+                updatePlaybackDiagnostics();
+            });
+
     // Section navigation actions.
     myFirstSectionCommand =
         new Command(tr("First Section"), "Position.Section.FirstSection",
@@ -2895,6 +3054,9 @@ void PowerTabEditor::createMenus()
     myPlaybackMenu->addAction(myStopCommand);
     myPlaybackMenu->addAction(myRewindCommand);
     myPlaybackMenu->addAction(myMetronomeCommand);
+    myPlaybackMenu->addAction(myLoopCommand);
+    myPlaybackMenu->addSeparator();
+    myPlaybackMenu->addAction(myPlaybackDiagnosticsCommand);
 
     // Position Menu.
     myPositionMenu = menuBar()->addMenu(tr("&Position"));
@@ -3168,7 +3330,8 @@ void PowerTabEditor::createTabArea()
 
     myPlaybackWidget =
         new PlaybackWidget(*myPlayPauseCommand, *myRewindCommand,
-                           *myStopCommand, *myMetronomeCommand, this);
+                           *myStopCommand, *myMetronomeCommand,
+                           *myLoopCommand, this);
 
     connect(myPlaybackWidget, &PlaybackWidget::activeVoiceChanged, this,
             &PowerTabEditor::updateActiveVoice);
@@ -3325,8 +3488,13 @@ inline void updateNoteProperty(Command *command, const Note *note,
 
 void PowerTabEditor::updateCommands()
 {
+    // The document can't be switched or played from another bar until
+    // playback stops.
     if (myIsPlaying)
-        return;
+    {
+        myPlayFromStartOfMeasureCommand->setEnabled(false);
+        enableDocumentSwitching(false);
+    }
 
     ScoreLocation location = getLocation();
     const Score &score = location.getScore();
@@ -3599,18 +3767,16 @@ void PowerTabEditor::enableEditing(bool enable)
             action->setEnabled(enable);
     }
 
-    myCloseTabCommand->setEnabled(enable);
     mySaveCommand->setEnabled(enable);
     mySaveAsCommand->setEnabled(enable);
     myPrintCommand->setEnabled(enable);
     myPrintPreviewCommand->setEnabled(enable);
-    myPlayFromStartOfMeasureCommand->setEnabled(enable);
+    myPlayFromStartOfMeasureCommand->setEnabled(enable && !myIsPlaying);
     myAddPlayerCommand->setEnabled(enable);
     myAddInstrumentCommand->setEnabled(enable);
     myPlayerChangeCommand->setEnabled(enable);
     myEditViewFiltersCommand->setEnabled(enable);
-    myNextTabCommand->setEnabled(enable);
-    myPrevTabCommand->setEnabled(enable);
+    enableDocumentSwitching(enable && !myIsPlaying);
 
     // MIDI commands are always enabled if documents are open.
     if (myDocumentManager->hasOpenDocuments())
@@ -3618,8 +3784,16 @@ void PowerTabEditor::enableEditing(bool enable)
         myPlayPauseCommand->setEnabled(true);
         myRewindCommand->setEnabled(true);
         myMetronomeCommand->setEnabled(true);
+        myLoopCommand->setEnabled(true);
         myStopCommand->setEnabled(myIsPlaying);
     }
+}
+
+void PowerTabEditor::enableDocumentSwitching(bool enable)
+{
+    myCloseTabCommand->setEnabled(enable);
+    myNextTabCommand->setEnabled(enable);
+    myPrevTabCommand->setEnabled(enable);
 
     // Prevent the user from changing tabs during playback.
     myTabWidget->tabBar()->setEnabled(enable);
@@ -3701,6 +3875,23 @@ void PowerTabEditor::updateLocationLabel()
 {
     myPlaybackWidget->updateLocationLabel(
         Util::toString(getCaret().getLocation()));
+
+    if (myScoreTimeline)
+    {
+        using std::chrono::milliseconds;
+
+        const ScoreLocation &location = getLocation();
+        const ScoreTimeline::Duration time =
+            myScoreTimeline
+                ->getTime(SystemLocation(location.getSystemIndex(),
+                                         location.getPositionIndex()))
+                .value_or(ScoreTimeline::Duration(0));
+
+        myPlaybackWidget->updateTimeLabel(
+            std::chrono::duration_cast<milliseconds>(time),
+            std::chrono::duration_cast<milliseconds>(
+                myScoreTimeline->getTotalTime()));
+    }
 }
 
 void PowerTabEditor::editKeySignature(const ScoreLocation &keyLocation)
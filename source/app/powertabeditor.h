@@ -22,6 +22,7 @@
 
 #include <app/pubsub/instrumentpubsub.h>
 #include <app/pubsub/playerpubsub.h>
+#include <cstdint>
 #include <memory>
 #include <score/dynamic.h>
 #include <score/position.h>
@@ -38,9 +39,11 @@ class MidiPlayer;
 class Mixer;
 class PlaybackWidget;
 class QActionGroup;
+class QTimer;
 class RecentFiles;
 class ScoreArea;
 class ScoreLocation;
+class ScoreTimeline;
 class SettingsManager;
 class TuningDictionary;
 class UndoManager;
@@ -347,6 +350,8 @@ private:
     void updateCommands();
     /// Enables or disables all editing commands.
     void enableEditing(bool enable);
+    /// Enables or disables the commands for closing or switching documents.
+    void enableDocumentSwitching(bool enable);
 
     /// Moves the caret back to the start, and restarts playback if necessary.
     void rewindPlaybackToStart();
@@ -415,12 +420,20 @@ private:
     Caret &getCaret();
     /// Returns the location of the caret within the active document.
     ScoreLocation &getLocation();
+    /// Moves the caret to the latest location published by the MIDI player,
+    /// if it has changed since the last update.
+    void updatePlaybackCaret();
+    /// Shows the timing measurements from the MIDI player, if the playback
+    /// diagnostics are enabled.
+    void updatePlaybackDiagnostics();
 
     std::unique_ptr<SettingsManager> mySettingsManager;
     std::unique_ptr<DocumentManager> myDocumentManager;
     std::unique_ptr<FileFormatManager> myFileFormatManager;
     std::unique_ptr<UndoManager> myUndoManager;
     std::unique_ptr<MidiPlayer> myMidiPlayer;
+    /// The timeline for the current document, which is updated after edits.
+    std::unique_ptr<ScoreTimeline> myScoreTimeline;
     std::unique_ptr<TuningDictionary> myTuningDictionary;
     PlayerEditPubSub myPlayerEditPubSub;
     PlayerRemovePubSub myPlayerRemovePubSub;
@@ -428,6 +441,17 @@ private:
     InstrumentRemovePubSub myInstrumentRemovePubSub;
     /// Tracks whether we are currently in playback mode.
     bool myIsPlaying;
+    /// Polls the playback location once per display refresh during playback.
+    QTimer *myPlaybackCaretTimer;
+    /// The number of location changes from the MIDI player that have been
+    /// observed so far.
+    uint64_t myPlaybackLocationCount;
+    /// The number of times that the caret was moved during playback, and the
+    /// number of location changes that were merged into a single update.
+    uint64_t myCaretUpdateCount;
+    uint64_t myMergedLocationUpdates;
+    /// Periodically refreshes the playback diagnostics during playback.
+    QTimer *myPlaybackDiagnosticsTimer;
     /// Tracks the last directory that a file was opened from.
     QString myPreviousDirectory;
     RecentFiles *myRecentFiles;
@@ -473,6 +497,8 @@ private:
     Command *myStopCommand;
     Command *myRewindCommand;
     Command *myMetronomeCommand;
+    Command *myLoopCommand;
+    Command *myPlaybackDiagnosticsCommand;
 
     QMenu *myPositionMenu;
     QMenu *myPositionSectionMenu;
@@ -0,0 +1,58 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "midioutputbackend.h"
+
+MidiOutputBackend::~MidiOutputBackend()
+{
+}
+
+void MidiMessageBatch::add(const std::vector<uint8_t> &message)
+{
+    myData.insert(myData.end(), message.begin(), message.end());
+    myMessageEnds.push_back(myData.size());
+}
+
+void MidiMessageBatch::clear()
+{
+    myData.clear();
+    myMessageEnds.clear();
+}
+
+const uint8_t *MidiMessageBatch::getData(size_t i) const
+{
+    return myData.data() + (i == 0 ? 0 : myMessageEnds[i - 1]);
+}
+
+size_t MidiMessageBatch::getSize(size_t i) const
+{
+    return myMessageEnds[i] - (i == 0 ? 0 : myMessageEnds[i - 1]);
+}
+
+bool MidiOutputBackend::sendMessages(const MidiMessageBatch &messages)
+{
+    bool success = true;
+    std::vector<uint8_t> message;
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        const uint8_t *data = messages.getData(i);
+        message.assign(data, data + messages.getSize(i));
+        success &= sendMessage(message);
+    }
+
+    return success;
+}
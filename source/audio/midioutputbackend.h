@@ -0,0 +1,79 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef AUDIO_MIDIOUTPUTBACKEND_H
+#define AUDIO_MIDIOUTPUTBACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// A group of MIDI messages which are stored contiguously, so that adding a
+/// message doesn't require an allocation once the batch has grown to its
+/// typical size. Clearing the batch keeps its capacity.
+class MidiMessageBatch
+{
+public:
+    void add(const std::vector<uint8_t> &message);
+    void clear();
+
+    bool empty() const { return myMessageEnds.empty(); }
+    /// Returns the number of messages in the batch.
+    size_t size() const { return myMessageEnds.size(); }
+
+    /// Returns the bytes of the i'th message.
+    const uint8_t *getData(size_t i) const;
+    /// Returns the length of the i'th message in bytes.
+    size_t getSize(size_t i) const;
+
+private:
+    /// The bytes of all of the messages.
+    std::vector<uint8_t> myData;
+    /// The end offset of each message in myData.
+    std::vector<size_t> myMessageEnds;
+};
+
+/// Interface for the destination of the MIDI messages sent by a
+/// MidiOutputDevice (e.g. a hardware port, or a virtual port for testing).
+class MidiOutputBackend
+{
+public:
+    virtual ~MidiOutputBackend();
+
+    /// Returns the number of available MIDI APIs.
+    virtual size_t getApiCount() = 0;
+    /// Returns the number of ports for the given API.
+    virtual unsigned int getPortCount(size_t api) = 0;
+    virtual std::string getPortName(size_t api, unsigned int port) = 0;
+
+    /// Opens the given port, closing any previously opened port.
+    /// @returns False if the port could not be opened.
+    virtual bool openPort(size_t api, unsigned int port) = 0;
+    virtual bool isPortOpen() const = 0;
+
+    /// Sends a message to the open port.
+    /// @returns False if the message could not be sent.
+    virtual bool sendMessage(const std::vector<uint8_t> &data) = 0;
+
+    /// Sends several messages at once. By default, this sends each message
+    /// individually.
+    /// @returns False if any of the messages could not be sent.
+    virtual bool sendMessages(const MidiMessageBatch &messages);
+};
+
+#endif
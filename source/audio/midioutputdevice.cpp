@@ -17,56 +17,35 @@
   
 #include "midioutputdevice.h"
 
-#include <RtMidi.h>
-#include <exception>
+#include "midioutputbackend.h"
+#include "rtmidioutputbackend.h"
+
 #include <score/dynamic.h>
 #include <score/generalmidi.h>
 #include <cassert>
 
-#ifdef __APPLE__
-#include "midisoftwaresynth.h"
-#endif
+MidiOutputDevice::ChannelState::ChannelState()
+    : myProgram(-1), myPitchWheel(-1)
+{
+    myControllers.fill(-1);
+}
 
-MidiOutputDevice::MidiOutputDevice() : myMidiOut(nullptr)
+MidiOutputDevice::MidiOutputDevice(std::shared_ptr<MidiOutputBackend> backend)
+    : myBackend(std::move(backend)), myIsBatching(false)
 {
-    // Initialize the OSX software synth.
-#ifdef __APPLE__
-    try
-    {
-        static MidiSoftwareSynth synth;
-        synth.initialize();
-    }
-    catch (std::exception &e)
-    {
-        std::cerr << e.what() << std::endl;
-    };
-#endif
+    if (!myBackend)
+        myBackend = std::make_shared<RtMidiOutputBackend>();
 
     myMaxVolumes.fill(Midi::MAX_MIDI_CHANNEL_VOLUME);
     myActiveVolumes.fill(static_cast<uint8_t>(VolumeLevel::fff));
-
-    // Create all MIDI APIs supported on this platform.
-    std::vector<RtMidi::Api> apis;
-    RtMidi::getCompiledApi(apis);
-
-    for (const RtMidi::Api &api : apis)
-    {
-        try
-        {
-            myMidiOuts.emplace_back(new RtMidiOut(api));
-        }
-        catch (RtMidiError &e)
-        {
-            // Continue anyway, another API might work.
-            e.printMessage();
-        }
-    }
 }
 
 MidiOutputDevice::~MidiOutputDevice()
 {
+    endBatch();
+
     // Make sure there aren't any lingering notes.
-    if (myMidiOut)
+    if (myBackend->isPortOpen())
     {
         for (uint8_t channel = 0; channel < Midi::NUM_MIDI_CHANNELS_PER_PORT;
              ++channel)
@@ -76,81 +55,119 @@ MidiOutputDevice::~MidiOutputDevice()
     }
 }
 
-void
-MidiOutputDevice::sendMessage(const std::vector<uint8_t> &data)
+/// Returns whether the controller's value persists, as opposed to e.g. data
+/// entry or channel mode messages which must always be sent.
+static bool isStatefulController(uint8_t controller)
 {
-    myMidiOut->sendMessage(&data);
+    return controller != MidiOutputDevice::DataEntryCoarse &&
+           controller != MidiOutputDevice::DataEntryFine &&
+           !(controller >= 96 && controller <= MidiOutputDevice::RpnMsb) &&
+           controller < 120;
 }
 
-bool MidiOutputDevice::sendMidiMessage(unsigned char a, unsigned char b,
-                                       unsigned char c)
+static bool updateValue(int &current, int value)
 {
-    std::vector<uint8_t> message;
+    if (current == value)
+        return false;
 
-    message.push_back(a);
+    current = value;
+    return true;
+}
 
-    if (b <= 127)
-        message.push_back(b);
+bool MidiOutputDevice::updateChannelState(const std::vector<uint8_t> &data)
+{
+    if (data.size() < 2 || data[0] >= 0xf0)
+        return true;
 
-    if (c <= 127)
-        message.push_back(c);
+    ChannelState &state = myChannelStates[data[0] & 0x0f];
 
-    try
+    switch (data[0] & 0xf0)
     {
-        myMidiOut->sendMessage(&message);
+        case ProgramChange:
+            return updateValue(state.myProgram, data[1]);
+
+        case ControlChange:
+            if (data.size() < 3 || !isStatefulController(data[1]))
+                return true;
+
+            return updateValue(state.myControllers[data[1]], data[2]);
+
+        case PitchWheel:
+            if (data.size() < 3)
+                return true;
+
+            return updateValue(state.myPitchWheel, data[1] | (data[2] << 7));
+
+        default:
+            return true;
     }
-    catch (RtMidiError &e)
+}
+
+bool MidiOutputDevice::sendMessage(const std::vector<uint8_t> &data)
+{
+    if (!updateChannelState(data))
+        return true;
+
+    if (myIsBatching)
     {
-        e.printMessage();
-        return false;
+        myBatch.add(data);
+        return true;
     }
 
-    return true;
+    return myBackend->sendMessage(data);
 }
 
-bool MidiOutputDevice::initialize(size_t preferredApi,
-                                  unsigned int preferredPort)
+void MidiOutputDevice::beginBatch()
 {
-    if (myMidiOut)
-        myMidiOut->closePort(); // Close any open ports.
+    myIsBatching = true;
+}
 
-    if (preferredApi >= myMidiOuts.size())
-        return false;
+bool MidiOutputDevice::endBatch()
+{
+    myIsBatching = false;
+    if (myBatch.empty())
+        return true;
 
-    myMidiOut = myMidiOuts[preferredApi].get();
-    unsigned int num_ports = myMidiOut->getPortCount();
+    const bool success = myBackend->sendMessages(myBatch);
+    myBatch.clear();
+    return success;
+}
 
-    if (num_ports == 0)
-        return false;
+bool MidiOutputDevice::sendMidiMessage(unsigned char a, unsigned char b,
+                                       unsigned char c)
+{
+    myMessage.clear();
 
-    try
-    {
-        myMidiOut->openPort(preferredPort);
-    }
-    catch (RtMidiError &e)
-    {
-        e.printMessage();
-        return false;
-    }
+    myMessage.push_back(a);
 
-    return true;
+    if (b <= 127)
+        myMessage.push_back(b);
+
+    if (c <= 127)
+        myMessage.push_back(c);
+
+    return sendMessage(myMessage);
+}
+
+bool MidiOutputDevice::initialize(size_t preferredApi,
+                                  unsigned int preferredPort)
+{
+    return myBackend->openPort(preferredApi, preferredPort);
 }
 
 size_t MidiOutputDevice::getApiCount()
 {
-    return myMidiOuts.size();
+    return myBackend->getApiCount();
 }
 
 unsigned int MidiOutputDevice::getPortCount(size_t api)
 {
-    assert(api < myMidiOuts.size() && "Programming error, api doesn't exist");
-    return myMidiOuts[api]->getPortCount();
+    return myBackend->getPortCount(api);
 }
 
 std::string MidiOutputDevice::getPortName(size_t api, unsigned int port)
 {
-    assert(api < myMidiOuts.size() && "Programming error, api doesn't exist");
-    return myMidiOuts[api]->getPortName(port);
+    return myBackend->getPortName(api, port);
 }
 
 bool MidiOutputDevice::setPatch(int channel, uint8_t patch)
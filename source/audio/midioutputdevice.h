@@ -25,20 +25,23 @@
 // third parameter is the new value (0-127)
 **/
 
+#include "midioutputbackend.h"
+
 #include <array>
 #include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
-class RtMidiOut;
-
 class MidiOutputDevice
 {
 public:
     static const int NUM_CHANNELS = 16;
 
-    MidiOutputDevice();
+    /// Creates a device which sends messages to the given backend. By default,
+    /// the system MIDI ports are used via RtMidi.
+    explicit MidiOutputDevice(
+        std::shared_ptr<MidiOutputBackend> backend = nullptr);
     ~MidiOutputDevice();
 
     bool initialize(size_t preferredApi, unsigned int preferredPort);
@@ -84,13 +87,42 @@ public:
         AllNotesOff = 123
     };
 
-    void sendMessage(const std::vector<uint8_t> &data);
+    /// Sends a message, unless it would not change the channel's current
+    /// program, controller value, or pitch wheel.
+    bool sendMessage(const std::vector<uint8_t> &data);
+
+    /// Queues messages until endBatch() is called, so that a group of
+    /// messages (e.g. all of the events for a tick) can be sent to the
+    /// backend at once.
+    void beginBatch();
+    /// Sends any queued messages with a single call to the backend.
+    bool endBatch();
 
 private:
     bool sendMidiMessage(unsigned char a, unsigned char b, unsigned char c);
 
-    std::vector<std::unique_ptr<RtMidiOut>> myMidiOuts;
-    RtMidiOut *myMidiOut;
+    /// Updates the tracked channel state for the message.
+    /// @returns False if the message is redundant.
+    bool updateChannelState(const std::vector<uint8_t> &data);
+
+    /// The last values that were sent to a channel, or -1 if unknown.
+    struct ChannelState
+    {
+        ChannelState();
+
+        int myProgram;
+        int myPitchWheel;
+        std::array<int, 128> myControllers;
+    };
+
+    std::shared_ptr<MidiOutputBackend> myBackend;
+    std::array<ChannelState, NUM_CHANNELS> myChannelStates;
+    /// Reused for messages that are built by the device.
+    std::vector<uint8_t> myMessage;
+    bool myIsBatching;
+    /// Messages queued since beginBatch(). The storage is reused between
+    /// batches.
+    MidiMessageBatch myBatch;
     /// Maximum volume for each channel (as set in the mixer).
     std::array<uint8_t, NUM_CHANNELS> myMaxVolumes;
     /// Volume of last active dynamic for each channel.
@@ -17,13 +17,16 @@
 
 #include "midiplayer.h"
 
-#include <app/settingsmanager.h>
+#include <algorithm>
+#include <audio/midioutputbackend.h>
 #include <audio/midioutputdevice.h>
-#include <audio/settings.h>
+#include <audio/playbackmetrics.h>
+#include <audio/playbacksettings.h>
 #include <boost/rational.hpp>
 #include <cassert>
 #include <chrono>
 #include <midi/midifile.h>
+#include <midi/midiseekindex.h>
 #include <score/generalmidi.h>
 #include <score/score.h>
 #include <thread>
@@ -37,20 +40,273 @@ static const int METRONOME_CHANNEL = 9;
 
 using DurationType = std::chrono::duration<int, std::micro>;
 
+static uint64_t packLocation(const SystemLocation &location)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(location.getSystem()))
+            << 32) |
+           static_cast<uint32_t>(location.getPosition());
+}
+
+static SystemLocation unpackLocation(uint64_t packed)
+{
+    return SystemLocation(static_cast<int32_t>(packed >> 32),
+                          static_cast<int32_t>(packed & 0xffffffff));
+}
+
+struct MidiPlayer::Schedule
+{
+    Schedule(const Score &score, const MidiFile::LoadOptions &options);
+
+    /// Finds the performed bar that corresponds to a bar from an older
+    /// schedule, i.e. the same performance of the same bar location. The bars
+    /// before it must be performed in the same order, since otherwise the
+    /// playback position can't be carried over (e.g. if a bar was inserted or
+    /// a repeat was changed before it).
+    /// @returns The index of the bar, the number of bars if the score now
+    /// ends before the bar, or -1 if there is no matching bar.
+    int findMatchingBar(const Schedule &old_schedule,
+                        size_t old_bar_index) const;
+
+    MidiFile myFile;
+    /// The events from all tracks, sorted by their absolute ticks.
+    MidiEventList myEvents;
+    MidiSeekIndex mySeekIndex;
+};
+
+/// Loads the MIDI file and merges the events for each track.
+static MidiEventList loadEvents(MidiFile &file, const Score &score,
+                                const MidiFile::LoadOptions &options)
+{
+    file.load(score, options);
+
+    MidiEventList events;
+    for (MidiEventList &track : file.getTracks())
+    {
+        track.convertToAbsoluteTicks();
+        events.concat(track);
+    }
+
+    // TODO - since each track is already sorted, an n-way merge should be
+    // faster.
+    std::stable_sort(events.begin(), events.end());
+    return events;
+}
+
+MidiPlayer::Schedule::Schedule(const Score &score,
+                               const MidiFile::LoadOptions &options)
+    : myEvents(loadEvents(myFile, score, options)),
+      mySeekIndex(myEvents, myFile.getPerformedBars(),
+                  myFile.getPlaybackOrder())
+{
+}
+
+int MidiPlayer::Schedule::findMatchingBar(const Schedule &old_schedule,
+                                          size_t old_bar_index) const
+{
+    using PerformedBar = MidiFile::PerformedBar;
+    const std::vector<PerformedBar> &bars = myFile.getPerformedBars();
+    const std::vector<PerformedBar> &old_bars =
+        old_schedule.myFile.getPerformedBars();
+
+    auto same_start = [](const PerformedBar &bar1, const PerformedBar &bar2) {
+        return bar1.mySystemIndex == bar2.mySystemIndex &&
+               bar1.myBarStart == bar2.myBarStart;
+    };
+    auto same_bar = [&](const PerformedBar &bar1, const PerformedBar &bar2) {
+        return same_start(bar1, bar2) && bar1.myBarEnd == bar2.myBarEnd;
+    };
+
+    if (bars.size() < old_bar_index ||
+        !std::equal(bars.begin(), bars.begin() + old_bar_index,
+                    old_bars.begin(), same_bar))
+    {
+        return -1;
+    }
+
+    // Since the earlier bars are unchanged, the bar at the same index is the
+    // same performance of the bar.
+    if (bars.size() == old_bar_index)
+        return static_cast<int>(old_bar_index);
+    if (!same_start(bars[old_bar_index], old_bars[old_bar_index]))
+        return -1;
+
+    return static_cast<int>(old_bar_index);
+}
+
+static MidiFile::LoadOptions getLoadOptions(const PlaybackSettings &settings)
+{
+    MidiFile::LoadOptions options;
+    options.myEnableMetronome = true;
+    options.myRecordPositionChanges = true;
+
+    options.myMetronomePreset =
+        settings.myMetronomePreset + Midi::MIDI_PERCUSSION_PRESET_OFFSET;
+    options.myStrongAccentVel = settings.myMetronomeStrongAccent;
+    options.myWeakAccentVel = settings.myMetronomeWeakAccent;
+    options.myVibratoStrength = settings.myVibratoLevel;
+    options.myWideVibratoStrength = settings.myWideVibratoLevel;
+    options.myCurveResolution = settings.myCurveResolution;
+
+    return options;
+}
+
+/// Copies the score so that the events can be generated from another thread.
+/// Scores aren't copyable since they're normally owned by a document.
+static std::shared_ptr<const Score> copyScore(const Score &score)
+{
+    auto copy = std::make_shared<Score>();
+    copy->setScoreInfo(score.getScoreInfo());
+    copy->setLineSpacing(score.getLineSpacing());
+
+    for (const System &system : score.getSystems())
+        copy->insertSystem(system);
+    for (const Player &player : score.getPlayers())
+        copy->insertPlayer(player);
+    for (const Instrument &instrument : score.getInstruments())
+        copy->insertInstrument(instrument);
+    for (const ViewFilter &filter : score.getViewFilters())
+        copy->insertViewFilter(filter);
+
+    return copy;
+}
+
+/// Returns the time signature of the bar containing the location.
+static TimeSignature getTimeSignature(const Score &score,
+                                      const SystemLocation &location)
+{
+    const System &system = score.getSystems()[location.getSystem()];
+    const Barline *barline = system.getPreviousBarline(location.getPosition());
+    if (!barline)
+        barline = &system.getBarlines().front();
+
+    return barline->getTimeSignature();
+}
+
 MidiPlayer::MidiPlayer(SettingsManager &settings_manager,
-                       const ScoreLocation &start_location, int speed)
-    : mySettingsManager(settings_manager),
+                       const ScoreLocation &start_location, int speed,
+                       std::shared_ptr<MidiOutputBackend> backend)
+    : myPlaybackSettings(settings_manager),
       myScore(start_location.getScore()),
       myStartLocation(start_location),
+      myCountInTimeSignature(getTimeSignature(
+          myScore, SystemLocation(start_location.getSystemIndex(),
+                                  start_location.getPositionIndex()))),
+      myMetrics(std::make_shared<PlaybackMetrics>()),
+      myIsGenerating(false),
+      myHasPendingSchedule(false),
       myIsPlaying(false),
-      myPlaybackSpeed(speed)
+      myPlaybackSpeed(speed),
+      myBackend(std::move(backend)),
+      myLoopEnabled(false),
+      myPlaybackLocation(packLocation(
+          SystemLocation(start_location.getSystemIndex(),
+                         start_location.getPositionIndex()))),
+      myLocationChangeCount(0)
 {
+    const auto start_time = PlaybackMetrics::Clock::now();
+    mySchedule = std::make_shared<const Schedule>(
+        myScore, getLoadOptions(myPlaybackSettings.get()));
+    myMetrics->recordGenerationTime(PlaybackMetrics::Clock::now() -
+                                    start_time);
+}
+
+/// Copies the events for the performed bars between the start and end of the
+/// loop, with ticks relative to the start of the loop. A marker event is added
+/// at the end so that each pass starts exactly one loop length after the
+/// previous pass.
+static bool extractLoopEvents(const MidiEventList &events,
+                              const std::vector<MidiFile::PerformedBar> &bars,
+                              const PlaybackOrder &order,
+                              const SystemLocation &loop_start,
+                              const SystemLocation &loop_end,
+                              MidiEventList &loop_events, int &loop_bar_start)
+{
+    const int first_index = order.findFirstPerformance(loop_start);
+    if (first_index < 0)
+        return false;
+
+    auto first_bar = bars.begin() + first_index;
+    auto last_bar = std::find_if(
+        first_bar, bars.end(), [&](const MidiFile::PerformedBar &bar) {
+            return bar.mySystemIndex == loop_end.getSystem() &&
+                   bar.myBarStart <= loop_end.getPosition() &&
+                   loop_end.getPosition() < bar.myBarEnd;
+        });
+    if (last_bar == bars.end() || events.size() == 0)
+        return false;
+
+    const int start_tick = first_bar->myStartTick;
+    const int end_tick = (std::next(last_bar) != bars.end())
+                             ? std::next(last_bar)->myStartTick
+                             : std::prev(events.end())->getTicks();
+
+    auto by_ticks = [](const MidiEvent &event, int ticks) {
+        return event.getTicks() < ticks;
+    };
+    auto begin =
+        std::lower_bound(events.begin(), events.end(), start_tick, by_ticks);
+
+    // The notes which have been started in the loop but not stopped yet.
+    std::vector<const MidiEvent *> active_notes;
+    auto find_active_note = [&](const MidiEvent &note_off) {
+        return std::find_if(
+            active_notes.begin(), active_notes.end(),
+            [&](const MidiEvent *note_on) {
+                return note_on->getChannel() == note_off.getChannel() &&
+                       note_on->getData()[1] == note_off.getData()[1];
+            });
+    };
+
+    for (auto event = begin; event != events.end(); ++event)
+    {
+        if (event->getTicks() > end_tick)
+            break;
+
+        const uint8_t status = event->getStatusByte() & 0xf0;
+        const bool is_note_off =
+            status == MidiEvent::NoteOff ||
+            (status == MidiEvent::NoteOn && event->getData()[2] == 0);
+
+        // Include the note off events for notes that end with the loop.
+        if (event->getTicks() == end_tick && !is_note_off)
+            continue;
+
+        if (is_note_off)
+        {
+            auto note_on = find_active_note(*event);
+            if (note_on != active_notes.end())
+                active_notes.erase(note_on);
+        }
+        else if (status == MidiEvent::NoteOn)
+            active_notes.push_back(&*event);
+
+        MidiEvent loop_event(*event);
+        loop_event.setTicks(event->getTicks() - start_tick);
+        loop_events.append(std::move(loop_event));
+    }
+
+    // Notes that are held past the end of the loop (e.g. tied or let ring
+    // notes) are stopped when the loop wraps around, rather than hanging.
+    for (const MidiEvent *note_on : active_notes)
+    {
+        loop_events.append(MidiEvent::noteOff(
+            end_tick - start_tick, note_on->getChannel(),
+            note_on->getData()[1], note_on->getLocation()));
+    }
+
+    loop_events.append(MidiEvent::endOfTrack(end_tick - start_tick));
+    loop_bar_start = first_bar->myBarStart;
+    return true;
 }
 
 MidiPlayer::~MidiPlayer()
 {
     setIsPlaying(false);
     wait();
+
+    // The background task refers to the player.
+    if (myGenerationTask.valid())
+        myGenerationTask.wait();
 }
 
 void MidiPlayer::run()
@@ -64,58 +320,43 @@ void MidiPlayer::run()
     });
 #endif
 
-    boost::signals2::scoped_connection connection(
-        mySettingsManager.subscribeToChanges([&]() {
-            auto settings = mySettingsManager.getReadHandle();
-            myMetronomeEnabled = settings->get(Settings::MetronomeEnabled);
-        }));
-
     setIsPlaying(true);
 
-    MidiFile::LoadOptions options;
-    options.myEnableMetronome = true;
-    options.myRecordPositionChanges = true;
-
     // Load MIDI settings.
-    int api;
-    int port;
-    {
-        auto settings = mySettingsManager.getReadHandle();
-        myMetronomeEnabled = settings->get(Settings::MetronomeEnabled);
-
-        api = settings->get(Settings::MidiApi);
-        port = settings->get(Settings::MidiPort);
-
-        options.myMetronomePreset = settings->get(Settings::MetronomePreset) +
-                                    Midi::MIDI_PERCUSSION_PRESET_OFFSET;
-        options.myStrongAccentVel =
-            settings->get(Settings::MetronomeStrongAccent);
-        options.myWeakAccentVel = settings->get(Settings::MetronomeWeakAccent);
-        options.myVibratoStrength = settings->get(Settings::MidiVibratoLevel);
-        options.myWideVibratoStrength =
-            settings->get(Settings::MidiWideVibratoLevel);
-    }
-
-    MidiFile file;
-    file.load(myScore, options);
-
-    const int ticks_per_beat = file.getTicksPerBeat();
+    const PlaybackSettings &settings = myPlaybackSettings.get();
+    const int api = settings.myMidiApi;
+    const int port = settings.myMidiPort;
+
+    std::shared_ptr<const Schedule> schedule = mySchedule;
+    const int ticks_per_beat = schedule->myFile.getTicksPerBeat();
+
+    SystemLocation start_location(myStartLocation.getSystemIndex(),
+                                  myStartLocation.getPositionIndex());
+
+    // In loop mode, the events for the loop are extracted once and then
+    // replayed for each pass.
+    MidiEventList loop_events;
+    auto extract_loop = [&](const Schedule &source) {
+        MidiEventList new_loop_events;
+        int loop_bar_start = 0;
+        if (!extractLoopEvents(source.myEvents, source.myFile.getPerformedBars(),
+                               source.myFile.getPlaybackOrder(), myLoopStart,
+                               myLoopEnd, new_loop_events, loop_bar_start))
+        {
+            return false;
+        }
 
-    // Merge the MIDI evvents for each track.
-    MidiEventList events;
-    for (MidiEventList &track : file.getTracks())
-    {
-        track.convertToAbsoluteTicks();
-        events.concat(track);
-    }
+        loop_events = std::move(new_loop_events);
+        start_location = SystemLocation(myLoopStart.getSystem(), loop_bar_start);
+        return true;
+    };
 
-    // TODO - since each track is already sorted, an n-way merge should be
-    // faster.
-    std::stable_sort(events.begin(), events.end());
-    events.convertToDeltaTicks();
+    const bool looping = myLoopEnabled && extract_loop(*schedule);
+    const MidiEventList *events =
+        looping ? &loop_events : &schedule->myEvents;
 
-    // Initialize RtMidi and set the port.
-    MidiOutputDevice device;
+    // Initialize the output device and set the port.
+    MidiOutputDevice device(myBackend);
     if (!device.initialize(api, port))
     {
         emit error(tr("Error initializing MIDI output device."));
@@ -124,125 +365,309 @@ void MidiPlayer::run()
 
     bool started = false;
     Midi::Tempo beat_duration = Midi::BEAT_DURATION_120_BPM;
-    const SystemLocation start_location(myStartLocation.getSystemIndex(),
-                                        myStartLocation.getPositionIndex());
     SystemLocation current_location = start_location;
 
+    // Jump to the start of the bar containing the start location, and restore
+    // the channel state from that point rather than replaying every event
+    // before it.
+    auto first_event = events->begin();
+    const MidiSeekIndex::Snapshot *snapshot =
+        schedule->mySeekIndex.findSnapshot(start_location);
+    if (snapshot && !looping)
+        first_event += snapshot->myEventIndex;
+
+    auto by_ticks = [](const MidiEvent &event, int ticks) {
+        return event.getTicks() < ticks;
+    };
+
     DurationType clock_drift(0);
 
-    for (auto event = events.begin(); event != events.end(); ++event)
-    {
-        if (!isPlaying())
-            break;
+    // The time when the current event should be sent, which is used to
+    // measure how late each event actually is.
+    PlaybackMetrics::Clock::time_point scheduled_time;
 
-        if (event->isTempoChange())
-            beat_duration = event->getTempo();
+    // The time to the first note is recorded once its message has actually
+    // been sent to the device.
+    bool first_note_queued = false;
+    bool first_note_recorded = false;
+    // The number of messages sent in the current batch.
+    uint64_t num_messages = 0;
 
-        // Skip note on / off events before the start location, but send events
-        // such as instrument changes, pitch wheels, etc.
-        // Tempo changes are tracked above and shouldn't be sent out since
-        // CoreMidi on OSX complains about them.
-        if (!started)
+    do
+    {
+        // If the score was edited, switch to the new events for the loop
+        // before starting the next pass.
+        if (looping && started)
         {
-            if (event->getLocation() < start_location)
+            std::shared_ptr<const Schedule> pending = takePendingSchedule();
+            if (pending && extract_loop(*pending))
             {
-                if (!event->isNoteOnOff() && !event->isTempoChange())
-                    device.sendMessage(event->getData());
-
-                continue;
+                schedule = std::move(pending);
+                snapshot = schedule->mySeekIndex.findSnapshot(start_location);
+                first_event = events->begin();
             }
-            else
-            {
-                performCountIn(device, event->getLocation(), beat_duration);
+        }
 
-                started = true;
+        if (snapshot)
+        {
+            for (const std::vector<uint8_t> &message :
+                 snapshot->getRestoreMessages())
+            {
+                device.sendMessage(message);
             }
+
+            beat_duration = snapshot->myTempo;
         }
 
-        auto start_timestamp = std::chrono::high_resolution_clock::now();
-
-        const int delta = event->getTicks();
-        assert(delta >= 0);
-
-		// Compute the time in microseconds that we should sleep for, and then
-        // adjust for accumulated timing errors (since sleep_for() is not
-        // perfectly precise).
-        auto sleep_duration = DurationType(static_cast<int64_t>(
-            boost::rational_cast<int64_t>(
-                boost::rational<int64_t>(delta, ticks_per_beat) *
-                beat_duration.count()) *
-            (100.0 / myPlaybackSpeed)));
-
-        auto error_correction = std::min(sleep_duration, clock_drift);
-        clock_drift -= error_correction;
-        sleep_duration -= error_correction;
-
-        if (sleep_duration.count() != 0)
-            std::this_thread::sleep_for(sleep_duration);
-
-        // Don't play metronome events if the metronome is disabled.
-        // Tempo change events also don't need to be sent since they are
-        // handled in this loop. CoreMidi on OSX also complains about them.
-        // Similarly, ALSA complains about the meta "track end" events.
-        if (!(event->isNoteOnOff() &&
-              event->getChannel() == METRONOME_CHANNEL &&
-              !myMetronomeEnabled) &&
-            !event->isTempoChange() && !event->isTrackEnd())
+        // When looping, move the caret back to the start of the loop. Changes
+        // to the playback speed are applied at the start of each pass.
+        if (started)
         {
-            device.sendMessage(event->getData());
+            publishLocation(start_location);
+            current_location = start_location;
         }
 
-        // Notify listeners of the current playback position.
-        if (event->getLocation() != current_location)
+        const int pass_speed = myPlaybackSpeed;
+
+        // The tick of the previous event, which the delay before each event
+        // is measured from.
+        int current_tick =
+            (first_event != events->begin()) ? std::prev(first_event)->getTicks()
+                                             : 0;
+
+        // When the score is edited during playback, the new events are
+        // spliced in at the start of the next bar. The bar currently being
+        // played is unaffected.
+        std::shared_ptr<const Schedule> pending;
+        size_t splice_bar = 0;
+        std::vector<std::vector<uint8_t>> splice_messages;
+
+        for (auto event = first_event; event != events->end(); ++event)
         {
-            const SystemLocation &new_location = event->getLocation();
+            if (!isPlaying())
+                break;
 
-            // Don't move backwards unless a repeat occurred.
-            if (new_location >= current_location || event->isPositionChange())
+            if (started && !looping)
             {
-                if (new_location.getSystem() != current_location.getSystem())
-                    emit playbackSystemChanged(new_location.getSystem());
+                const auto &bars = schedule->myFile.getPerformedBars();
+                if (!pending && (pending = takePendingSchedule()))
+                {
+                    splice_bar = std::upper_bound(
+                                     bars.begin(), bars.end(), current_tick,
+                                     [](int tick,
+                                        const MidiFile::PerformedBar &bar) {
+                                         return tick < bar.myStartTick;
+                                     }) -
+                                 bars.begin();
+
+                    // Edits have no effect if the last bar is being played.
+                    if (splice_bar >= bars.size())
+                        pending.reset();
+                }
+
+                // Ignore edits that changed the bars which were already
+                // played, since the playback position can't be carried over.
+                if (pending &&
+                    event->getTicks() >= bars[splice_bar].myStartTick &&
+                    pending->findMatchingBar(*schedule, splice_bar) < 0)
+                {
+                    pending.reset();
+                }
+
+                if (pending &&
+                    event->getTicks() >= bars[splice_bar].myStartTick)
+                {
+                    const int old_tick = bars[splice_bar].myStartTick;
+
+                    // Finish the notes that end at the bar line.
+                    for (auto it = event;
+                         it != events->end() && it->getTicks() == old_tick; ++it)
+                    {
+                        if ((it->getStatusByte() & 0xf0) == MidiEvent::NoteOff)
+                            splice_messages.push_back(it->getData());
+                    }
+
+                    schedule = std::move(pending);
+                    events = &schedule->myEvents;
+
+                    // The bars before the splice point are unchanged, so the
+                    // bar has the same index in the new schedule.
+                    const auto &new_bars = schedule->myFile.getPerformedBars();
+                    if (splice_bar >= new_bars.size())
+                    {
+                        for (const std::vector<uint8_t> &message :
+                             splice_messages)
+                        {
+                            device.sendMessage(message);
+                        }
+                        break;
+                    }
+
+                    const int new_tick = new_bars[splice_bar].myStartTick;
+                    current_tick += new_tick - old_tick;
+                    event = std::lower_bound(events->begin(), events->end(),
+                                             new_tick, by_ticks);
+
+                    // Restore the channel state in case an earlier bar was
+                    // edited (e.g. an instrument change).
+                    if (const MidiSeekIndex::Snapshot *bar_snapshot =
+                            schedule->mySeekIndex.getBarSnapshot(splice_bar))
+                    {
+                        for (std::vector<uint8_t> &message :
+                             bar_snapshot->getRestoreMessages())
+                        {
+                            splice_messages.push_back(std::move(message));
+                        }
+
+                        beat_duration = bar_snapshot->myTempo;
+                    }
+
+                    if (event == events->end())
+                        break;
+                }
+            }
 
-                emit playbackPositionChanged(new_location.getPosition());
+            if (event->isTempoChange())
+                beat_duration = event->getTempo();
 
-                current_location = new_location;
+            // Skip note on / off events before the start location, but send
+            // events such as instrument changes, pitch wheels, etc.
+            // Tempo changes are tracked above and shouldn't be sent out since
+            // CoreMidi on OSX complains about them.
+            if (!started)
+            {
+                if (event->getLocation() < start_location)
+                {
+                    if (!event->isNoteOnOff() && !event->isTempoChange())
+                        device.sendMessage(event->getData());
+
+                    current_tick = event->getTicks();
+                    continue;
+                }
+                else
+                {
+                    const auto count_in_start = PlaybackMetrics::Clock::now();
+                    performCountIn(device, beat_duration);
+
+                    scheduled_time = PlaybackMetrics::Clock::now();
+                    myMetrics->recordCountIn(scheduled_time - count_in_start);
+
+                    started = true;
+                }
             }
-        }
 
-        // Accumulate any difference between the desired delta time and what
-        // actually happened.
-        auto end_timestamp = std::chrono::high_resolution_clock::now();
-        auto actual_duration = std::chrono::duration_cast<DurationType>(
-            end_timestamp - start_timestamp);
-        clock_drift += actual_duration - sleep_duration;
-    }
+            const auto start_timestamp = PlaybackMetrics::Clock::now();
+
+            const int delta = event->getTicks() - current_tick;
+            assert(delta >= 0);
+            current_tick = event->getTicks();
+
+            // Compute the time in microseconds that we should sleep for, and
+            // then adjust for accumulated timing errors (since sleep_for() is
+            // not perfectly precise).
+            const int speed = looping ? pass_speed : myPlaybackSpeed.load();
+            auto sleep_duration = DurationType(static_cast<int64_t>(
+                boost::rational_cast<int64_t>(
+                    boost::rational<int64_t>(delta, ticks_per_beat) *
+                    beat_duration.count()) *
+                (100.0 / speed)));
+            scheduled_time += sleep_duration;
+
+            auto error_correction = std::min(sleep_duration, clock_drift);
+            clock_drift -= error_correction;
+            sleep_duration -= error_correction;
+            if (error_correction.count() > 0)
+                myMetrics->recordDriftCorrection(error_correction);
+
+            if (sleep_duration.count() != 0)
+                std::this_thread::sleep_for(sleep_duration);
+
+            myMetrics->recordLateness(PlaybackMetrics::Clock::now() -
+                                      scheduled_time);
+
+            // The messages for all of the events at this tick are sent to the
+            // device together.
+            device.beginBatch();
+
+            num_messages += splice_messages.size();
+            for (const std::vector<uint8_t> &message : splice_messages)
+                device.sendMessage(message);
+            splice_messages.clear();
+
+            // Don't play metronome events if the metronome is disabled.
+            // Tempo change events also don't need to be sent since they are
+            // handled in this loop. CoreMidi on OSX also complains about them.
+            // Similarly, ALSA complains about the meta "track end" events.
+            if (!(event->isNoteOnOff() &&
+                  event->getChannel() == METRONOME_CHANNEL &&
+                  !myPlaybackSettings.get().myMetronomeEnabled) &&
+                !event->isTempoChange() && !event->isTrackEnd())
+            {
+                device.sendMessage(event->getData());
+                ++num_messages;
+
+                if (!first_note_recorded &&
+                    (event->getStatusByte() & 0xf0) == MidiEvent::NoteOn &&
+                    event->getData()[2] != 0)
+                {
+                    first_note_queued = true;
+                }
+            }
+
+            // Publish the current playback position.
+            if (event->getLocation() != current_location)
+            {
+                const SystemLocation &new_location = event->getLocation();
+
+                // Don't move backwards unless a repeat occurred.
+                if (new_location >= current_location ||
+                    event->isPositionChange())
+                {
+                    publishLocation(new_location);
+                    current_location = new_location;
+                }
+            }
+
+            auto next_event = std::next(event);
+            if (next_event == events->end() ||
+                next_event->getTicks() != event->getTicks())
+            {
+                device.endBatch();
+
+                if (first_note_queued && !first_note_recorded)
+                {
+                    myMetrics->recordFirstNote(PlaybackMetrics::Clock::now());
+                    first_note_recorded = true;
+                }
+
+                myMetrics->recordMessages(num_messages,
+                                          PlaybackMetrics::Clock::now());
+                num_messages = 0;
+            }
+
+            // Accumulate any difference between the desired delta time and
+            // what actually happened.
+            const auto end_timestamp = PlaybackMetrics::Clock::now();
+            auto actual_duration = std::chrono::duration_cast<DurationType>(
+                end_timestamp - start_timestamp);
+            clock_drift += actual_duration - sleep_duration;
+        }
+    } while (looping && isPlaying());
 }
 
 void MidiPlayer::performCountIn(MidiOutputDevice &device,
-                                const SystemLocation &location,
                                 Midi::Tempo beat_duration)
 {
     // Load preferences.
-    uint8_t velocity;
-    uint8_t preset;
-    {
-        auto settings = mySettingsManager.getReadHandle();
-
-        if (!settings->get(Settings::CountInEnabled))
-            return;
-
-        velocity = settings->get(Settings::CountInVolume);
-        preset = settings->get(Settings::CountInPreset) +
-                 Midi::MIDI_PERCUSSION_PRESET_OFFSET;
-    }
+    const PlaybackSettings &settings = myPlaybackSettings.get();
+    if (!settings.myCountInEnabled)
+        return;
 
-    // Figure out the time signature where playback is starting.
-    const System &system = myScore.getSystems()[location.getSystem()];
-    const Barline *barline = system.getPreviousBarline(location.getPosition());
-    if (!barline)
-        barline = &system.getBarlines().front();
+    const uint8_t velocity = settings.myCountInVolume;
+    const uint8_t preset =
+        settings.myCountInPreset + Midi::MIDI_PERCUSSION_PRESET_OFFSET;
 
-    const TimeSignature &time_sig = barline->getTimeSignature();
+    const TimeSignature &time_sig = myCountInTimeSignature;
 
     const auto tick_duration = DurationType(static_cast<int64_t>(
         boost::rational_cast<int64_t>(
@@ -267,11 +692,101 @@ void MidiPlayer::performCountIn(MidiOutputDevice &device,
     }
 }
 
+void MidiPlayer::setLoopRange(const SystemLocation &start,
+                              const SystemLocation &end)
+{
+    myLoopEnabled = true;
+    myLoopStart = start;
+    myLoopEnd = end;
+    myCountInTimeSignature = getTimeSignature(myScore, start);
+}
+
 void MidiPlayer::changePlaybackSpeed(int new_speed)
 {
     myPlaybackSpeed = new_speed;
 }
 
+void MidiPlayer::updateScore()
+{
+    const MidiFile::LoadOptions options =
+        getLoadOptions(myPlaybackSettings.get());
+
+    if (!isRunning())
+    {
+        const auto start_time = PlaybackMetrics::Clock::now();
+        mySchedule = std::make_shared<const Schedule>(myScore, options);
+        myMetrics->recordGenerationTime(PlaybackMetrics::Clock::now() -
+                                        start_time);
+        return;
+    }
+
+    // Generating the events for a large score is slow, so this is done in the
+    // background from a copy of the score rather than blocking the thread
+    // that owns the score.
+    std::shared_ptr<const Score> score = copyScore(myScore);
+
+    std::lock_guard<std::mutex> lock(myPendingScheduleMutex);
+    myPendingScore = std::move(score);
+    myPendingOptions = options;
+
+    if (!myIsGenerating)
+    {
+        myIsGenerating = true;
+        myGenerationTask = std::async(std::launch::async,
+                                      [this]() { generatePendingSchedules(); });
+    }
+}
+
+void MidiPlayer::waitForScoreUpdate()
+{
+    std::unique_lock<std::mutex> lock(myPendingScheduleMutex);
+    myGenerationFinished.wait(lock, [this]() { return !myIsGenerating; });
+}
+
+void MidiPlayer::generatePendingSchedules()
+{
+    while (true)
+    {
+        std::shared_ptr<const Score> score;
+        MidiFile::LoadOptions options;
+        {
+            // If there are several edits while the events are being
+            // generated, only the most recent copy of the score is used.
+            std::lock_guard<std::mutex> lock(myPendingScheduleMutex);
+            if (!myPendingScore)
+            {
+                myIsGenerating = false;
+                myGenerationFinished.notify_all();
+                return;
+            }
+
+            score = std::move(myPendingScore);
+            options = myPendingOptions;
+        }
+
+        const auto start_time = PlaybackMetrics::Clock::now();
+        auto schedule = std::make_shared<const Schedule>(*score, options);
+        myMetrics->recordGenerationTime(PlaybackMetrics::Clock::now() -
+                                        start_time);
+
+        // If there are several edits before the playback thread reaches the
+        // next bar, only the most recent events are used.
+        std::lock_guard<std::mutex> lock(myPendingScheduleMutex);
+        myPendingSchedule = std::move(schedule);
+        myHasPendingSchedule = true;
+    }
+}
+
+std::shared_ptr<const MidiPlayer::Schedule> MidiPlayer::takePendingSchedule()
+{
+    if (!myHasPendingSchedule.load(std::memory_order_acquire))
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(myPendingScheduleMutex);
+    myHasPendingSchedule = false;
+    return std::move(myPendingSchedule);
+}
+
 void MidiPlayer::setIsPlaying(bool set)
 {
     myIsPlaying = set;
@@ -281,3 +796,26 @@ bool MidiPlayer::isPlaying() const
 {
     return myIsPlaying;
 }
+
+SystemLocation MidiPlayer::getPlaybackLocation() const
+{
+    return unpackLocation(myPlaybackLocation.load(std::memory_order_acquire));
+}
+
+uint64_t MidiPlayer::getLocationChangeCount() const
+{
+    return myLocationChangeCount.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const PlaybackMetrics> MidiPlayer::getMetrics() const
+{
+    return myMetrics;
+}
+
+void MidiPlayer::publishLocation(const SystemLocation &location)
+{
+    // The location is stored before the count is incremented, so a reader
+    // that sees the new count will also see (at least) the new location.
+    myPlaybackLocation.store(packLocation(location), std::memory_order_release);
+    myLocationChangeCount.fetch_add(1, std::memory_order_release);
+}
@@ -19,53 +19,133 @@
 #define AUDIO_MIDIPLAYER_H
 
 #include <atomic>
+#include <audio/playbacksettings.h>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <QThread>
 #include <midi/midievent.h>
+#include <midi/midifile.h>
 #include <score/scorelocation.h>
+#include <score/systemlocation.h>
+#include <score/timesignature.h>
 
-class MidiFile;
+class MidiOutputBackend;
 class MidiOutputDevice;
+class PlaybackMetrics;
 class Score;
 class SettingsManager;
-class SystemLocation;
 
 class MidiPlayer : public QThread
 {
     Q_OBJECT
 
 public:
+    /// By default, the MIDI port from the settings is used for output, but
+    /// a different backend can be provided (e.g. for testing).
     MidiPlayer(SettingsManager &settings_manager,
-               const ScoreLocation &start_location, int speed);
+               const ScoreLocation &start_location, int speed,
+               std::shared_ptr<MidiOutputBackend> backend = nullptr);
     ~MidiPlayer();
 
+    /// Repeatedly plays the bars containing the start and end locations (and
+    /// any bars in between) until playback is stopped. The count-in is only
+    /// performed before the first pass. This must be called before the
+    /// player is started.
+    void setLoopRange(const SystemLocation &start, const SystemLocation &end);
+
     void changePlaybackSpeed(int new_speed);
 
+    /// Regenerates the MIDI events after the score has been edited. This must
+    /// be called from the thread that owns the score. During playback, the
+    /// score is copied and the events are generated in the background. The
+    /// new events replace the scheduled events at the start of the next bar
+    /// (or the next pass of the loop), without restarting playback. Edits
+    /// that change the bars which have already been played (e.g. inserting a
+    /// bar or changing a repeat before the playback location) are ignored.
+    void updateScore();
+
+    /// Blocks until the events for the most recent call to updateScore() have
+    /// been generated.
+    void waitForScoreUpdate();
+
     const ScoreLocation &getStartLocation() const { return myStartLocation; }
 
+    /// Returns the location that is currently being played. Rather than
+    /// sending a notification for every change, the player publishes the
+    /// latest location so that it can be polled from another thread (e.g. by
+    /// the GUI once per display refresh).
+    SystemLocation getPlaybackLocation() const;
+
+    /// Returns the number of times that the playback location has changed.
+    /// A reader can compare this with the number of changes that it observed
+    /// to find how many updates were merged between polls.
+    uint64_t getLocationChangeCount() const;
+
+    /// Returns the timing measurements for this playback, which are updated
+    /// by the MIDI thread while playing and remain valid after the player is
+    /// destroyed.
+    std::shared_ptr<const PlaybackMetrics> getMetrics() const;
+
 signals:
-    // These signals are used to move the caret when a position change is
-    // necessary
-    void playbackSystemChanged(int system);
-    void playbackPositionChanged(int position);
     void error(const QString &msg);
 
 private:
+    /// The merged MIDI events for the score, which are not modified once
+    /// they have been generated.
+    struct Schedule;
+
     virtual void run() override;
 
-    void performCountIn(MidiOutputDevice &device,
-                        const SystemLocation &location,
-                        Midi::Tempo beat_duration);
+    void performCountIn(MidiOutputDevice &device, Midi::Tempo beat_duration);
+
+    /// Generates the events for the pending copies of the score, until there
+    /// are none left. This runs in a background task.
+    void generatePendingSchedules();
+
+    /// Returns the events that were generated by the most recent call to
+    /// updateScore(), or null if there are none.
+    std::shared_ptr<const Schedule> takePendingSchedule();
 
     void setIsPlaying(bool set);
     bool isPlaying() const;
 
-    SettingsManager &mySettingsManager;
+    void publishLocation(const SystemLocation &location);
+
+    /// Snapshot of the settings, which is updated if the settings are changed
+    /// during playback (e.g. toggling the metronome).
+    PlaybackSettingsPublisher myPlaybackSettings;
     const Score &myScore;
     ScoreLocation myStartLocation;
+    /// The time signature for the count-in. This is found when the player is
+    /// created, since the score may be edited during playback.
+    TimeSignature myCountInTimeSignature;
+    std::shared_ptr<PlaybackMetrics> myMetrics;
+    std::shared_ptr<const Schedule> mySchedule;
+    std::mutex myPendingScheduleMutex;
+    /// The most recent copy of the score that the events haven't been
+    /// generated for yet, and the options to generate them with.
+    std::shared_ptr<const Score> myPendingScore;
+    MidiFile::LoadOptions myPendingOptions;
+    /// Set while the background task is generating events.
+    bool myIsGenerating;
+    std::condition_variable myGenerationFinished;
+    std::future<void> myGenerationTask;
+    std::shared_ptr<const Schedule> myPendingSchedule;
+    std::atomic<bool> myHasPendingSchedule;
     std::atomic<bool> myIsPlaying;
-    std::atomic<bool> myMetronomeEnabled;
     /// The current playback speed (percent).
     std::atomic<int> myPlaybackSpeed;
+    std::shared_ptr<MidiOutputBackend> myBackend;
+    bool myLoopEnabled;
+    SystemLocation myLoopStart;
+    SystemLocation myLoopEnd;
+    /// The system and position indices of the playback location, packed into
+    /// a single word so that they are always read consistently.
+    std::atomic<uint64_t> myPlaybackLocation;
+    std::atomic<uint64_t> myLocationChangeCount;
 };
 
 #endif
@@ -0,0 +1,141 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "playbackmetrics.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+using Microseconds = std::chrono::microseconds;
+
+static int64_t toMicroseconds(PlaybackMetrics::Clock::duration duration)
+{
+    return std::chrono::duration_cast<Microseconds>(duration).count();
+}
+
+PlaybackMetrics::PlaybackMetrics(Clock::time_point creation_time)
+    : myCreationTime(creation_time),
+      myGenerationTime(0),
+      myCountInTime(0),
+      myTimeToFirstNote(-1),
+      myLatenessCount(0),
+      myDriftCorrections(0),
+      myDriftCorrectionTotal(0),
+      myHasFirstNote(false),
+      myMessageCount(0),
+      myMessageTime(0)
+{
+    for (std::atomic<int32_t> &sample : myLateness)
+        sample.store(0, std::memory_order_relaxed);
+}
+
+void PlaybackMetrics::recordGenerationTime(Clock::duration duration)
+{
+    myGenerationTime.store(toMicroseconds(duration), std::memory_order_relaxed);
+}
+
+void PlaybackMetrics::recordCountIn(Clock::duration duration)
+{
+    myCountInTime.store(toMicroseconds(duration), std::memory_order_relaxed);
+}
+
+void PlaybackMetrics::recordFirstNote(Clock::time_point time)
+{
+    myFirstNoteTime = time;
+    myHasFirstNote = true;
+    myTimeToFirstNote.store(toMicroseconds(time - myCreationTime) -
+                                myCountInTime.load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+}
+
+void PlaybackMetrics::recordLateness(Clock::duration lateness)
+{
+    const int64_t value = std::clamp<int64_t>(
+        toMicroseconds(lateness), std::numeric_limits<int32_t>::min(),
+        std::numeric_limits<int32_t>::max());
+
+    // Write the sample before publishing the new count, so that a reader
+    // never sees a sample slot that hasn't been written yet.
+    const uint64_t count = myLatenessCount.load(std::memory_order_relaxed);
+    myLateness[count % HISTORY_SIZE].store(static_cast<int32_t>(value),
+                                           std::memory_order_relaxed);
+    myLatenessCount.store(count + 1, std::memory_order_release);
+}
+
+void PlaybackMetrics::recordDriftCorrection(Clock::duration correction)
+{
+    myDriftCorrections.fetch_add(1, std::memory_order_relaxed);
+    myDriftCorrectionTotal.fetch_add(toMicroseconds(correction),
+                                     std::memory_order_relaxed);
+}
+
+void PlaybackMetrics::recordMessages(uint64_t count, Clock::time_point time)
+{
+    if (!myHasFirstNote)
+        return;
+
+    myMessageCount.fetch_add(count, std::memory_order_relaxed);
+    myMessageTime.store(toMicroseconds(time - myFirstNoteTime),
+                        std::memory_order_relaxed);
+}
+
+PlaybackMetrics::Summary PlaybackMetrics::getSummary() const
+{
+    Summary summary;
+    summary.myGenerationTime = myGenerationTime.load(std::memory_order_relaxed);
+    summary.myTimeToFirstNote =
+        myTimeToFirstNote.load(std::memory_order_relaxed);
+    summary.myDriftCorrections =
+        myDriftCorrections.load(std::memory_order_relaxed);
+    summary.myDriftCorrectionTotal =
+        myDriftCorrectionTotal.load(std::memory_order_relaxed);
+
+    summary.myMessageCount = myMessageCount.load(std::memory_order_relaxed);
+    const int64_t message_time = myMessageTime.load(std::memory_order_relaxed);
+    if (message_time > 0)
+    {
+        summary.myMessagesPerSecond =
+            summary.myMessageCount * 1e6 / static_cast<double>(message_time);
+    }
+
+    // Samples may be overwritten while they are being copied, but that only
+    // replaces an old sample with a newer one.
+    const uint64_t count = myLatenessCount.load(std::memory_order_acquire);
+    const size_t num_samples =
+        static_cast<size_t>(std::min<uint64_t>(count, HISTORY_SIZE));
+    if (num_samples == 0)
+        return summary;
+
+    std::vector<int32_t> samples;
+    samples.reserve(num_samples);
+    for (size_t i = 0; i < num_samples; ++i)
+        samples.push_back(myLateness[i].load(std::memory_order_relaxed));
+    std::sort(samples.begin(), samples.end());
+
+    auto percentile = [&](int p) -> int64_t {
+        return samples[(samples.size() - 1) * p / 100];
+    };
+
+    summary.mySampleCount = num_samples;
+    summary.myLatenessP50 = percentile(50);
+    summary.myLatenessP95 = percentile(95);
+    summary.myLatenessP99 = percentile(99);
+    summary.myLatenessMax = samples.back();
+    return summary;
+}
@@ -0,0 +1,110 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AUDIO_PLAYBACKMETRICS_H
+#define AUDIO_PLAYBACKMETRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// Timing measurements for a single playback. The MIDI thread records the
+/// measurements without locking, and they can be read at any time from
+/// another thread (e.g. to display diagnostics in the GUI).
+class PlaybackMetrics
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// The number of recent lateness samples that are kept.
+    static constexpr size_t HISTORY_SIZE = 4096;
+
+    struct Summary
+    {
+        /// Time taken to generate the events for the score (microseconds).
+        int64_t myGenerationTime = 0;
+        /// Time from the player being created until the first note was sent,
+        /// excluding the count-in (microseconds), or -1 if no notes have been
+        /// played yet.
+        int64_t myTimeToFirstNote = -1;
+
+        /// The number of lateness samples in the history.
+        size_t mySampleCount = 0;
+        /// Percentiles of how late events were sent, compared to when they
+        /// were scheduled (microseconds), over the recent history.
+        int64_t myLatenessP50 = 0;
+        int64_t myLatenessP95 = 0;
+        int64_t myLatenessP99 = 0;
+        int64_t myLatenessMax = 0;
+
+        /// The number of times that an event's delay was shortened to make up
+        /// for accumulated timing errors, and the total time corrected.
+        uint64_t myDriftCorrections = 0;
+        int64_t myDriftCorrectionTotal = 0;
+
+        uint64_t myMessageCount = 0;
+        double myMessagesPerSecond = 0;
+    };
+
+    /// The creation time is used as the start for the time-to-first-note.
+    explicit PlaybackMetrics(Clock::time_point creation_time = Clock::now());
+
+    PlaybackMetrics(const PlaybackMetrics &) = delete;
+    PlaybackMetrics &operator=(const PlaybackMetrics &) = delete;
+
+    /// Records the time taken by the most recent generation of the events.
+    /// This may be called from a different thread than the MIDI thread.
+    void recordGenerationTime(Clock::duration duration);
+
+    /// The following functions must only be called from the MIDI thread.
+    void recordCountIn(Clock::duration duration);
+    void recordFirstNote(Clock::time_point time);
+    void recordLateness(Clock::duration lateness);
+    void recordDriftCorrection(Clock::duration correction);
+    /// Messages that are sent before the first note (e.g. instrument
+    /// changes) are not counted.
+    void recordMessages(uint64_t count, Clock::time_point time);
+
+    /// Computes the current statistics. This can be called from any thread.
+    Summary getSummary() const;
+
+private:
+    const Clock::time_point myCreationTime;
+
+    std::atomic<int64_t> myGenerationTime;
+    std::atomic<int64_t> myCountInTime;
+    std::atomic<int64_t> myTimeToFirstNote;
+
+    /// Ring buffer of the most recent lateness samples (microseconds).
+    std::array<std::atomic<int32_t>, HISTORY_SIZE> myLateness;
+    std::atomic<uint64_t> myLatenessCount;
+
+    std::atomic<uint64_t> myDriftCorrections;
+    std::atomic<int64_t> myDriftCorrectionTotal;
+
+    /// The number of messages sent since the first note, and the time of the
+    /// most recent message (relative to the first note, in microseconds).
+    Clock::time_point myFirstNoteTime;
+    bool myHasFirstNote;
+    std::atomic<uint64_t> myMessageCount;
+    std::atomic<int64_t> myMessageTime;
+};
+
+#endif
@@ -0,0 +1,64 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "playbacksettings.h"
+
+#include <app/settingsmanager.h>
+#include <audio/settings.h>
+
+PlaybackSettings::PlaybackSettings(const SettingsTree &settings)
+    : myMidiApi(settings.get(Settings::MidiApi)),
+      myMidiPort(settings.get(Settings::MidiPort)),
+      myVibratoLevel(settings.get(Settings::MidiVibratoLevel)),
+      myWideVibratoLevel(settings.get(Settings::MidiWideVibratoLevel)),
+      myCurveResolution(settings.get(Settings::MidiCurveResolution)),
+      myMetronomeEnabled(settings.get(Settings::MetronomeEnabled)),
+      myMetronomePreset(settings.get(Settings::MetronomePreset)),
+      myMetronomeStrongAccent(settings.get(Settings::MetronomeStrongAccent)),
+      myMetronomeWeakAccent(settings.get(Settings::MetronomeWeakAccent)),
+      myCountInEnabled(settings.get(Settings::CountInEnabled)),
+      myCountInPreset(settings.get(Settings::CountInPreset)),
+      myCountInVolume(settings.get(Settings::CountInVolume))
+{
+}
+
+PlaybackSettingsPublisher::PlaybackSettingsPublisher(
+    SettingsManager &settings_manager)
+    : myCurrent(nullptr)
+{
+    publish(settings_manager);
+
+    myConnection = settings_manager.subscribeToChanges(
+        [this, &settings_manager]() { publish(settings_manager); });
+}
+
+void PlaybackSettingsPublisher::publish(SettingsManager &settings_manager)
+{
+    // Hold the lock while reading the settings, so that concurrent updates
+    // are published in order.
+    std::lock_guard<std::mutex> lock(myMutex);
+
+    std::unique_ptr<const PlaybackSettings> snapshot;
+    {
+        auto settings = settings_manager.getReadHandle();
+        snapshot = std::make_unique<const PlaybackSettings>(*settings);
+    }
+
+    myCurrent.store(snapshot.get(), std::memory_order_release);
+    mySnapshots.push_back(std::move(snapshot));
+}
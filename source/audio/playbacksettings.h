@@ -0,0 +1,85 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AUDIO_PLAYBACKSETTINGS_H
+#define AUDIO_PLAYBACKSETTINGS_H
+
+#include <atomic>
+#include <boost/signals2/connection.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class SettingsManager;
+class SettingsTree;
+
+/// The settings that are used during playback, resolved once from the
+/// settings tree so that they can be accessed without any lookups.
+struct PlaybackSettings
+{
+    explicit PlaybackSettings(const SettingsTree &settings);
+
+    int myMidiApi;
+    int myMidiPort;
+
+    int myVibratoLevel;
+    int myWideVibratoLevel;
+    int myCurveResolution;
+
+    bool myMetronomeEnabled;
+    int myMetronomePreset;
+    int myMetronomeStrongAccent;
+    int myMetronomeWeakAccent;
+
+    bool myCountInEnabled;
+    int myCountInPreset;
+    int myCountInVolume;
+};
+
+/// Publishes an immutable snapshot of the playback settings whenever the
+/// settings are changed. The latest snapshot can be read without locking,
+/// so the MIDI thread is never blocked by the settings being edited.
+class PlaybackSettingsPublisher
+{
+public:
+    explicit PlaybackSettingsPublisher(SettingsManager &settings_manager);
+
+    PlaybackSettingsPublisher(const PlaybackSettingsPublisher &) = delete;
+    PlaybackSettingsPublisher &
+    operator=(const PlaybackSettingsPublisher &) = delete;
+
+    /// Returns the latest snapshot. This is wait-free, and the snapshot
+    /// remains valid for the lifetime of the publisher.
+    const PlaybackSettings &get() const
+    {
+        return *myCurrent.load(std::memory_order_acquire);
+    }
+
+private:
+    void publish(SettingsManager &settings_manager);
+
+    /// Guards the list of snapshots, for writers only.
+    std::mutex myMutex;
+    /// Old snapshots are kept alive since a reader may still be using them.
+    /// Settings are rarely changed, so this does not grow significantly.
+    std::vector<std::unique_ptr<const PlaybackSettings>> mySnapshots;
+    std::atomic<const PlaybackSettings *> myCurrent;
+    boost::signals2::scoped_connection myConnection;
+};
+
+#endif
@@ -0,0 +1,126 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "rtmidioutputbackend.h"
+
+#include <RtMidi.h>
+#include <cassert>
+
+#ifdef __APPLE__
+#include "midisoftwaresynth.h"
+#endif
+
+RtMidiOutputBackend::RtMidiOutputBackend() : myMidiOut(nullptr)
+{
+    // Initialize the OSX software synth.
+#ifdef __APPLE__
+    try
+    {
+        static MidiSoftwareSynth synth;
+        synth.initialize();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+    };
+#endif
+
+    // Create all MIDI APIs supported on this platform.
+    std::vector<RtMidi::Api> apis;
+    RtMidi::getCompiledApi(apis);
+
+    for (const RtMidi::Api &api : apis)
+    {
+        try
+        {
+            myMidiOuts.emplace_back(new RtMidiOut(api));
+        }
+        catch (RtMidiError &e)
+        {
+            // Continue anyway, another API might work.
+            e.printMessage();
+        }
+    }
+}
+
+RtMidiOutputBackend::~RtMidiOutputBackend()
+{
+}
+
+size_t RtMidiOutputBackend::getApiCount()
+{
+    return myMidiOuts.size();
+}
+
+unsigned int RtMidiOutputBackend::getPortCount(size_t api)
+{
+    assert(api < myMidiOuts.size() && "Programming error, api doesn't exist");
+    return myMidiOuts[api]->getPortCount();
+}
+
+std::string RtMidiOutputBackend::getPortName(size_t api, unsigned int port)
+{
+    assert(api < myMidiOuts.size() && "Programming error, api doesn't exist");
+    return myMidiOuts[api]->getPortName(port);
+}
+
+bool RtMidiOutputBackend::openPort(size_t api, unsigned int port)
+{
+    if (myMidiOut)
+        myMidiOut->closePort(); // Close any open ports.
+
+    if (api >= myMidiOuts.size())
+        return false;
+
+    myMidiOut = myMidiOuts[api].get();
+    unsigned int num_ports = myMidiOut->getPortCount();
+
+    if (num_ports == 0)
+        return false;
+
+    try
+    {
+        myMidiOut->openPort(port);
+    }
+    catch (RtMidiError &e)
+    {
+        e.printMessage();
+        return false;
+    }
+
+    return true;
+}
+
+bool RtMidiOutputBackend::isPortOpen() const
+{
+    return myMidiOut != nullptr;
+}
+
+bool RtMidiOutputBackend::sendMessage(const std::vector<uint8_t> &data)
+{
+    try
+    {
+        myMidiOut->sendMessage(&data);
+    }
+    catch (RtMidiError &e)
+    {
+        e.printMessage();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,48 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef AUDIO_RTMIDIOUTPUTBACKEND_H
+#define AUDIO_RTMIDIOUTPUTBACKEND_H
+
+#include "midioutputbackend.h"
+
+#include <memory>
+
+class RtMidiOut;
+
+/// Sends MIDI messages to a system MIDI port using RtMidi.
+class RtMidiOutputBackend : public MidiOutputBackend
+{
+public:
+    RtMidiOutputBackend();
+    ~RtMidiOutputBackend() override;
+
+    size_t getApiCount() override;
+    unsigned int getPortCount(size_t api) override;
+    std::string getPortName(size_t api, unsigned int port) override;
+
+    bool openPort(size_t api, unsigned int port) override;
+    bool isPortOpen() const override;
+
+    bool sendMessage(const std::vector<uint8_t> &data) override;
+
+private:
+    std::vector<std::unique_ptr<RtMidiOut>> myMidiOuts;
+    RtMidiOut *myMidiOut;
+};
+
+#endif
@@ -28,6 +28,7 @@ namespace Settings
 
     extern const Setting<int> MidiVibratoLevel;
     extern const Setting<int> MidiWideVibratoLevel;
+    extern const Setting<int> MidiCurveResolution;
 
     extern const Setting<bool> MetronomeEnabled;
     extern const Setting<int> MetronomePreset;
@@ -0,0 +1,128 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "virtualmidioutputbackend.h"
+
+#include <cassert>
+
+VirtualMidiOutputBackend::VirtualMidiOutputBackend()
+    : myIsPortOpen(false), myStartTime(Clock::now())
+{
+}
+
+VirtualMidiOutputBackend::VirtualMidiOutputBackend(
+    const boost::filesystem::path &log_file)
+    : VirtualMidiOutputBackend()
+{
+    myLogFile.open(log_file);
+    myLogFile.exceptions(std::ios::failbit | std::ios::badbit);
+}
+
+size_t VirtualMidiOutputBackend::getApiCount()
+{
+    return 1;
+}
+
+unsigned int VirtualMidiOutputBackend::getPortCount(size_t api)
+{
+    assert(api < getApiCount() && "Programming error, api doesn't exist");
+    return 1;
+}
+
+std::string VirtualMidiOutputBackend::getPortName(size_t, unsigned int)
+{
+    return "Virtual MIDI Output";
+}
+
+bool VirtualMidiOutputBackend::openPort(size_t api, unsigned int port)
+{
+    if (api >= getApiCount() || port >= getPortCount(api))
+        return false;
+
+    std::lock_guard<std::mutex> lock(myMutex);
+    myIsPortOpen = true;
+    myStartTime = Clock::now();
+    return true;
+}
+
+bool VirtualMidiOutputBackend::isPortOpen() const
+{
+    std::lock_guard<std::mutex> lock(myMutex);
+    return myIsPortOpen;
+}
+
+bool VirtualMidiOutputBackend::sendMessage(const std::vector<uint8_t> &data)
+{
+    const Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(myMutex);
+    if (!myIsPortOpen)
+        return false;
+
+    recordMessage(std::chrono::duration_cast<std::chrono::microseconds>(
+                      now - myStartTime),
+                  data);
+    return true;
+}
+
+bool VirtualMidiOutputBackend::sendMessages(const MidiMessageBatch &messages)
+{
+    const Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(myMutex);
+    if (!myIsPortOpen)
+        return false;
+
+    const auto timestamp =
+        std::chrono::duration_cast<std::chrono::microseconds>(now -
+                                                              myStartTime);
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        const uint8_t *data = messages.getData(i);
+        recordMessage(timestamp, std::vector<uint8_t>(
+                                     data, data + messages.getSize(i)));
+    }
+
+    return true;
+}
+
+void VirtualMidiOutputBackend::recordMessage(
+    std::chrono::microseconds timestamp, const std::vector<uint8_t> &data)
+{
+    myMessages.push_back({ timestamp, data });
+
+    if (myLogFile.is_open())
+    {
+        myLogFile << timestamp.count();
+        for (uint8_t byte : data)
+            myLogFile << ' ' << static_cast<int>(byte);
+        myLogFile << '\n';
+    }
+}
+
+std::vector<VirtualMidiOutputBackend::RecordedMessage>
+VirtualMidiOutputBackend::getMessages() const
+{
+    std::lock_guard<std::mutex> lock(myMutex);
+    return myMessages;
+}
+
+void VirtualMidiOutputBackend::clear()
+{
+    std::lock_guard<std::mutex> lock(myMutex);
+    myMessages.clear();
+}
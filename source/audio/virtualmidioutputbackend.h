@@ -0,0 +1,75 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef AUDIO_VIRTUALMIDIOUTPUTBACKEND_H
+#define AUDIO_VIRTUALMIDIOUTPUTBACKEND_H
+
+#include "midioutputbackend.h"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/path.hpp>
+#include <chrono>
+#include <mutex>
+
+/// A virtual MIDI port which records a timestamp for every message that it
+/// receives, rather than sending it to a device. This allows playback to be
+/// tested without any MIDI hardware.
+class VirtualMidiOutputBackend : public MidiOutputBackend
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct RecordedMessage
+    {
+        /// Time since the port was opened.
+        std::chrono::microseconds myTimestamp;
+        std::vector<uint8_t> myData;
+    };
+
+    VirtualMidiOutputBackend();
+    /// Also writes each message as a line of text to the given file.
+    explicit VirtualMidiOutputBackend(const boost::filesystem::path &log_file);
+
+    size_t getApiCount() override;
+    unsigned int getPortCount(size_t api) override;
+    std::string getPortName(size_t api, unsigned int port) override;
+
+    bool openPort(size_t api, unsigned int port) override;
+    bool isPortOpen() const override;
+
+    bool sendMessage(const std::vector<uint8_t> &data) override;
+    /// Records all of the messages with the same timestamp.
+    bool sendMessages(const MidiMessageBatch &messages) override;
+
+    /// Returns a copy of the messages that have been recorded so far.
+    std::vector<RecordedMessage> getMessages() const;
+    /// Discards the recorded messages.
+    void clear();
+
+private:
+    /// Records a message. The mutex must be locked by the caller.
+    void recordMessage(std::chrono::microseconds timestamp,
+                       const std::vector<uint8_t> &data);
+
+    mutable std::mutex myMutex;
+    bool myIsPortOpen;
+    Clock::time_point myStartTime;
+    std::vector<RecordedMessage> myMessages;
+    boost::filesystem::ofstream myLogFile;
+};
+
+#endif
@@ -68,6 +68,12 @@ PreferencesDialog::PreferencesDialog(QWidget *parent,
     ui->vibratoStrengthSpinBox->setRange(1, 127);
     ui->wideVibratoStrengthSpinBox->setRange(1, 127);
 
+    // The number of pitch wheel or volume events per beat for bends, slides
+    // and volume swells.
+    ui->curveResolutionSpinBox->setRange(0, 96);
+    ui->curveResolutionSpinBox->setSpecialValueText(tr("Maximum"));
+    ui->curveResolutionSpinBox->setSuffix(tr(" per beat"));
+
     ui->strongAccentVolumeSpinBox->setRange(0, 127);
     ui->weakAccentVolumeSpinBox->setRange(0, 127);
 
@@ -102,6 +108,9 @@ void PreferencesDialog::loadCurrentSettings()
     ui->wideVibratoStrengthSpinBox->setValue(
         settings->get(Settings::MidiWideVibratoLevel));
 
+    ui->curveResolutionSpinBox->setValue(
+        settings->get(Settings::MidiCurveResolution));
+
     ui->metronomeEnabledCheckBox->setChecked(
         settings->get(Settings::MetronomeEnabled));
 
@@ -157,6 +166,9 @@ void PreferencesDialog::accept()
     settings->set(Settings::MidiWideVibratoLevel,
                   ui->wideVibratoStrengthSpinBox->value());
 
+    settings->set(Settings::MidiCurveResolution,
+                  ui->curveResolutionSpinBox->value());
+
     settings->set(Settings::MetronomeEnabled,
                   ui->metronomeEnabledCheckBox->isChecked());
 
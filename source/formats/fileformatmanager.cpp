@@ -21,9 +21,11 @@
 #include <formats/gpx/gpximporter.h>
 #include <formats/guitar_pro/guitarproimporter.h>
 #include <formats/midi/midiexporter.h>
+#include <formats/midi/midiimporter.h>
 #include <formats/powertab/powertabexporter.h>
 #include <formats/powertab/powertabimporter.h>
 #include <formats/powertab_old/powertaboldimporter.h>
+#include <formats/wav/wavexporter.h>
 
 FileFormatManager::FileFormatManager(const SettingsManager &settings_manager)
 {
@@ -32,9 +34,11 @@ FileFormatManager::FileFormatManager(const SettingsManager &settings_manager)
     myImporters.emplace_back(new GuitarProImporter());
     myImporters.emplace_back(new GpxImporter());
     myImporters.emplace_back(new Gp7Importer());
+    myImporters.emplace_back(new MidiImporter());
 
     myExporters.emplace_back(new PowerTabExporter());
     myExporters.emplace_back(new MidiExporter(settings_manager));
+    myExporters.emplace_back(new WavExporter(settings_manager));
 }
 
 std::optional<FileFormat> FileFormatManager::findFormat(
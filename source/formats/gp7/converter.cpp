@@ -20,7 +20,10 @@
 
 #include <boost/date_time/gregorian/gregorian_types.hpp>
 #include <boost/rational.hpp>
+#include <future>
 #include <numeric>
+#include <thread>
+#include <utility>
 
 #include <formats/fileformat.h>
 #include <score/generalmidi.h>
@@ -40,11 +43,10 @@
 
 #include <iostream>
 
-/// Convert the Guitar Pro file metadata.
-static void
-convertScoreInfo(const Gp7::ScoreInfo &gp_info, Score &score)
+void
+Gp7::convertScoreInfo(const Gp7::ScoreInfo &gp_info, Score &score)
 {
-    ScoreInfo info;
+    ::ScoreInfo info;
     SongData data;
 
     data.setTitle(gp_info.myTitle);
@@ -66,11 +68,9 @@ convertScoreInfo(const Gp7::ScoreInfo &gp_info, Score &score)
     score.setScoreInfo(info);
 }
 
-/// Create players and instruments from the Guitar Pro tracks, and the initial
-/// staff -> player & instrument assignment.
-static void
-convertPlayers(const std::vector<Gp7::Track> &tracks, Score &score,
-               PlayerChange &player_change)
+void
+Gp7::convertPlayers(const std::vector<Gp7::Track> &tracks, Score &score,
+                    PlayerChange &player_change)
 {
     for (const Gp7::Track &track : tracks)
     {
@@ -209,22 +209,22 @@ keyAndVariationFromPitch(int midi_pitch)
     return theNotes[midi_pitch];
 }
 
-static Note
-convertNote(Position &position, const Gp7::Beat &gp_beat,
-            const Gp7::Note &gp_note, const Tuning &tuning)
+Note
+Gp7::convertNote(Position &position, const Gp7::Beat &gp_beat,
+                 const Gp7::Note &gp_note, const Tuning &tuning)
 {
     using HarmonicType = Gp7::Note::HarmonicType;
 
-    Note note;
+    ::Note note;
     note.setFretNumber(gp_note.myFret);
     // String numbers are flipped around.
     note.setString(tuning.getStringCount() - gp_note.myString - 1);
 
-    note.setProperty(Note::Tied, gp_note.myTieDest);
-    note.setProperty(Note::GhostNote, gp_note.myGhost);
-    note.setProperty(Note::Muted, gp_note.myMuted);
-    note.setProperty(Note::HammerOnOrPullOff, gp_note.myHammerOn);
-    note.setProperty(Note::HammerOnFromNowhere, gp_note.myLeftHandTapped);
+    note.setProperty(::Note::Tied, gp_note.myTieDest);
+    note.setProperty(::Note::GhostNote, gp_note.myGhost);
+    note.setProperty(::Note::Muted, gp_note.myMuted);
+    note.setProperty(::Note::HammerOnOrPullOff, gp_note.myHammerOn);
+    note.setProperty(::Note::HammerOnFromNowhere, gp_note.myLeftHandTapped);
 
     if (gp_note.myPalmMuted)
         position.setProperty(Position::PalmMuting);
@@ -248,40 +248,40 @@ convertNote(Position &position, const Gp7::Beat &gp_beat,
 
     using GpSlideType = Gp7::Note::SlideType;
     if (gp_note.mySlideTypes.test(int(GpSlideType::Shift)))
-        note.setProperty(Note::ShiftSlide);
+        note.setProperty(::Note::ShiftSlide);
     if (gp_note.mySlideTypes.test(int(GpSlideType::Legato)))
-        note.setProperty(Note::LegatoSlide);
+        note.setProperty(::Note::LegatoSlide);
     if (gp_note.mySlideTypes.test(int(GpSlideType::SlideOutDown)))
-        note.setProperty(Note::SlideOutOfDownwards);
+        note.setProperty(::Note::SlideOutOfDownwards);
     if (gp_note.mySlideTypes.test(int(GpSlideType::SlideOutUp)))
-        note.setProperty(Note::SlideOutOfUpwards);
+        note.setProperty(::Note::SlideOutOfUpwards);
     if (gp_note.mySlideTypes.test(int(GpSlideType::SlideInAbove)))
-        note.setProperty(Note::SlideIntoFromAbove);
+        note.setProperty(::Note::SlideIntoFromAbove);
     if (gp_note.mySlideTypes.test(int(GpSlideType::SlideInBelow)))
-        note.setProperty(Note::SlideIntoFromBelow);
+        note.setProperty(::Note::SlideIntoFromBelow);
 
     if (gp_beat.myOttavia)
     {
         switch (*gp_beat.myOttavia)
         {
             case Gp7::Beat::Ottavia::O8va:
-                note.setProperty(Note::Octave8va);
+                note.setProperty(::Note::Octave8va);
                 break;
             case Gp7::Beat::Ottavia::O8vb:
-                note.setProperty(Note::Octave8vb);
+                note.setProperty(::Note::Octave8vb);
                 break;
             case Gp7::Beat::Ottavia::O15ma:
-                note.setProperty(Note::Octave15ma);
+                note.setProperty(::Note::Octave15ma);
                 break;
             case Gp7::Beat::Ottavia::O15mb:
-                note.setProperty(Note::Octave15mb);
+                note.setProperty(::Note::Octave15mb);
                 break;
         }
     }
 
     if (gp_note.myHarmonic)
     {
-        note.setProperty(Note::NaturalHarmonic,
+        note.setProperty(::Note::NaturalHarmonic,
                          gp_note.myHarmonic == HarmonicType::Natural);
 
         if (gp_note.myHarmonic == HarmonicType::Tap)
@@ -418,8 +418,8 @@ convertNote(Position &position, const Gp7::Beat &gp_beat,
     return note;
 }
 
-static Position
-convertPosition(const Gp7::Beat &gp_beat, const Gp7::Rhythm &gp_rhythm)
+Position
+Gp7::convertPosition(const Gp7::Beat &gp_beat, const Gp7::Rhythm &gp_rhythm)
 {
     Position pos;
 
@@ -668,10 +668,27 @@ convertBarline(Barline &start_bar, Barline &end_bar,
     }
 }
 
-/// Convert irregular groups for a single bar.
-static void
-convertIrregularGroupings(Voice &voice, int start_pos, int end_pos,
-                          const Gp7::Document &doc, const Gp7::Voice &gp_voice)
+boost::rational<int>
+Gp7::insertPosition(::Voice &voice, const Position &pos,
+                    const Gp7::Rhythm &gp_rhythm)
+{
+    voice.insertPosition(pos);
+
+    // Take irregular groups into account when computing the duration time
+    // (the groups aren't constructed until all notes are created).
+    boost::rational<int> duration = VoiceUtils::getDurationTime(voice, pos);
+    if (gp_rhythm.myTupletNum)
+    {
+        duration *= boost::rational<int>(gp_rhythm.myTupletDenom,
+                                         gp_rhythm.myTupletNum);
+    }
+
+    return duration;
+}
+
+void
+Gp7::convertIrregularGroupings(::Voice &voice, int start_pos, int end_pos,
+                               const std::vector<Gp7::Rhythm> &gp_rhythms)
 {
     std::optional<IrregularGrouping> current_group;
     boost::rational<int> duration;
@@ -681,10 +698,8 @@ convertIrregularGroupings(Voice &voice, int start_pos, int end_pos,
         ScoreUtils::findInRange(voice.getPositions(), start_pos, end_pos);
 
     auto it = positions.begin();
-    for (int gp_beat_idx : gp_voice.myBeatIds)
+    for (const Gp7::Rhythm &gp_rhythm : gp_rhythms)
     {
-        const Gp7::Beat &gp_beat = doc.myBeats.at(gp_beat_idx);
-        const Gp7::Rhythm &gp_rhythm = doc.myRhythms.at(gp_beat.myRhythmId);
         const Position &pos = *it;
 
         if (gp_rhythm.myTupletDenom)
@@ -924,43 +939,66 @@ convertChord(const Gp7::Chord &gp_chord)
     return chord;
 }
 
-static void
-convertSystem(const Gp7::Document &doc, Score &score, int bar_begin,
-              int bar_end)
+void
+Gp7::beginBar(System &system, const Gp7::MasterBar &master_bar,
+              int &system_bar_idx, int &start_pos)
 {
-    System system;
-
-    // For the first system, create the players and assign them to the staves.
-    if (bar_begin == 0)
+    // If the previous bar was a repeat end, and this master bar is a repeat
+    // start, we'll need to create a separate adjacent barline.
+    if (master_bar.myRepeatStart &&
+        system.getBarlines()[system_bar_idx].getBarType() == Barline::RepeatEnd)
     {
-        PlayerChange initial_player_change;
-        convertPlayers(doc.myTracks, score, initial_player_change);
-        system.insertPlayerChange(initial_player_change);
+        Barline barline;
+        barline.setPosition(start_pos);
+        system.insertBarline(barline);
+        ++system_bar_idx;
+        ++start_pos;
     }
+}
+
+void
+Gp7::endBar(System &system, const Gp7::MasterBar &master_bar,
+            const Gp7::MasterBar *prev_master_bar, int system_bar_idx,
+            int start_pos, int end_pos, bool final_bar, bool end_of_system)
+{
+    // Get the surrounding barlines and set their properties.
+    Barline &bar_1 = system.getBarlines()[system_bar_idx];
+    Barline bar_2;
+    bar_2.setPosition(end_pos);
+    convertBarline(bar_1, bar_2, master_bar, prev_master_bar, final_bar);
+
+    convertTempoMarkers(system, bar_1.getPosition(), master_bar);
+    convertAlternateEndings(system, bar_1.getPosition(), master_bar);
+    convertDirections(system, start_pos, end_pos, master_bar);
+
+    // Insert a new barline unless we're finishing the system, in which case
+    // we just need to modify the end bar.
+    if (!end_of_system)
+        system.insertBarline(bar_2);
+    else
+        system.getBarlines().back() = bar_2;
+}
+
+/// Converts a range of master bars into a system. This only reads from the
+/// score (e.g. the players), so multiple systems can be converted in parallel.
+static System
+convertSystem(const Gp7::Document &doc, const Score &score, int bar_begin,
+              int bar_end)
+{
+    System system;
 
     // Create a staff for each player.
     for (auto &&player : score.getPlayers())
         system.insertStaff(Staff(player.getTuning().getStringCount()));
 
+    std::vector<Gp7::Rhythm> gp_rhythms;
     int start_pos = 0;
     int system_bar_idx = 0;
     for (int bar_idx = bar_begin; bar_idx < bar_end; ++bar_idx)
     {
         const int num_staves = static_cast<int>(score.getPlayers().size());
         const Gp7::MasterBar &master_bar = doc.myMasterBars.at(bar_idx);
-
-        // If the previous bar was a repeat end, and this master bar is a
-        // repeat start, we'll need to create a separate adjacent barline.
-        if (master_bar.myRepeatStart &&
-            system.getBarlines()[system_bar_idx].getBarType() ==
-                Barline::RepeatEnd)
-        {
-            Barline barline;
-            barline.setPosition(start_pos);
-            system.insertBarline(barline);
-            ++system_bar_idx;
-            ++start_pos;
-        }
+        Gp7::beginBar(system, master_bar, system_bar_idx, start_pos);
 
         // Go through the bar for each staff.
         int end_pos = start_pos;
@@ -990,11 +1028,13 @@ convertSystem(const Gp7::Document &doc, Score &score, int bar_begin,
 
                 int voice_pos = start_pos;
                 boost::rational<int> time;
+                gp_rhythms.clear();
                 for (int gp_beat_idx : gp_voice.myBeatIds)
                 {
                     const Gp7::Beat &gp_beat = doc.myBeats.at(gp_beat_idx);
                     const Gp7::Rhythm &gp_rhythm =
                         doc.myRhythms.at(gp_beat.myRhythmId);
+                    gp_rhythms.push_back(gp_rhythm);
 
                     // Create a text item in the system if necessary.
                     if (!gp_beat.myFreeText.empty())
@@ -1014,7 +1054,7 @@ convertSystem(const Gp7::Document &doc, Score &score, int bar_begin,
                         system.insertChord(ChordText(voice_pos, chord));
                     }
 
-                    Position pos = convertPosition(gp_beat, gp_rhythm);
+                    Position pos = Gp7::convertPosition(gp_beat, gp_rhythm);
                     pos.setPosition(voice_pos++);
 
                     if (master_bar.myFermatas.count(time))
@@ -1029,7 +1069,8 @@ convertSystem(const Gp7::Document &doc, Score &score, int bar_begin,
                     {
                         const Gp7::Note &gp_note = doc.myNotes.at(gp_note_id);
 
-                        Note note = convertNote(pos, gp_beat, gp_note, tuning);
+                        Note note =
+                            Gp7::convertNote(pos, gp_beat, gp_note, tuning);
                         if (Utils::findByString(pos, note.getString()))
                         {
                             // This happens for drums in .gpx files, which
@@ -1044,54 +1085,97 @@ convertSystem(const Gp7::Document &doc, Score &score, int bar_begin,
                             pos.insertNote(note);
                     }
 
-                    voice.insertPosition(pos);
-
-                    // Take irregular groups into account when computing the
-                    // duration time (the groups aren't constructed until all
-                    // notes are created).
-                    boost::rational<int> duration =
-                        VoiceUtils::getDurationTime(voice, pos);
-                    if (gp_rhythm.myTupletNum)
-                    {
-                        duration *= boost::rational<int>(
-                            gp_rhythm.myTupletDenom, gp_rhythm.myTupletNum);
-                    }
-
-                    time += duration;
+                    time += Gp7::insertPosition(voice, pos, gp_rhythm);
                 }
 
-                convertIrregularGroupings(voice, start_pos, voice_pos, doc,
-                                          gp_voice);
+                Gp7::convertIrregularGroupings(voice, start_pos, voice_pos,
+                                               gp_rhythms);
 
                 end_pos = std::max(voice_pos, end_pos);
             }
         }
 
-        // Get the surrounding barlines and set their properties.
         const bool final_bar = size_t(bar_idx + 1) == doc.myMasterBars.size();
-        Barline &bar_1 = system.getBarlines()[system_bar_idx];
-        Barline bar_2;
-        bar_2.setPosition(end_pos);
         const Gp7::MasterBar *prev_master_bar =
             (bar_idx != 0) ? &doc.myMasterBars[bar_idx - 1] : nullptr;
-        convertBarline(bar_1, bar_2, master_bar, prev_master_bar, final_bar);
-
-        convertTempoMarkers(system, bar_1.getPosition(), master_bar);
-        convertAlternateEndings(system, bar_1.getPosition(), master_bar);
-        convertDirections(system, start_pos, end_pos, master_bar);
-
-        // Insert a new barline unless we're finishing the system, in which
-        // case we just need to modify the end bar.
-        if (bar_idx != (bar_end - 1))
-            system.insertBarline(bar_2);
-        else
-            system.getBarlines().back() = bar_2;
+        Gp7::endBar(system, master_bar, prev_master_bar, system_bar_idx,
+                    start_pos, end_pos, final_bar, bar_idx == bar_end - 1);
 
         ++system_bar_idx;
         start_pos = end_pos + 1;
     }
 
-    score.insertSystem(system);
+    return system;
+}
+
+void
+Gp7::convertSystems(Score &score, int num_systems,
+                    const std::function<System(int)> &convert_system,
+                    const PlayerChange &initial_player_change)
+{
+    if (num_systems == 0)
+        return;
+
+    std::vector<System> systems(num_systems);
+
+    const int num_threads = std::max(
+        1, std::min(num_systems,
+                    static_cast<int>(std::thread::hardware_concurrency())));
+    std::vector<std::future<void>> tasks;
+
+    for (int i = 0; i < num_threads; ++i)
+    {
+        tasks.push_back(std::async(std::launch::async, [&](int first) {
+            for (int system_idx = first; system_idx < num_systems;
+                 system_idx += num_threads)
+            {
+                systems[system_idx] = convert_system(system_idx);
+            }
+        }, i));
+    }
+
+    for (auto &&task : tasks)
+        task.get();
+
+    systems.front().insertPlayerChange(initial_player_change);
+    for (System &system : systems)
+        score.insertSystem(std::move(system));
+}
+
+/// Converts the master bars into systems, with the number of bars per system
+/// given by the layout.
+static void
+convertMasterBars(const Gp7::Document &doc, const std::vector<int> &layout,
+                  Score &score)
+{
+    if (layout.empty())
+        return;
+
+    // Create the players and assign them to the staves in the first system.
+    PlayerChange initial_player_change;
+    Gp7::convertPlayers(doc.myTracks, score, initial_player_change);
+
+    // Find the range of bars in each system.
+    std::vector<std::pair<int, int>> system_bars;
+    int bar_idx = 0;
+    for (int num_bars : layout)
+    {
+        const int bar_end = std::min(bar_idx + num_bars,
+                                     static_cast<int>(doc.myMasterBars.size()));
+        system_bars.emplace_back(bar_idx, bar_end);
+        bar_idx += num_bars;
+    }
+
+    // Each system only depends on its own master bars (and the previous
+    // master bar for key / time signature changes), so the systems can be
+    // converted in parallel and then inserted in order.
+    Gp7::convertSystems(
+        score, static_cast<int>(system_bars.size()),
+        [&](int system_idx) {
+            const auto [bar_begin, bar_end] = system_bars[system_idx];
+            return convertSystem(doc, score, bar_begin, bar_end);
+        },
+        initial_player_change);
 }
 
 static bool
@@ -1103,7 +1187,7 @@ isValidLayout(const std::vector<int> &layout, int num_bars)
 void
 Gp7::convert(const Gp7::Document &doc, Score &score)
 {
-    convertScoreInfo(doc.myScoreInfo, score);
+    Gp7::convertScoreInfo(doc.myScoreInfo, score);
 
     // The multi-track layout is sometimes invalid (particularly for .gpx
     // files). So, fall back to the first track's layout if we need to.
@@ -1115,14 +1199,7 @@ Gp7::convert(const Gp7::Document &doc, Score &score)
         assert(isValidLayout(layout, static_cast<int>(doc.myMasterBars.size())));
     }
 
-    int bar_idx = 0;
-    for (int num_bars : layout)
-    {
-        const int bar_end = std::min(bar_idx + num_bars,
-                                     static_cast<int>(doc.myMasterBars.size()));
-        convertSystem(doc, score, bar_idx, bar_end);
-        bar_idx += num_bars;
-    }
+    convertMasterBars(doc, layout, score);
 
     ScoreUtils::adjustRehearsalSigns(score);
     ScoreUtils::polishScore(score);
@@ -18,15 +18,78 @@
 #ifndef FORMATS_GP7_CONVERTER_H
 #define FORMATS_GP7_CONVERTER_H
 
+#include <boost/rational.hpp>
+#include <functional>
+#include <vector>
+
+class Note;
+class PlayerChange;
+class Position;
 class Score;
+class System;
+class Tuning;
+class Voice;
 
 namespace Gp7
 {
+struct Beat;
 struct Document;
+struct MasterBar;
+struct Note;
+struct Rhythm;
+struct ScoreInfo;
+struct Track;
 
 /// Converts the Guitar Pro document into the provided score.
 void convert(const Gp7::Document &doc, Score &score);
 
+// The functions below are also used by the Guitar Pro 3/4/5 converter, which
+// creates the score directly rather than building a Gp7::Document.
+
+/// Converts the Guitar Pro file metadata.
+void convertScoreInfo(const ScoreInfo &gp_info, Score &score);
+
+/// Creates players and instruments from the Guitar Pro tracks, and the initial
+/// staff -> player & instrument assignment.
+void convertPlayers(const std::vector<Track> &tracks, Score &score,
+                    PlayerChange &player_change);
+
+/// Creates a position for the beat, without any of its notes.
+Position convertPosition(const Beat &gp_beat, const Rhythm &gp_rhythm);
+
+/// Converts a note, including its bend and harmonic. Properties such as palm
+/// muting are set on the position.
+::Note convertNote(Position &position, const Beat &gp_beat,
+                   const Gp7::Note &gp_note, const Tuning &tuning);
+
+/// Inserts the position into the voice.
+/// @returns The duration of the position, including the effect of its tuplet.
+boost::rational<int> insertPosition(Voice &voice, const Position &pos,
+                                    const Rhythm &gp_rhythm);
+
+/// Creates the irregular groupings for a single bar of the voice, given the
+/// rhythm of each position in the bar.
+void convertIrregularGroupings(Voice &voice, int start_pos, int end_pos,
+                               const std::vector<Rhythm> &gp_rhythms);
+
+/// Starts a new bar in the system. If the previous bar was a repeat end and
+/// this bar is a repeat start, a separate adjacent barline is inserted.
+void beginBar(System &system, const MasterBar &master_bar, int &system_bar_idx,
+              int &start_pos);
+
+/// Sets the properties of the bar's barlines, and converts its tempo markers,
+/// alternate endings and directions. The end barline is inserted into the
+/// system, or replaces the system's last barline at the end of the system.
+void endBar(System &system, const MasterBar &master_bar,
+            const MasterBar *prev_master_bar, int system_bar_idx,
+            int start_pos, int end_pos, bool final_bar, bool end_of_system);
+
+/// Converts the systems in parallel and inserts them into the score. The
+/// initial player change is added to the first system.
+void convertSystems(Score &score, int num_systems,
+                    const std::function<System(int)> &convert_system,
+                    const PlayerChange &initial_player_change);
+
 } // namespace Gp7
 
 #endif
@@ -27,6 +27,8 @@
 
 #include <pugixml.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <formats/fileformat.h>
 #include <score/score.h>
 #include <util/scopeexit.h>
@@ -72,12 +74,121 @@ UnzFileHandle openZipFile(const boost::filesystem::path &filename)
     return zip_file;
 }
 
+/// A zip archive that has been loaded into memory, which is read through
+/// minizip's I/O callbacks.
+struct MemoryStream
+{
+    const uint8_t *myData;
+    ZPOS64_T mySize;
+    ZPOS64_T myPosition;
+};
+
+voidpf openMemoryStream(voidpf opaque, const void *, int mode)
+{
+    // The archive can only be read.
+    if ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER) != ZLIB_FILEFUNC_MODE_READ)
+        return nullptr;
+
+    auto stream = static_cast<MemoryStream *>(opaque);
+    stream->myPosition = 0;
+    return stream;
+}
+
+uLong readMemoryStream(voidpf, voidpf s, void *buf, uLong size)
+{
+    auto stream = static_cast<MemoryStream *>(s);
+    const ZPOS64_T n =
+        std::min<ZPOS64_T>(size, stream->mySize - stream->myPosition);
+    std::memcpy(buf, stream->myData + stream->myPosition, n);
+    stream->myPosition += n;
+    return static_cast<uLong>(n);
+}
+
+uLong writeMemoryStream(voidpf, voidpf, const void *, uLong)
+{
+    return 0;
+}
+
+ZPOS64_T tellMemoryStream(voidpf, voidpf s)
+{
+    return static_cast<MemoryStream *>(s)->myPosition;
+}
+
+long seekMemoryStream(voidpf, voidpf s, ZPOS64_T offset, int origin)
+{
+    auto stream = static_cast<MemoryStream *>(s);
+
+    ZPOS64_T base = 0;
+    switch (origin)
+    {
+        case ZLIB_FILEFUNC_SEEK_SET:
+            base = 0;
+            break;
+        case ZLIB_FILEFUNC_SEEK_CUR:
+            base = stream->myPosition;
+            break;
+        case ZLIB_FILEFUNC_SEEK_END:
+            base = stream->mySize;
+            break;
+        default:
+            return -1;
+    }
+
+    if (offset > stream->mySize - base)
+        return -1;
+
+    stream->myPosition = base + offset;
+    return 0;
+}
+
+int closeMemoryStream(voidpf, voidpf)
+{
+    return 0;
+}
+
+int testErrorMemoryStream(voidpf, voidpf)
+{
+    return 0;
+}
+
+/// Opens a zip archive from memory. The stream must outlive the returned
+/// handle.
+UnzFileHandle openZipFile(MemoryStream &stream)
+{
+    zlib_filefunc64_def ffunc;
+    ffunc.zopen64_file = openMemoryStream;
+    ffunc.zread_file = readMemoryStream;
+    ffunc.zwrite_file = writeMemoryStream;
+    ffunc.ztell64_file = tellMemoryStream;
+    ffunc.zseek64_file = seekMemoryStream;
+    ffunc.zclose_file = closeMemoryStream;
+    ffunc.zerror_file = testErrorMemoryStream;
+    ffunc.opaque = &stream;
+
+    // The filename is unused, but must not be null.
+    UnzFileHandle zip_file;
+    zip_file.reset(unzOpen2_64("", &ffunc));
+    if (!zip_file)
+        throw FileFormatException("Failed to unzip file.");
+
+    return zip_file;
+}
+
 /// Loads a file from the provided zip archive.
 std::vector<std::byte> loadFileFromZip(unzFile zip_file, const char *name)
 {
     if (unzLocateFile(zip_file, name, 1) == UNZ_END_OF_LIST_OF_FILE)
         throw FileFormatException("Could not find file in archive.");
 
+    // Use the uncompressed size from the file's header to allocate the
+    // buffer up front.
+    unz_file_info64 info;
+    if (unzGetCurrentFileInfo64(zip_file, &info, nullptr, 0, nullptr, 0,
+                                nullptr, 0) != UNZ_OK)
+    {
+        throw FileFormatException("Failed to read file info from archive.");
+    }
+
     if (unzOpenCurrentFile(zip_file) != UNZ_OK)
         throw FileFormatException("Failed to open file in archive.");
 
@@ -87,16 +198,38 @@ std::vector<std::byte> loadFileFromZip(unzFile zip_file, const char *name)
             throw FileFormatException("Failed to close file.");
     });
 
-    // Read the file contents, block by block.
-    std::vector<std::byte> buffer;
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+    // Deflate cannot expand data by more than ~1032:1, so don't trust a
+    // corrupt header to allocate beyond that.
+    static constexpr ZPOS64_T MAX_COMPRESSION_RATIO = 1032;
+
+    std::vector<std::byte> buffer(static_cast<size_t>(
+        std::min(info.uncompressed_size,
+                 info.compressed_size * MAX_COMPRESSION_RATIO + BLOCK_SIZE)));
+    size_t position = 0;
     while (true)
     {
-        static constexpr int BLOCK_SIZE = 4096;
+        if (position == buffer.size())
+        {
+            // Check for the end of the file before growing the buffer, in
+            // case the size from the header was incorrect.
+            std::byte extra;
+            const int bytes_read = unzReadCurrentFile(zip_file, &extra, 1);
+            if (bytes_read == 0)
+                break;
+            else if (bytes_read < 0)
+                throw FileFormatException("Failed to read file.");
 
-        const size_t block_start = buffer.size();
-        buffer.resize(buffer.size() + BLOCK_SIZE);
-        const int bytes_read = unzReadCurrentFile(
-            zip_file, buffer.data() + block_start, BLOCK_SIZE);
+            buffer.resize(std::max(2 * buffer.size(), BLOCK_SIZE));
+            buffer[position++] = extra;
+            continue;
+        }
+
+        const size_t block_size =
+            std::min<size_t>(BLOCK_SIZE, buffer.size() - position);
+        const int bytes_read =
+            unzReadCurrentFile(zip_file, buffer.data() + position,
+                               static_cast<unsigned>(block_size));
 
         if (bytes_read == 0)
         {
@@ -104,33 +237,24 @@ std::vector<std::byte> loadFileFromZip(unzFile zip_file, const char *name)
             break;
         }
         else if (bytes_read < 0)
-        {
             throw FileFormatException("Failed to read file.");
-        }
-        else if (bytes_read != BLOCK_SIZE)
-        {
-            // We likely reached the end of the file - trim extra entries that
-            // were allocated.
-            assert(bytes_read < BLOCK_SIZE);
-            buffer.resize(buffer.size() - (BLOCK_SIZE - bytes_read));
-        }
-    };
 
+        position += bytes_read;
+    }
+
+    // Trim any extra space if the file was shorter than expected.
+    buffer.resize(position);
     return buffer;
 }
 
-} // namespace
-
-void Gp7Importer::load(const boost::filesystem::path &filename, Score &score)
+/// Imports the score from an opened .gp archive.
+void loadScore(unzFile zip_file, Score &score)
 {
-    // The .gp file format is just a zip file with a different extension.
-    UnzFileHandle zip_file = openZipFile(filename);
-
     // There are a few files, but Content/score.gpif has the main contents in
     // XML format. This is very similar to the .gpx file format, but with a
     // different container.
     std::vector<std::byte> buffer =
-        loadFileFromZip(zip_file.get(), "Content/score.gpif");
+        loadFileFromZip(zip_file, "Content/score.gpif");
 
     // Parse as an XML file.
     pugi::xml_document xml_doc;
@@ -142,3 +266,19 @@ void Gp7Importer::load(const boost::filesystem::path &filename, Score &score)
     Gp7::Document doc = Gp7::parse(xml_doc, Gp7::Version::V7);
     Gp7::convert(doc, score);
 }
+
+} // namespace
+
+void Gp7Importer::load(const boost::filesystem::path &filename, Score &score)
+{
+    // The .gp file format is just a zip file with a different extension.
+    UnzFileHandle zip_file = openZipFile(filename);
+    loadScore(zip_file.get(), score);
+}
+
+void Gp7Importer::load(const uint8_t *data, size_t size, Score &score)
+{
+    MemoryStream stream{ data, size, 0 };
+    UnzFileHandle zip_file = openZipFile(stream);
+    loadScore(zip_file.get(), score);
+}
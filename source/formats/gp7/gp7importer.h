@@ -20,12 +20,18 @@
 
 #include <formats/fileformat.h>
 
+#include <cstddef>
+#include <cstdint>
+
 class Gp7Importer : public FileFormatImporter
 {
 public:
     Gp7Importer();
 
     void load(const boost::filesystem::path &filename, Score &score) override;
+
+    /// Imports a .gp file whose archive has already been loaded into memory.
+    static void load(const uint8_t *data, size_t size, Score &score);
 };
 
 #endif
@@ -74,6 +74,51 @@ toIntList(const std::vector<std::string> &input)
     return output;
 }
 
+namespace
+{
+/// Maps the ids used in the file to indices in the document's arrays. The ids
+/// are small, dense integers, so a flat table is used rather than a hash map.
+class IdTable
+{
+public:
+    void insert(int id, size_t index)
+    {
+        // Reject ids that are negative or implausibly large, rather than
+        // allocating a huge table.
+        static constexpr int MAX_ID = 1 << 24;
+        if (id < 0 || id >= MAX_ID)
+            throw FileFormatException("Invalid id");
+
+        if (static_cast<size_t>(id) >= myIndices.size())
+            myIndices.resize(id + 1, -1);
+        if (myIndices[id] >= 0)
+            throw FileFormatException("Duplicate id");
+
+        myIndices[id] = static_cast<int>(index);
+    }
+
+    int lookup(int id) const
+    {
+        if (id < 0 || static_cast<size_t>(id) >= myIndices.size() ||
+            myIndices[id] < 0)
+        {
+            throw FileFormatException("Invalid id reference");
+        }
+
+        return myIndices[id];
+    }
+
+    void remap(std::vector<int> &ids) const
+    {
+        for (int &id : ids)
+            id = lookup(id);
+    }
+
+private:
+    std::vector<int> myIndices;
+};
+} // namespace
+
 static Gp7::ScoreInfo
 parseScoreInfo(const pugi::xml_node &node)
 {
@@ -451,10 +496,10 @@ parseMasterBars(const pugi::xml_node &master_bars_node)
     return master_bars;
 }
 
-static std::unordered_map<int, Gp7::Bar>
-parseBars(const pugi::xml_node &bars_node)
+static std::vector<Gp7::Bar>
+parseBars(const pugi::xml_node &bars_node, IdTable &ids)
 {
-    std::unordered_map<int, Gp7::Bar> bars;
+    std::vector<Gp7::Bar> bars;
     for (const pugi::xml_node &node : bars_node.children("Bar"))
     {
         Gp7::Bar bar;
@@ -477,32 +522,32 @@ parseBars(const pugi::xml_node &bars_node)
 
         // TODO - import the 'Ottavia' key if the clef has 8va, etc
 
-        const int id = node.attribute("id").as_int();
-        bars.emplace(id, bar);
+        ids.insert(node.attribute("id").as_int(), bars.size());
+        bars.push_back(std::move(bar));
     }
 
     return bars;
 }
 
-static std::unordered_map<int, Gp7::Voice>
-parseVoices(const pugi::xml_node &voices_node)
+static std::vector<Gp7::Voice>
+parseVoices(const pugi::xml_node &voices_node, IdTable &ids)
 {
-    std::unordered_map<int, Gp7::Voice> voices;
+    std::vector<Gp7::Voice> voices;
     for (const pugi::xml_node &node : voices_node.children("Voice"))
     {
         Gp7::Voice voice;
         voice.myBeatIds = toIntList(splitString(node.child_value("Beats")));
-        const int id = node.attribute("id").as_int();
-        voices.emplace(id, voice);
+        ids.insert(node.attribute("id").as_int(), voices.size());
+        voices.push_back(std::move(voice));
     }
 
     return voices;
 }
 
-static std::unordered_map<int, Gp7::Beat>
-parseBeats(const pugi::xml_node &beats_node)
+static std::vector<Gp7::Beat>
+parseBeats(const pugi::xml_node &beats_node, IdTable &ids)
 {
-    std::unordered_map<int, Gp7::Beat> beats;
+    std::vector<Gp7::Beat> beats;
     for (const pugi::xml_node &node : beats_node.children("Beat"))
     {
         Gp7::Beat beat;
@@ -564,17 +609,17 @@ parseBeats(const pugi::xml_node &beats_node)
                 beat.myArpeggioUp = true;
         }
 
-        const int id = node.attribute("id").as_int();
-        beats.emplace(id, beat);
+        ids.insert(node.attribute("id").as_int(), beats.size());
+        beats.push_back(std::move(beat));
     }
 
     return beats;
 }
 
-static std::unordered_map<int, Gp7::Note>
-parseNotes(const pugi::xml_node &notes_node)
+static std::vector<Gp7::Note>
+parseNotes(const pugi::xml_node &notes_node, IdTable &ids)
 {
-    std::unordered_map<int, Gp7::Note> notes;
+    std::vector<Gp7::Note> notes;
     for (const pugi::xml_node &node : notes_node.children("Note"))
     {
         Gp7::Note note;
@@ -701,22 +746,22 @@ parseNotes(const pugi::xml_node &notes_node)
 
         // TODO - import bends.
 
-        const int id = node.attribute("id").as_int();
-        notes.emplace(id, note);
+        ids.insert(node.attribute("id").as_int(), notes.size());
+        notes.push_back(std::move(note));
     }
 
     return notes;
 }
 
-static std::unordered_map<int, Gp7::Rhythm>
-parseRhythms(const pugi::xml_node &rhythms_node)
+static std::vector<Gp7::Rhythm>
+parseRhythms(const pugi::xml_node &rhythms_node, IdTable &ids)
 {
     static const std::unordered_map<std::string, int> theNoteValuesMap = {
         { "Whole", 1 }, { "Half", 2 },  { "Quarter", 4 }, { "Eighth", 8 },
         { "16th", 16 }, { "32nd", 32 }, { "64th", 64 }
     };
 
-    std::unordered_map<int, Gp7::Rhythm> rhythms;
+    std::vector<Gp7::Rhythm> rhythms;
     for (const pugi::xml_node &node : rhythms_node.children("Rhythm"))
     {
         Gp7::Rhythm rhythm;
@@ -744,8 +789,8 @@ parseRhythms(const pugi::xml_node &rhythms_node)
             rhythm.myTupletDenom = tuplet.attribute("den").as_int();
         }
 
-        const int id = node.attribute("id").as_int();
-        rhythms.emplace(id, rhythm);
+        ids.insert(node.attribute("id").as_int(), rhythms.size());
+        rhythms.push_back(std::move(rhythm));
     }
 
     return rhythms;
@@ -755,7 +800,7 @@ void
 Gp7::Document::addBar(MasterBar &master_bar, Bar bar)
 {
     const int bar_id = static_cast<int>(myBars.size());
-    myBars[bar_id] = std::move(bar);
+    myBars.push_back(std::move(bar));
     master_bar.myBarIds.push_back(bar_id);
 }
 
@@ -763,7 +808,7 @@ void
 Gp7::Document::addVoice(Bar &bar, Voice voice)
 {
     const int voice_id = static_cast<int>(myVoices.size());
-    myVoices[voice_id] = std::move(voice);
+    myVoices.push_back(std::move(voice));
     bar.myVoiceIds.push_back(voice_id);
 }
 
@@ -771,7 +816,7 @@ void
 Gp7::Document::addBeat(Voice &voice, Beat beat)
 {
     const int beat_id = static_cast<int>(myBeats.size());
-    myBeats[beat_id] = std::move(beat);
+    myBeats.push_back(std::move(beat));
     voice.myBeatIds.push_back(beat_id);
 }
 
@@ -779,7 +824,7 @@ void
 Gp7::Document::addNote(Beat &beat, Note note)
 {
     const int note_id = static_cast<int>(myNotes.size());
-    myNotes[note_id] = std::move(note);
+    myNotes.push_back(std::move(note));
     beat.myNoteIds.push_back(note_id);
 }
 
@@ -788,7 +833,7 @@ Gp7::Document::addRhythm(Beat &beat, Rhythm rhythm)
 {
     // TODO - consolidate identical rhythms?
     const int rhythm_id = static_cast<int>(myRhythms.size());
-    myRhythms[rhythm_id] = std::move(rhythm);
+    myRhythms.push_back(std::move(rhythm));
     beat.myRhythmId = rhythm_id;
 }
 
@@ -815,11 +860,36 @@ Gp7::parse(const pugi::xml_document &root, Version version)
 
     doc.myTracks = parseTracks(gpif.child("Tracks"), version);
     doc.myMasterBars = parseMasterBars(gpif.child("MasterBars"));
-    doc.myBars = parseBars(gpif.child("Bars"));
-    doc.myVoices = parseVoices(gpif.child("Voices"));
-    doc.myBeats = parseBeats(gpif.child("Beats"));
-    doc.myNotes = parseNotes(gpif.child("Notes"));
-    doc.myRhythms = parseRhythms(gpif.child("Rhythms"));
+
+    IdTable bar_ids, voice_ids, beat_ids, note_ids, rhythm_ids;
+    doc.myBars = parseBars(gpif.child("Bars"), bar_ids);
+    doc.myVoices = parseVoices(gpif.child("Voices"), voice_ids);
+    doc.myBeats = parseBeats(gpif.child("Beats"), beat_ids);
+    doc.myNotes = parseNotes(gpif.child("Notes"), note_ids);
+    doc.myRhythms = parseRhythms(gpif.child("Rhythms"), rhythm_ids);
+
+    // Replace the ids from the file with indices into the document's arrays.
+    for (Gp7::MasterBar &master_bar : doc.myMasterBars)
+        bar_ids.remap(master_bar.myBarIds);
+
+    for (Gp7::Bar &bar : doc.myBars)
+    {
+        for (int &voice_id : bar.myVoiceIds)
+        {
+            // Unused voices have an id of -1.
+            if (voice_id >= 0)
+                voice_id = voice_ids.lookup(voice_id);
+        }
+    }
+
+    for (Gp7::Voice &voice : doc.myVoices)
+        beat_ids.remap(voice.myBeatIds);
+
+    for (Gp7::Beat &beat : doc.myBeats)
+    {
+        note_ids.remap(beat.myNoteIds);
+        beat.myRhythmId = rhythm_ids.lookup(beat.myRhythmId);
+    }
 
     parseTempoChanges(master_track, doc.myMasterBars);
 
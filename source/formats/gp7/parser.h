@@ -357,6 +357,9 @@ struct Note
 };
 
 /// Container for a Guitar Pro 7 document.
+/// Bars, voices, beats, notes and rhythms are stored contiguously, and refer
+/// to each other by their index in these arrays (the ids from the file are
+/// remapped when parsing).
 struct Document
 {
     void addBar(MasterBar &master_bar, Bar bar);
@@ -368,11 +371,11 @@ struct Document
     ScoreInfo myScoreInfo;
     std::vector<Track> myTracks;
     std::vector<MasterBar> myMasterBars;
-    std::unordered_map<int, Bar> myBars;
-    std::unordered_map<int, Voice> myVoices;
-    std::unordered_map<int, Beat> myBeats;
-    std::unordered_map<int, Note> myNotes;
-    std::unordered_map<int, Rhythm> myRhythms;
+    std::vector<Bar> myBars;
+    std::vector<Voice> myVoices;
+    std::vector<Beat> myBeats;
+    std::vector<Note> myNotes;
+    std::vector<Rhythm> myRhythms;
 };
 
 /// Parses the score.gpif XML file.
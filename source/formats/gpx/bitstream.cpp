@@ -17,63 +17,110 @@
 
 #include "bitstream.h"
 
-#include "util.h"
+#include <array>
 #include <cassert>
 #include <istream>
 
 static constexpr uint32_t BYTE_LENGTH = 8;
 
-Gpx::BitStream::BitStream(std::istream &stream) : myPosition(0)
+/// The bits of each byte in reverse order.
+static constexpr std::array<uint8_t, 256> THE_REVERSED_BYTES = []() {
+    std::array<uint8_t, 256> table = {};
+    for (int i = 0; i < 256; ++i)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            if (i & (1 << bit))
+                reversed |= 1 << (7 - bit);
+        }
+        table[i] = static_cast<uint8_t>(reversed);
+    }
+    return table;
+}();
+
+static std::vector<std::byte> readAll(std::istream &stream)
 {
-    // Copy data from the stream into an internal buffer.
+    std::vector<std::byte> bytes;
+
     stream.seekg(0, std::ios::end);
-    myBytes.resize(stream.tellg());
+    bytes.resize(stream.tellg());
 
     stream.seekg(0, std::ios::beg);
-    stream.read(reinterpret_cast<char *>(&myBytes[0]), myBytes.size());
+    stream.read(reinterpret_cast<char *>(bytes.data()), bytes.size());
+    return bytes;
 }
 
-uint32_t
-Gpx::BitStream::readInt()
+Gpx::BitStream::BitStream(std::istream &stream) : BitStream(readAll(stream))
 {
-    assert(myPosition % BYTE_LENGTH == 0);
-
-    const uint32_t value =
-        Gpx::Util::readUInt(myBytes, myPosition / BYTE_LENGTH);
-    myPosition += sizeof(uint32_t) * BYTE_LENGTH;
-    return value;
 }
 
-bool
-Gpx::BitStream::readBit()
+Gpx::BitStream::BitStream(std::vector<std::byte> bytes)
+    : myBytes(std::move(bytes)), myNextByte(0), myBuffer(0), myBufferedBits(0)
 {
-    if (myPosition / BYTE_LENGTH >= myBytes.size())
-        return 0;
-
-    std::byte byte = myBytes[myPosition / BYTE_LENGTH];
-    byte >>= ((BYTE_LENGTH - 1) - (myPosition % BYTE_LENGTH));
-    byte &= std::byte{ 0x01 };
-
-    ++myPosition;
-
-    return byte != std::byte{ 0 };
 }
 
-int32_t
-Gpx::BitStream::readBits(int n, BitOrder order)
+void
+Gpx::BitStream::refill()
 {
-    int32_t value = 0;
-
-    if (order == Reversed)
+    if (myNextByte + sizeof(uint64_t) <= myBytes.size())
     {
-        for (int i = 0; i < n; ++i)
-            value |= (readBit() << i);
+        // Load the next 8 bytes in big-endian order, and keep as many whole
+        // bytes as there is room for.
+        uint64_t word = 0;
+        for (size_t i = 0; i < sizeof(uint64_t); ++i)
+        {
+            word = (word << BYTE_LENGTH) |
+                   std::to_integer<uint64_t>(myBytes[myNextByte + i]);
+        }
+
+        const int num_bytes = (64 - myBufferedBits) / BYTE_LENGTH;
+        myBuffer |= word >> myBufferedBits;
+        myNextByte += num_bytes;
+        myBufferedBits += num_bytes * BYTE_LENGTH;
+
+        // Clear the bits of the partially loaded byte, which is loaded again
+        // by the next refill.
+        if (myBufferedBits < 64)
+            myBuffer &= ~(~uint64_t(0) >> myBufferedBits);
     }
     else
     {
-        for (int i = n - 1; i >= 0; --i)
-            value |= (readBit() << i);
+        // Near the end of the input, load one byte at a time. Any bits past
+        // the end are zero.
+        while (myBufferedBits <= 64 - static_cast<int>(BYTE_LENGTH))
+        {
+            const uint64_t byte =
+                (myNextByte < myBytes.size())
+                    ? std::to_integer<uint64_t>(myBytes[myNextByte])
+                    : 0;
+            myBuffer |= byte << (64 - BYTE_LENGTH - myBufferedBits);
+            ++myNextByte;
+            myBufferedBits += BYTE_LENGTH;
+        }
     }
+}
+
+uint32_t
+Gpx::BitStream::reverseBits(uint32_t value, int n)
+{
+    const uint32_t reversed =
+        (uint32_t(THE_REVERSED_BYTES[value & 0xff]) << 24) |
+        (uint32_t(THE_REVERSED_BYTES[(value >> 8) & 0xff]) << 16) |
+        (uint32_t(THE_REVERSED_BYTES[(value >> 16) & 0xff]) << 8) |
+        uint32_t(THE_REVERSED_BYTES[value >> 24]);
+    return reversed >> (32 - n);
+}
+
+uint32_t
+Gpx::BitStream::readInt()
+{
+    assert(myBufferedBits % BYTE_LENGTH == 0);
+
+    // The integer is stored in little-endian order.
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < sizeof(uint32_t); ++i)
+        value |= static_cast<uint32_t>(readBits(BYTE_LENGTH)) << (i * BYTE_LENGTH);
 
     return value;
 }
@@ -81,7 +128,7 @@ Gpx::BitStream::readBits(int n, BitOrder order)
 size_t
 Gpx::BitStream::getLocation() const
 {
-    return myPosition / BYTE_LENGTH;
+    return (myNextByte * BYTE_LENGTH - myBufferedBits) / BYTE_LENGTH;
 }
 
 bool
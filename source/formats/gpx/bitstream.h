@@ -28,6 +28,9 @@ namespace Gpx
 
 /// Provides the ability to read individual bits from a stream.
 /// This is required for the compression scheme used in .gpx files.
+///
+/// Bits are read from a 64-bit buffer, which is refilled a word at a time,
+/// rather than reading each bit from the input separately.
 class BitStream
 {
 public:
@@ -38,16 +41,34 @@ public:
     };
 
     BitStream(std::istream &stream);
+    BitStream(std::vector<std::byte> bytes);
 
     /// Reads a 32-bit unsigned integer from the stream. This assumes that the
     /// stream position is exactly on the start of a byte.
     uint32_t readInt();
 
     /// Reads the next bit from the stream.
-    bool readBit();
+    bool readBit() { return readBits(1) != 0; }
 
-    /// Reads the next n bits from the stream into an integer.
-    int32_t readBits(int n, BitOrder = Normal);
+    /// Reads the next n bits (at most 32) from the stream into an integer.
+    /// Bits past the end of the stream are read as zero.
+    int32_t readBits(int n, BitOrder order = Normal)
+    {
+        if (n == 0)
+            return 0;
+
+        if (myBufferedBits < n)
+            refill();
+
+        uint32_t value = static_cast<uint32_t>(myBuffer >> (64 - n));
+        myBuffer <<= n;
+        myBufferedBits -= n;
+
+        if (order == Reversed)
+            value = reverseBits(value, n);
+
+        return static_cast<int32_t>(value);
+    }
 
     /// Returns the position in the stream (measured in bytes).
     size_t getLocation() const;
@@ -56,10 +77,19 @@ public:
     bool isAtEnd() const;
 
 private:
-    /// The current position in the input (measured in bits).
-    size_t myPosition;
+    /// Tops up the buffer so that it has at least 57 unread bits.
+    void refill();
+
+    /// Reverses the order of the lowest n bits.
+    static uint32_t reverseBits(uint32_t value, int n);
+
     /// The compressed data being read.
     std::vector<std::byte> myBytes;
+    /// The index of the next byte to be loaded into the buffer.
+    size_t myNextByte;
+    /// The unread bits, starting from the most significant bit.
+    uint64_t myBuffer;
+    int myBufferedBits;
 };
 
 } // namespace Gpx
@@ -30,6 +30,8 @@ enum ChunkHeader
 };
 
 static const uint32_t SECTOR_SIZE = 0x1000;
+/// The size of the BCFS header at the start of the uncompressed data.
+static const size_t HEADER_SIZE = 4;
 
 Gpx::FileSystem::FileSystem(std::istream &stream)
 {
@@ -46,8 +48,15 @@ Gpx::FileSystem::FileSystem(std::istream &stream)
         throw FileFormatException("Invalid header");
 
     const uint32_t length = input.readInt();
-    std::vector<std::byte> output;
-    output.reserve(length);
+
+    // Preallocate the output, and track the amount of data that has been
+    // written so far.
+    std::vector<std::byte> output(length);
+    size_t outputSize = 0;
+    auto ensureCapacity = [&](size_t n) {
+        if (outputSize + n > output.size())
+            output.resize(std::max(outputSize + n, 2 * output.size()));
+    };
 
     // We now have a succession of compressed and uncompressed chunks.
     while (!input.isAtEnd() && input.getLocation() < length)
@@ -62,10 +71,11 @@ Gpx::FileSystem::FileSystem(std::istream &stream)
             const int32_t rawLength =
                 input.readBits(2, Gpx::BitStream::Reversed);
 
+            ensureCapacity(rawLength);
             for (int32_t i = 0; i < rawLength; ++i)
             {
-                output.push_back(
-                    std::byte{ static_cast<uint8_t>(input.readBits(8)) });
+                output[outputSize++] =
+                    std::byte{ static_cast<uint8_t>(input.readBits(8)) };
             }
         }
         // For a compressed chunk, we have a 4-bit integer giving a length P,
@@ -77,84 +87,121 @@ Gpx::FileSystem::FileSystem(std::istream &stream)
         {
             const int32_t p = input.readBits(4);
             const int32_t offset = input.readBits(p, Gpx::BitStream::Reversed);
-            const size_t startPos = output.size() - offset;
+            if (static_cast<size_t>(offset) > outputSize)
+                throw FileFormatException("Invalid GPX compressed data");
+
+            const size_t startPos = outputSize - offset;
 
             const int32_t length = std::clamp<int32_t>(
                 input.readBits(p, Gpx::BitStream::Reversed), 0, offset);
 
-            std::copy(output.begin() + startPos,
-                      output.begin() + startPos + length,
-                      std::back_inserter(output));
+            // Since the length is at most the offset, the source and
+            // destination ranges never overlap and can be copied as a block.
+            ensureCapacity(length);
+            std::copy_n(output.begin() + startPos, length,
+                        output.begin() + outputSize);
+            outputSize += length;
         }
     }
 
+    output.resize(outputSize);
+    if (output.size() < HEADER_SIZE)
+        throw FileFormatException("Invalid GPX Format");
+
     // The data we just read should now have a header indicating that it's
     // uncompressed!
     const uint32_t newHeader = Gpx::Util::readUInt(output, 0);
     if (newHeader != BCFS_HEADER)
         throw FileFormatException("Invalid GPX Format");
 
-    readUncompressedData(output);
+    myData = std::move(output);
+    readDirectory();
 }
 
-const std::vector<std::byte> &
+std::vector<std::byte>
 Gpx::FileSystem::getFileContents(const std::string &filename) const
 {
     auto it = myFiles.find(filename);
     if (it == myFiles.end())
         throw FileFormatException("Invalid filename");
-    else
-        return it->second;
+
+    const FileEntry &entry = it->second;
+    std::vector<std::byte> contents(entry.mySize);
+
+    size_t position = 0;
+    for (size_t sector : entry.mySectors)
+    {
+        if (position == contents.size())
+            break;
+
+        const size_t n = std::min<size_t>(
+            {SECTOR_SIZE, myData.size() - sector, contents.size() - position});
+        std::copy_n(myData.begin() + sector, n, contents.begin() + position);
+        position += n;
+    }
+
+    return contents;
 }
 
 void
-Gpx::FileSystem::readUncompressedData(std::vector<std::byte> &data)
+Gpx::FileSystem::readDirectory()
 {
-    // Remove the BCFS header.
-    data.erase(data.begin(), data.begin() + 4);
+    // Sector offsets are relative to the end of the BCFS header.
+    auto sectorStart = [](size_t sector) {
+        return HEADER_SIZE + sector * SECTOR_SIZE;
+    };
+    auto readUInt = [&](size_t index) {
+        if (index + sizeof(uint32_t) > myData.size())
+            throw FileFormatException("Invalid GPX Format");
+        return Util::readUInt(myData, index);
+    };
+
     size_t offset = 0;
 
-    // Read all files from the file system.
-    while ((offset = (offset + SECTOR_SIZE)) + 3 < data.size())
+    // Read the directory entries for all files in the file system.
+    while ((offset = (offset + SECTOR_SIZE)) + HEADER_SIZE + 3 < myData.size())
     {
-        if (Util::readUInt(data, offset) == 2)
+        const size_t entryStart = HEADER_SIZE + offset;
+        if (Util::readUInt(myData, entryStart) == 2)
         {
-            const size_t fileNameIndex = offset + 4;
-            const size_t fileSizeIndex = offset + 0x8C;
-            const size_t blockIndex = offset + 0x94;
+            const size_t fileNameIndex = entryStart + 4;
+            const size_t fileSizeIndex = entryStart + 0x8C;
+            const size_t blockIndex = entryStart + 0x94;
 
-            int block = 0;
+            uint32_t block = 0;
             int blockCount = 0;
-            std::vector<std::byte> file_data;
+            FileEntry entry;
+            size_t availableSize = 0;
 
-            // Read the file data.
-            while ((block =
-                        Util::readUInt(data, blockIndex + 4 * blockCount)) != 0)
+            // Record the sectors containing the file data.
+            while ((block = readUInt(blockIndex + 4 * blockCount)) != 0)
             {
                 offset = block * SECTOR_SIZE;
-                std::copy(data.begin() + offset,
-                          data.begin() +
-                              std::clamp<size_t>(offset + SECTOR_SIZE, 0,
-                                                 data.size()),
-                          std::back_inserter(file_data));
+
+                const size_t start = sectorStart(block);
+                if (start < myData.size())
+                {
+                    entry.mySectors.push_back(start);
+                    availableSize +=
+                        std::min<size_t>(SECTOR_SIZE, myData.size() - start);
+                }
                 ++blockCount;
             }
 
-            // Read the file name and save the file.
-            const uint32_t fileSize = Util::readUInt(data, fileSizeIndex);
-            if (file_data.size() >= fileSize)
+            // Read the file name and record the file.
+            entry.mySize = readUInt(fileSizeIndex);
+            if (availableSize >= entry.mySize)
             {
                 std::string fileName;
-                std::transform(data.begin() + fileNameIndex,
-                               data.begin() + fileNameIndex + 127,
+                std::transform(myData.begin() + fileNameIndex,
+                               myData.begin() + fileNameIndex + 127,
                                std::back_inserter(fileName), [](std::byte b) {
                                    return std::to_integer<char>(b);
                                });
                 // Trim extra NULL characters.
                 fileName.erase(fileName.find_last_not_of('\0') + 1);
 
-                file_data.resize(fileSize);
-                myFiles[fileName] = std::move(file_data);
+                myFiles[fileName] = std::move(entry);
             }
         }
     }
@@ -31,19 +31,30 @@ namespace Gpx
 /// The uncompressed *.gpx file is essentially a filesystem containing several
 /// xml files.
 /// This class handles the extraction of information from that filesystem.
+/// Only the directory is read up front, and a file's contents are gathered
+/// from its sectors when it is requested.
 class FileSystem
 {
 public:
     FileSystem(std::istream &stream);
 
-    const std::vector<std::byte> &getFileContents(
-        const std::string &filename) const;
+    /// Returns the contents of the file, gathered into a single buffer.
+    std::vector<std::byte> getFileContents(const std::string &filename) const;
 
 private:
-    void readUncompressedData(std::vector<std::byte> &data);
-
-    /// Maps filenames to file contents.
-    std::unordered_map<std::string, std::vector<std::byte>> myFiles;
+    struct FileEntry
+    {
+        /// The offsets of the file's sectors in the uncompressed data.
+        std::vector<size_t> mySectors;
+        uint32_t mySize;
+    };
+
+    void readDirectory();
+
+    /// The uncompressed filesystem data.
+    std::vector<std::byte> myData;
+    /// Maps filenames to the location of their contents.
+    std::unordered_map<std::string, FileEntry> myFiles;
 };
 
 } // namespace Gpx
@@ -0,0 +1,765 @@
+/*
+ * Copyright (C) 2020 Cameron White
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "converter.h"
+#include "document.h"
+
+#include <algorithm>
+#include <bitset>
+#include <boost/algorithm/string/join.hpp>
+#include <cmath>
+#include <optional>
+
+#include <formats/gp7/converter.h>
+#include <formats/gp7/parser.h>
+#include <score/playerchange.h>
+#include <score/position.h>
+#include <score/score.h>
+#include <score/system.h>
+#include <score/textitem.h>
+#include <score/utils.h>
+#include <score/utils/scorepolisher.h>
+
+// The notes, bends, barlines, etc are converted to the Guitar Pro 7 format one
+// beat or measure at a time, and then converted into the score using the same
+// functions as the Guitar Pro 7 converter. Only the master bars are kept for
+// the whole document, since they're needed for the key / time signature
+// changes between systems.
+
+/// A beat in the Guitar Pro 7 format.
+struct Gp7Beat
+{
+    Gp7::Beat myBeat;
+    Gp7::Rhythm myRhythm;
+    std::vector<Gp7::Note> myNotes;
+};
+
+static Gp7::ScoreInfo
+convertScoreInfo(const Gp::Document &doc)
+{
+    const Gp::Header &header = doc.myHeader;
+
+    Gp7::ScoreInfo gp7_info;
+    gp7_info.myTitle = header.myTitle;
+    gp7_info.mySubtitle = header.mySubtitle;
+    gp7_info.myArtist = header.myArtist;
+    gp7_info.myAlbum = header.myAlbum;
+    gp7_info.myWords = header.myLyricist;
+    gp7_info.myMusic = header.myComposer;
+    gp7_info.myCopyright = header.myCopyright;
+    gp7_info.myTabber = header.myTranscriber;
+    gp7_info.myInstructions = header.myInstructions;
+    gp7_info.myNotices = boost::algorithm::join(header.myNotices, "\n");
+
+    // TODO - convert lyrics.
+
+    return gp7_info;
+}
+
+static std::vector<Gp7::Track>
+convertTracks(const Gp::Document &doc)
+{
+    std::vector<Gp7::Track> gp7_tracks;
+
+    for (const Gp::Track &track : doc.myTracks)
+    {
+        Gp7::Track gp7_track;
+        gp7_track.myName = track.myName;
+
+        Gp7::Staff staff;
+        staff.myCapo = track.myCapo;
+        for (uint8_t note : track.myTuning)
+            staff.myTuning.push_back(note);
+        // The string numbers are flipped around in GP7.
+        std::reverse(staff.myTuning.begin(), staff.myTuning.end());
+
+        gp7_track.myStaves = { staff };
+
+        const Gp::Channel &channel = doc.myChannels.at(track.myChannelIndex);
+        Gp7::Sound sound;
+        sound.myLabel = track.myName;
+        sound.myMidiPreset = channel.myInstrument;
+        gp7_track.mySounds = { sound };
+
+        gp7_tracks.push_back(gp7_track);
+    }
+
+    return gp7_tracks;
+}
+
+/// String numbers are reversed in GP7.
+static int
+convertStringNumber(const Gp::Track &track, int string)
+{
+    return static_cast<int>(track.myTuning.size()) - string - 1;
+}
+
+/// Returns the note with a grace note, if there is one. Only one grace note
+/// is imported for each beat.
+static const Gp::Note *
+findGraceNote(const Gp::Beat &beat)
+{
+    for (const Gp::Note &note : beat.myNotes)
+    {
+        if (note.myGraceNote)
+            return &note;
+    }
+
+    return nullptr;
+}
+
+/// Returns the note on the specified string, if there is one.
+static const Gp::Note *
+findNote(const Gp::Beat &beat, int string)
+{
+    for (const Gp::Note &note : beat.myNotes)
+    {
+        if (note.myString == string)
+            return &note;
+    }
+
+    return nullptr;
+}
+
+/// Returns the beats for a voice of the measure.
+static const std::vector<Gp::Beat> &
+getBeats(const Gp::Document &doc, int measure_idx, int staff_idx,
+         int voice_idx)
+{
+    return doc.myMeasures[measure_idx].myStaves[staff_idx].myVoices[voice_idx];
+}
+
+/// Finds the fret of the note that a tied note continues from, by searching
+/// back through the voice (grace notes are played before their beat). Tied
+/// notes inherit their fret from the previous note, and don't always have a
+/// correct fret number stored in the GP3/4/5 file.
+/// @returns Nothing if there isn't an earlier note on the string.
+static std::optional<int>
+findTiedFret(const Gp::Document &doc, int measure_idx, int staff_idx,
+             int voice_idx, int beat_idx, int string)
+{
+    std::optional<int> fret;
+
+    for (int m = measure_idx; m >= 0; --m)
+    {
+        const std::vector<Gp::Beat> &beats =
+            getBeats(doc, m, staff_idx, voice_idx);
+        const int last_beat = (m == measure_idx)
+                                  ? beat_idx
+                                  : static_cast<int>(beats.size()) - 1;
+
+        for (int b = last_beat; b >= 0; --b)
+        {
+            const Gp::Beat &beat = beats[b];
+            if (beat.myIsEmpty)
+                continue;
+
+            // Only the grace note comes before the tied note in its own beat.
+            if (m != measure_idx || b != beat_idx)
+            {
+                if (const Gp::Note *note = findNote(beat, string))
+                {
+                    // If the previous note is also tied, its fret comes from
+                    // an earlier note.
+                    fret = note->myFret;
+                    if (!note->myIsTied)
+                        return fret;
+                }
+            }
+
+            const Gp::Note *grace_note = findGraceNote(beat);
+            if (grace_note && grace_note->myString == string)
+                return grace_note->myGraceNote->myFret;
+        }
+    }
+
+    return fret;
+}
+
+/// Returns whether the next note on the string is tied to the note.
+static bool
+isTieOrigin(const Gp::Document &doc, int measure_idx, int staff_idx,
+            int voice_idx, int beat_idx, int string)
+{
+    const int num_measures = static_cast<int>(doc.myMeasures.size());
+    for (int m = measure_idx; m < num_measures; ++m)
+    {
+        const std::vector<Gp::Beat> &beats =
+            getBeats(doc, m, staff_idx, voice_idx);
+        const int num_beats = static_cast<int>(beats.size());
+
+        for (int b = (m == measure_idx) ? beat_idx + 1 : 0; b < num_beats; ++b)
+        {
+            const Gp::Beat &beat = beats[b];
+            if (beat.myIsEmpty)
+                continue;
+
+            const Gp::Note *grace_note = findGraceNote(beat);
+            if (grace_note && grace_note->myString == string)
+                return false;
+
+            if (const Gp::Note *note = findNote(beat, string))
+                return note->myIsTied;
+        }
+    }
+
+    return false;
+}
+
+static void
+convertGraceNote(const Gp::Note &note, const Gp::Track &track,
+                 Gp7Beat &gp7_beat)
+{
+    gp7_beat.myBeat = Gp7::Beat();
+    gp7_beat.myBeat.myGraceNote = true;
+
+    gp7_beat.myRhythm = Gp7::Rhythm();
+    gp7_beat.myRhythm.myDuration = note.myGraceNote->myDuration;
+
+    Gp7::Note gp7_note;
+    gp7_note.myString = convertStringNumber(track, note.myString);
+    gp7_note.myFret = note.myGraceNote->myFret;
+
+    switch (note.myGraceNote->myTransition)
+    {
+        case Gp::GraceNote::HammerTransition:
+            gp7_note.myHammerOn = true;
+            break;
+        case Gp::GraceNote::SlideTransition:
+            gp7_note.mySlideTypes.set(int(Gp7::Note::SlideType::Shift));
+            break;
+        default:
+            break;
+    }
+
+    gp7_beat.myNotes.clear();
+    gp7_beat.myNotes.push_back(std::move(gp7_note));
+}
+
+static void
+convertBend(Gp7::Note &gp7_note, const Gp::Note &note)
+{
+    using Point = Gp::Bend::Point;
+
+    Gp7::Note::Bend gp7_bend;
+    const Gp::Bend &bend = *note.myBend;
+    const std::vector<Point> &points = bend.myPoints;
+    assert(points.size() >= 2);
+
+    // Default output: just use the first and last points as the origin / dest.
+    gp7_bend.myOriginValue = points.front().myValue;
+    gp7_bend.myOriginOffset = points.front().myOffset;
+    gp7_bend.myDestValue = points.back().myValue;
+    gp7_bend.myDestOffset = points.back().myOffset;
+
+    // Try to find a middle region.
+    const int start_value = points.front().myValue;
+    const int end_value = points.back().myValue;
+    auto middle_1 =
+        std::find_if(points.begin(), points.end(), [&](const Point &point) {
+            return point.myValue != start_value;
+        });
+
+    if (middle_1 != points.end())
+    {
+        const int middle_value = middle_1->myValue;
+        auto dest =
+            std::find_if(middle_1, points.end(), [&](const Point &point) {
+                return point.myValue != middle_value;
+            });
+
+        if (dest != points.end())
+        {
+            auto middle_2 = std::prev(dest);
+
+            gp7_bend.myMiddleOffset1 = middle_1->myOffset;
+            gp7_bend.myMiddleOffset2 = middle_2->myOffset;
+            gp7_bend.myMiddleValue = middle_value;
+
+            auto origin = std::prev(middle_1);
+            assert(origin->myValue == start_value);
+            gp7_bend.myOriginOffset = origin->myOffset;
+            assert(dest->myValue == end_value);
+            gp7_bend.myDestOffset = dest->myOffset;
+        }
+    }
+
+    gp7_note.myBend = gp7_bend;
+}
+
+static void
+convertNote(const Gp::Beat &beat, const Gp::Note &note,
+            const Gp::Track &track, Gp7::Note &gp7_note)
+{
+    // The string numbers are reversed in GP7.
+    gp7_note.myString = convertStringNumber(track, note.myString);
+    gp7_note.myFret = note.myFret;
+
+    gp7_note.myPalmMuted = note.myHasPalmMute;
+    gp7_note.myMuted = note.myIsMuted;
+    gp7_note.myGhost = note.myIsGhostNote;
+    gp7_note.myTapped = beat.myIsTapped;
+    gp7_note.myHammerOn = note.myIsHammerOnOrPullOff;
+    gp7_note.myVibrato = beat.myIsVibrato || note.myIsVibrato;
+    gp7_note.myWideVibrato = beat.myIsWideVibrato;
+    gp7_note.myLetRing = note.myIsLetRing;
+
+    if (note.myIsStaccato)
+        gp7_note.myAccentTypes.set(int(Gp7::Note::AccentType::Staccato));
+
+    if (note.myHasHeavyAccent)
+        gp7_note.myAccentTypes.set(int(Gp7::Note::AccentType::HeavyAccent));
+    else if (note.myHasAccent)
+        gp7_note.myAccentTypes.set(int(Gp7::Note::AccentType::Accent));
+
+    if (beat.myIsNaturalHarmonic || note.myIsNaturalHarmonic)
+        gp7_note.myHarmonic = Gp7::Note::HarmonicType::Natural;
+
+    if (beat.myIsArtificialHarmonic)
+    {
+        // GP3 artificial harmonics don't specify a pitch.
+        gp7_note.myHarmonic = Gp7::Note::HarmonicType::Artificial;
+        gp7_note.myHarmonicFret = 12;
+    }
+    else if (note.myIsArtificialHarmonic)
+    {
+        gp7_note.myHarmonic = Gp7::Note::HarmonicType::Artificial;
+        gp7_note.myHarmonicFret = note.myHarmonicFret;
+    }
+
+    if (note.myIsTappedHarmonic)
+    {
+        gp7_note.myHarmonic = Gp7::Note::HarmonicType::Tap;
+        gp7_note.myHarmonicFret = note.myHarmonicFret;
+    }
+
+    if (note.myIsShiftSlide)
+        gp7_note.mySlideTypes.set(int(Gp7::Note::SlideType::Shift));
+    if (note.myIsLegatoSlide)
+        gp7_note.mySlideTypes.set(int(Gp7::Note::SlideType::Legato));
+    if (note.myIsSlideInAbove)
+        gp7_note.mySlideTypes.set(int(Gp7::Note::SlideType::SlideInAbove));
+    if (note.myIsSlideInBelow)
+        gp7_note.mySlideTypes.set(int(Gp7::Note::SlideType::SlideInBelow));
+    if (note.myIsSlideOutUp)
+        gp7_note.mySlideTypes.set(int(Gp7::Note::SlideType::SlideOutUp));
+    if (note.myIsSlideOutDown)
+        gp7_note.mySlideTypes.set(int(Gp7::Note::SlideType::SlideOutDown));
+
+    if (note.myTrilledFret)
+    {
+        // In GP7, the MIDI note value is stored, not the fret number.
+        gp7_note.myTrillNote =
+            *note.myTrilledFret + track.myTuning[note.myString];
+    }
+
+    if (note.myLeftFinger)
+    {
+        switch (*note.myLeftFinger)
+        {
+            case 1:
+                gp7_note.myLeftFinger = Gp7::Note::FingerType::I;
+                break;
+            case 2:
+                gp7_note.myLeftFinger = Gp7::Note::FingerType::M;
+                break;
+            case 3:
+                gp7_note.myLeftFinger = Gp7::Note::FingerType::A;
+                break;
+            case 4:
+                gp7_note.myLeftFinger = Gp7::Note::FingerType::C;
+                break;
+            case 0:
+                gp7_note.myLeftFinger = Gp7::Note::FingerType::P;
+                break;
+            case -1:
+            default:
+                gp7_note.myLeftFinger = Gp7::Note::FingerType::Open;
+                break;
+        }
+    }
+
+    if (note.myBend)
+        convertBend(gp7_note, note);
+}
+
+static void
+convertBeat(const Gp::Document &doc, int measure_idx, int staff_idx,
+            int voice_idx, int beat_idx, Gp7Beat &gp7_beat)
+{
+    const Gp::Track &track = doc.myTracks[staff_idx];
+    const Gp::Beat &beat =
+        getBeats(doc, measure_idx, staff_idx, voice_idx)[beat_idx];
+
+    gp7_beat.myRhythm = Gp7::Rhythm();
+    gp7_beat.myRhythm.myDuration = beat.myDuration;
+    if (beat.myIsDotted)
+        gp7_beat.myRhythm.myDots = 1;
+
+    if (beat.myIrregularGrouping)
+    {
+        Gp7::Rhythm &rhythm = gp7_beat.myRhythm;
+        rhythm.myTupletNum = *beat.myIrregularGrouping;
+        // The denominator of the irregular grouping is the nearest power of 2
+        // (from below).
+        rhythm.myTupletDenom = static_cast<int>(std::pow(
+            2, std::floor(std::log(rhythm.myTupletNum) / std::log(2.0))));
+    }
+
+    Gp7::Beat &gp7_beat_info = gp7_beat.myBeat;
+    gp7_beat_info = Gp7::Beat();
+
+    if (beat.myOctave8va)
+        gp7_beat_info.myOttavia = Gp7::Beat::Ottavia::O8va;
+    else if (beat.myOctave8vb)
+        gp7_beat_info.myOttavia = Gp7::Beat::Ottavia::O8vb;
+    else if (beat.myOctave15ma)
+        gp7_beat_info.myOttavia = Gp7::Beat::Ottavia::O15ma;
+    else if (beat.myOctave15mb)
+        gp7_beat_info.myOttavia = Gp7::Beat::Ottavia::O15mb;
+
+    gp7_beat_info.myTremoloPicking = beat.myIsTremoloPicked;
+    gp7_beat_info.myBrushUp = beat.myPickstrokeUp;
+    gp7_beat_info.myBrushDown = beat.myPickstrokeDown;
+    if (beat.myText)
+        gp7_beat_info.myFreeText = *beat.myText;
+
+    gp7_beat.myNotes.clear();
+    for (const Gp::Note &note : beat.myNotes)
+    {
+        Gp7::Note gp7_note;
+        convertNote(beat, note, track, gp7_note);
+
+        if (note.myIsTied)
+        {
+            std::optional<int> fret =
+                findTiedFret(doc, measure_idx, staff_idx, voice_idx, beat_idx,
+                             note.myString);
+            assert(fret);
+            if (fret)
+            {
+                gp7_note.myFret = *fret;
+                gp7_note.myTieDest = true;
+            }
+        }
+
+        // This only affects how bends are converted, so avoid searching
+        // through the rest of the voice otherwise.
+        if (note.myBend)
+        {
+            gp7_note.myTieOrigin =
+                isTieOrigin(doc, measure_idx, staff_idx, voice_idx, beat_idx,
+                            note.myString);
+        }
+
+        if (note.myIsTremoloPicked)
+            gp7_beat_info.myTremoloPicking = true;
+
+        gp7_beat.myNotes.push_back(std::move(gp7_note));
+    }
+}
+
+static std::vector<Gp7::MasterBar>
+convertMasterBars(const Gp::Document &doc)
+{
+    std::vector<Gp7::MasterBar> master_bars;
+    master_bars.reserve(doc.myMeasures.size());
+
+    for (const Gp::Measure &measure : doc.myMeasures)
+    {
+        Gp7::MasterBar master_bar;
+        master_bar.myDoubleBar = measure.myIsDoubleBar;
+        master_bar.myRepeatStart = measure.myIsRepeatBegin;
+        master_bar.myRepeatEnd = measure.myRepeatEnd.has_value();
+        if (master_bar.myRepeatEnd)
+            master_bar.myRepeatCount = *measure.myRepeatEnd;
+
+        if (measure.myMarker)
+        {
+            Gp7::MasterBar::Section section;
+            section.myText = *measure.myMarker;
+            master_bar.mySection = section;
+        }
+
+        // Copy key signature from the previous bar if there isn't a key change.
+        const Gp7::MasterBar *prev_master_bar =
+            !master_bars.empty() ? &master_bars.back() : nullptr;
+
+        if (measure.myKeyChange)
+        {
+            const int accidentals = measure.myKeyChange->myAccidentals;
+            master_bar.myKeySig.myAccidentalCount = std::abs(accidentals);
+            master_bar.myKeySig.mySharps = accidentals >= 0;
+            master_bar.myKeySig.myMinor = measure.myKeyChange->myIsMinor;
+        }
+        else if (prev_master_bar)
+            master_bar.myKeySig = prev_master_bar->myKeySig;
+        else
+        {
+            master_bar.myKeySig.myAccidentalCount = std::abs(doc.myInitialKey);
+            master_bar.myKeySig.mySharps = doc.myInitialKey >= 0;
+        }
+
+        if (measure.myTimeSignatureChange)
+        {
+            master_bar.myTimeSig.myBeats =
+                measure.myTimeSignatureChange->myNumerator;
+            master_bar.myTimeSig.myBeatValue =
+                measure.myTimeSignatureChange->myDenominator;
+        }
+        else if (prev_master_bar)
+            master_bar.myTimeSig = prev_master_bar->myTimeSig;
+
+        // Initial tempo. Later tempo changes are stored on the beats.
+        if (master_bars.empty())
+        {
+            Gp7::TempoChange tempo_change;
+            tempo_change.myBeatsPerMinute = doc.myStartTempo;
+            tempo_change.myDescription = doc.myStartTempoName;
+            tempo_change.myIsVisible = doc.myStartTempoVisible;
+            master_bar.myTempoChanges.push_back(tempo_change);
+        }
+
+        if (measure.myAlternateEnding)
+        {
+            // Each bit represents an alternate ending from 1 to 8.
+            static constexpr int num_bits = 8;
+            std::bitset<num_bits> bits(*measure.myAlternateEnding);
+            for (int i = 0; i < num_bits; ++i)
+            {
+                if (bits.test(i))
+                    master_bar.myAlternateEndings.push_back(i + 1);
+            }
+        }
+
+        // Add tempo changes to the measure.
+        // TODO - set the position fraction for tempo changes that occur during
+        // the bar. When this is supported by the GP7 converter, enable the
+        // unit tests for this.
+        for (const Gp::Staff &staff : measure.myStaves)
+        {
+            for (const std::vector<Gp::Beat> &voice : staff.myVoices)
+            {
+                for (const Gp::Beat &beat : voice)
+                {
+                    if (beat.myIsEmpty || !beat.myTempoChange)
+                        continue;
+
+                    Gp7::TempoChange tempo_change;
+                    tempo_change.myBeatsPerMinute = *beat.myTempoChange;
+                    tempo_change.myDescription = beat.myTempoChangeName;
+                    master_bar.myTempoChanges.push_back(tempo_change);
+                }
+            }
+        }
+
+        master_bars.push_back(std::move(master_bar));
+    }
+
+    return master_bars;
+}
+
+static void
+convertDirections(const Gp::DirectionMap &dirs,
+                  std::vector<Gp7::MasterBar> &master_bars)
+{
+    using Target = Gp7::MasterBar::DirectionTarget;
+    auto convertTarget = [&](int index, Target target) {
+        if (index >= 0)
+            master_bars[index].myDirectionTargets.push_back(target);
+    };
+
+    convertTarget(dirs.myCoda, Target::Coda);
+    convertTarget(dirs.myDoubleCoda, Target::DoubleCoda);
+    convertTarget(dirs.mySegno, Target::Segno);
+    convertTarget(dirs.mySegnoSegno, Target::SegnoSegno);
+    convertTarget(dirs.myFine, Target::Fine);
+
+    using Jump = Gp7::MasterBar::DirectionJump;
+    auto convertJump = [&](int index, Jump jump) {
+        if (index >= 0)
+            master_bars[index].myDirectionJumps.push_back(jump);
+    };
+
+    convertJump(dirs.myDaCapo, Jump::DaCapo);
+    convertJump(dirs.myDaCapoAlCoda, Jump::DaCapoAlCoda);
+    convertJump(dirs.myDaCapoAlDoubleCoda, Jump::DaCapoAlDoubleCoda);
+    convertJump(dirs.myDaCapoAlFine, Jump::DaCapoAlFine);
+    convertJump(dirs.myDaSegno, Jump::DaSegno);
+    convertJump(dirs.myDaSegnoAlCoda, Jump::DaSegnoAlCoda);
+    convertJump(dirs.myDaSegnoAlDoubleCoda, Jump::DaSegnoAlDoubleCoda);
+    convertJump(dirs.myDaSegnoAlFine, Jump::DaSegnoAlFine);
+    convertJump(dirs.myDaSegnoSegno, Jump::DaSegnoSegno);
+    convertJump(dirs.myDaSegnoSegnoAlCoda, Jump::DaSegnoSegnoAlCoda);
+    convertJump(dirs.myDaSegnoSegnoAlDoubleCoda,
+                Jump::DaSegnoSegnoAlDoubleCoda);
+    convertJump(dirs.myDaSegnoSegnoAlFine, Jump::DaSegnoSegnoAlFine);
+    convertJump(dirs.myDaCoda, Jump::DaCoda);
+    convertJump(dirs.myDaDoubleCoda, Jump::DaDoubleCoda);
+}
+
+/// Converts the beat into a position in the voice.
+static void
+insertBeat(System &system, Voice &voice, const Tuning &tuning,
+           const Gp7Beat &gp7_beat, int &voice_pos,
+           std::vector<Gp7::Rhythm> &gp_rhythms)
+{
+    gp_rhythms.push_back(gp7_beat.myRhythm);
+
+    // Create a text item in the system if necessary.
+    if (!gp7_beat.myBeat.myFreeText.empty())
+        system.insertTextItem(TextItem(voice_pos, gp7_beat.myBeat.myFreeText));
+
+    Position pos = Gp7::convertPosition(gp7_beat.myBeat, gp7_beat.myRhythm);
+    pos.setPosition(voice_pos++);
+
+    // Flag as a rest if there are no notes.
+    if (gp7_beat.myNotes.empty())
+        pos.setRest();
+
+    for (const Gp7::Note &gp_note : gp7_beat.myNotes)
+    {
+        Note note = Gp7::convertNote(pos, gp7_beat.myBeat, gp_note, tuning);
+        if (!Utils::findByString(pos, note.getString()))
+            pos.insertNote(note);
+    }
+
+    Gp7::insertPosition(voice, pos, gp7_beat.myRhythm);
+}
+
+/// Converts a range of measures into a system. This only reads from the
+/// document and the score's players, so multiple systems can be converted in
+/// parallel.
+static System
+convertSystem(const Gp::Document &doc,
+              const std::vector<Gp7::MasterBar> &master_bars,
+              const Score &score, int bar_begin, int bar_end)
+{
+    System system;
+
+    // Create a staff for each player.
+    for (auto &&player : score.getPlayers())
+        system.insertStaff(Staff(player.getTuning().getStringCount()));
+
+    Gp7Beat gp7_beat;
+    std::vector<Gp7::Rhythm> gp_rhythms;
+    int start_pos = 0;
+    int system_bar_idx = 0;
+    for (int bar_idx = bar_begin; bar_idx < bar_end; ++bar_idx)
+    {
+        const int num_staves = static_cast<int>(score.getPlayers().size());
+        const Gp7::MasterBar &master_bar = master_bars[bar_idx];
+        Gp7::beginBar(system, master_bar, system_bar_idx, start_pos);
+
+        // Go through the bar for each staff.
+        int end_pos = start_pos;
+        for (int staff_idx = 0; staff_idx < num_staves; ++staff_idx)
+        {
+            Staff &staff = system.getStaves()[staff_idx];
+            const Tuning &tuning = score.getPlayers()[staff_idx].getTuning();
+            const Gp::Track &track = doc.myTracks[staff_idx];
+            const Gp::Staff &gp_staff =
+                doc.myMeasures[bar_idx].myStaves[staff_idx];
+
+            for (int voice_idx = 0;
+                 voice_idx < static_cast<int>(gp_staff.myVoices.size());
+                 ++voice_idx)
+            {
+                const std::vector<Gp::Beat> &beats =
+                    gp_staff.myVoices[voice_idx];
+                Voice &voice = staff.getVoices()[voice_idx];
+
+                int voice_pos = start_pos;
+                gp_rhythms.clear();
+                for (int beat_idx = 0;
+                     beat_idx < static_cast<int>(beats.size()); ++beat_idx)
+                {
+                    const Gp::Beat &beat = beats[beat_idx];
+                    if (beat.myIsEmpty)
+                        continue;
+
+                    if (const Gp::Note *grace_note = findGraceNote(beat))
+                    {
+                        convertGraceNote(*grace_note, track, gp7_beat);
+                        insertBeat(system, voice, tuning, gp7_beat, voice_pos,
+                                   gp_rhythms);
+                    }
+
+                    convertBeat(doc, bar_idx, staff_idx, voice_idx, beat_idx,
+                                gp7_beat);
+                    insertBeat(system, voice, tuning, gp7_beat, voice_pos,
+                               gp_rhythms);
+                }
+
+                Gp7::convertIrregularGroupings(voice, start_pos, voice_pos,
+                                               gp_rhythms);
+
+                end_pos = std::max(voice_pos, end_pos);
+            }
+        }
+
+        const bool final_bar = size_t(bar_idx + 1) == master_bars.size();
+        const Gp7::MasterBar *prev_master_bar =
+            (bar_idx != 0) ? &master_bars[bar_idx - 1] : nullptr;
+        Gp7::endBar(system, master_bar, prev_master_bar, system_bar_idx,
+                    start_pos, end_pos, final_bar, bar_idx == bar_end - 1);
+
+        ++system_bar_idx;
+        start_pos = end_pos + 1;
+    }
+
+    return system;
+}
+
+void
+Gp::convert(const Gp::Document &doc, Score &score)
+{
+    Gp7::convertScoreInfo(convertScoreInfo(doc), score);
+
+    std::vector<Gp7::MasterBar> master_bars = convertMasterBars(doc);
+    convertDirections(doc.myDirections, master_bars);
+
+    if (!master_bars.empty())
+    {
+        // Create the players and assign them to the staves in the first
+        // system.
+        PlayerChange initial_player_change;
+        Gp7::convertPlayers(convertTracks(doc), score, initial_player_change);
+
+        // Decide how the measures are split into systems.
+        // For now just do three measures per system.
+        static constexpr int measures_per_system = 3;
+        const int num_measures = static_cast<int>(master_bars.size());
+        const int num_systems =
+            (num_measures + measures_per_system - 1) / measures_per_system;
+
+        Gp7::convertSystems(
+            score, num_systems,
+            [&](int system_idx) {
+                const int bar_begin = system_idx * measures_per_system;
+                const int bar_end =
+                    std::min(bar_begin + measures_per_system, num_measures);
+                return convertSystem(doc, master_bars, score, bar_begin,
+                                     bar_end);
+            },
+            initial_player_change);
+    }
+
+    ScoreUtils::adjustRehearsalSigns(score);
+    ScoreUtils::polishScore(score);
+    ScoreUtils::addStandardFilters(score);
+}
@@ -15,17 +15,17 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef FORMATS_GP_GP345TO7CONVERTER_H
-#define FORMATS_GP_GP345TO7CONVERTER_H
+#ifndef FORMATS_GP_CONVERTER_H
+#define FORMATS_GP_CONVERTER_H
 
-#include "document.h"
-#include <formats/gp7/parser.h>
+class Score;
 
 namespace Gp
 {
-/// Converts the Guitar Pro 3/4/5 document into a GP 7 document.
-Gp7::Document convertToGp7(const Gp::Document &doc);
+struct Document;
+
+/// Converts the Guitar Pro 3/4/5 document into the provided score.
+void convert(const Gp::Document &doc, Score &score);
 }
 
 #endif
-
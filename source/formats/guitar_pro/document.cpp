@@ -213,7 +213,7 @@ void Header::load(InputStream &stream)
 
     const uint32_t n = stream.read<uint32_t>();
     for (uint32_t i = 0; i < n; ++i)
-        myNotices.push_back(stream.readString());
+        myNotices.emplace_back(stream.readString());
 
     if (stream.version() <= Version4)
         myTripletFeel = stream.readBool();
@@ -225,7 +225,7 @@ void Header::load(InputStream &stream)
         for (int i = 0; i < NUM_LYRIC_LINES; ++i)
         {
             const int n = stream.read<int32_t>();
-            myLyrics.emplace_back(n, stream.readIntString());
+            myLyrics.emplace_back(n, std::string(stream.readIntString()));
         }
     }
 
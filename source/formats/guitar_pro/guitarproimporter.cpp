@@ -16,12 +16,10 @@
  */
 
 #include "guitarproimporter.h"
-#include "gp345to7converter.h"
+#include "converter.h"
 
 #include <boost/filesystem/fstream.hpp>
 
-#include <formats/gp7/converter.h>
-#include <formats/gp7/parser.h>
 #include <formats/guitar_pro/document.h>
 #include <formats/guitar_pro/inputstream.h>
 
@@ -34,14 +32,13 @@ GuitarProImporter::GuitarProImporter()
 void
 GuitarProImporter::load(const boost::filesystem::path &filename, Score &score)
 {
-    boost::filesystem::ifstream in(filename, std::ios::binary | std::ios::in);
-    Gp::InputStream stream(in);
-
     Gp::Document document;
-    document.load(stream);
+    {
+        boost::filesystem::ifstream in(filename,
+                                       std::ios::binary | std::ios::in);
+        Gp::InputStream stream(in);
+        document.load(stream);
+    }
 
-    // Convert to the GP7 intermediate format, which then can be converted to
-    // our score format.
-    Gp7::Document gp7_doc = Gp::convertToGp7(document);
-    Gp7::convert(gp7_doc, score);
+    Gp::convert(document, score);
 }
@@ -17,8 +17,11 @@
 
 #include "inputstream.h"
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <map>
+#include <sstream>
 
 #include <formats/fileformat.h>
 
@@ -31,68 +34,79 @@ const std::map<std::string, Gp::Version> theVersionStrings = {
     { "FICHIER GUITAR PRO v5.10", Gp::Version5_1 }
 };
 
-Gp::InputStream::InputStream(std::istream &stream) : myStream(stream)
+Gp::InputStream::InputStream(std::istream &stream) : myPosition(0)
 {
-    myStream.exceptions(std::istream::failbit | std::istream::badbit |
-                       std::istream::eofbit);
+    myData.assign(std::istreambuf_iterator<char>(stream),
+                  std::istreambuf_iterator<char>());
 
-    const std::string versionString = readVersionString();
+    const std::string_view versionString = readVersionString();
 
-    auto it = theVersionStrings.find(versionString);
+    auto it = theVersionStrings.find(std::string(versionString));
     if (it != theVersionStrings.end())
         myVersion = it->second;
     else
-        throw FileFormatException("Unsupported file version: " + versionString);
+    {
+        throw FileFormatException("Unsupported file version: " +
+                                  std::string(versionString));
+    }
 }
 
-std::string Gp::InputStream::readVersionString()
+void Gp::InputStream::throwEndOfFile(size_t n) const
 {
-    myStream.seekg(std::ios_base::beg);
+    std::ostringstream message;
+    message << "Unexpected end of file when reading " << n
+            << " byte(s) at offset " << myPosition << " (file size is "
+            << myData.size() << " bytes)";
+    throw FileFormatException(message.str());
+}
+
+std::string_view Gp::InputStream::readVersionString()
+{
+    myPosition = 0;
 
     // THe version consists of a 30 character string, although not all 30
     // characters may be used.
-    std::string version = readCharacterString<uint8_t>();
+    std::string_view version = readCharacterString<uint8_t>();
 
     // Skip past any unread characters to land at position 0x1f.
-    myStream.seekg(31, std::ios_base::beg);
+    myPosition = 0;
+    skip(31);
 
     return version;
 }
 
-std::string Gp::InputStream::readString()
+std::string_view Gp::InputStream::readString()
 {
     [[maybe_unused]] const uint32_t size = read<uint32_t>();
 
-    std::string str = readCharacterString<uint8_t>();
+    std::string_view str = readCharacterString<uint8_t>();
     assert(size - 1 == str.length());
 
     return str;
 }
 
-std::string Gp::InputStream::readIntString()
+std::string_view Gp::InputStream::readIntString()
 {
     return readCharacterString<uint32_t>();
 }
 
-std::string Gp::InputStream::readFixedLengthString(uint32_t maxLength)
+std::string_view Gp::InputStream::readFixedLengthString(uint32_t maxLength)
 {
     const uint8_t actualLength = read<uint8_t>();
 
-    std::string str;
-
-    if (maxLength != 0)
-        str.resize(maxLength);
-    else
-        str.resize(actualLength);
-
-    if (str.size() != 0)
-        myStream.read(&str[0], str.size());
+    // Read the full field, but only return the characters that are in use.
+    const size_t size = (maxLength != 0) ? maxLength : actualLength;
+    const char *data = reinterpret_cast<const char *>(advance(size));
 
-    str.resize(actualLength);
-    return str;
+    return std::string_view(data, std::min<size_t>(actualLength, size));
 }
 
 void Gp::InputStream::skip(int numBytes)
 {
-    myStream.seekg(numBytes, std::ios_base::cur);
+    if (numBytes < 0)
+        throw FileFormatException("Invalid number of bytes to skip");
+
+    // Like seeking in a stream, it isn't an error to skip past the end of the
+    // file unless there is another read.
+    myPosition += numBytes;
 }
@@ -20,13 +20,21 @@
 
 #include <boost/endian/conversion.hpp>
 #include <cstdint>
+#include <cstring>
 #include <istream>
+#include <string_view>
 #include <vector>
 
 #include "document.h"
 
 namespace Gp
 {
+/// Reads data from a Guitar Pro file. The file is loaded into memory up front,
+/// and values are read directly from the buffer. If the end of the file is
+/// reached, a FileFormatException is thrown with the offset of the read.
+///
+/// Strings are returned as views into the buffer, which remain valid for the
+/// lifetime of the stream.
 class InputStream
 {
 public:
@@ -35,6 +43,9 @@ public:
     /// Returns the file version.
     Version version() const;
 
+    /// Returns the current offset in the file.
+    size_t position() const { return myPosition; }
+
     /// Reads simple data (e.g. uint32_t, int16_t) from the input stream.
     template <class T>
     [[nodiscard]] T read();
@@ -45,38 +56,56 @@ public:
     /// Reads a string in the most common format for Guitar Pro - an integer
     /// representing the size of the stored information + 1, followed by the
     /// length-prefixed string of characters representing the data
-    std::string readString();
+    std::string_view readString();
 
     /// Reads a string prefixed with 4 bytes that indicate the length.
-    std::string readIntString();
+    std::string_view readIntString();
 
     /// Reads a fixed length string (any unused characters trailing the string
     /// are skipped).
-    std::string readFixedLengthString(uint32_t maxLength);
+    std::string_view readFixedLengthString(uint32_t maxLength);
 
-    std::string readVersionString();
+    std::string_view readVersionString();
 
     void skip(int numBytes);
 
 private:
+    /// Returns a pointer to the next n bytes and advances past them, or throws
+    /// if the end of the file would be reached.
+    const uint8_t *advance(size_t n);
+
+    [[noreturn]] void throwEndOfFile(size_t n) const;
+
     /// Reads a character string.
     /// The string consists of some number of bytes (encoding the length of the
     /// string, n) followed by n characters.  This is templated on the length
     /// prefix type, to allow for strings prefixed with a 2-byte length value,
     /// 4-byte length value, etc
     template <class LengthPrefixType>
-    std::string readCharacterString();
+    std::string_view readCharacterString();
 
-    std::istream &myStream;
+    std::vector<uint8_t> myData;
+    size_t myPosition;
     Version myVersion;
 };
 
+inline const uint8_t *
+InputStream::advance(size_t n)
+{
+    if (myPosition > myData.size() || n > myData.size() - myPosition)
+        throwEndOfFile(n);
+
+    const uint8_t *data = myData.data() + myPosition;
+    myPosition += n;
+    return data;
+}
+
 template <class T>
 inline T InputStream::read()
 {
     static_assert(std::is_arithmetic<T>::value, "T must be an arithmetic type");
     T data;
-    myStream.read((char *)&data, sizeof(data));
+    std::memcpy(&data, advance(sizeof(data)), sizeof(data));
     // The values are stored in little-endian format.
     return boost::endian::little_to_native(data);
 }
@@ -88,20 +117,15 @@ InputStream::readBool()
 }
 
 template <typename LengthPrefixType>
-inline std::string InputStream::readCharacterString()
+inline std::string_view InputStream::readCharacterString()
 {
-    static_assert(std::is_integral<LengthPrefixType>::value,
-                  "LengthPrefixType must be an integral type");
+    static_assert(std::is_unsigned<LengthPrefixType>::value,
+                  "LengthPrefixType must be an unsigned integral type");
 
     const LengthPrefixType length = read<LengthPrefixType>();
-
-    std::string str;
-    str.resize(length);
-
-    if (length != 0)
-        myStream.read(&str[0], length);
-
-    return str;
+    const size_t size = static_cast<size_t>(length);
+    return std::string_view(reinterpret_cast<const char *>(advance(size)),
+                            size);
 }
 
 inline Version
@@ -19,22 +19,28 @@
 
 #include <app/settingsmanager.h>
 #include <audio/settings.h>
-#include <midi/midifile.h>
 #include <score/generalmidi.h>
 
 #include <array>
 #include <boost/endian/conversion.hpp>
 #include <boost/filesystem/fstream.hpp>
-#include <cstdint>
+#include <cassert>
+#include <cstring>
 
 template <typename T>
-static void write(std::ostream &os, T val)
+static void write(std::vector<uint8_t> &buffer, T val)
 {
     val = boost::endian::native_to_big(val);
-    os.write(reinterpret_cast<const char *>(&val), sizeof(T));
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&val);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
 }
 
-static void writeVariableLength(std::ostream &os, uint32_t val)
+static void writeChunkId(std::vector<uint8_t> &buffer, const char *id)
+{
+    buffer.insert(buffer.end(), id, id + 4);
+}
+
+static void writeVariableLength(std::vector<uint8_t> &buffer, uint32_t val)
 {
     std::array<uint8_t, 5> bytes;
     for (int i = 0; i < 5; ++i)
@@ -54,7 +60,7 @@ static void writeVariableLength(std::ostream &os, uint32_t val)
         if (i < 4)
             bytes[i] |= 0x80;
 
-        write(os, bytes[i]);
+        buffer.push_back(bytes[i]);
     }
 }
 
@@ -66,70 +72,132 @@ MidiExporter::MidiExporter(const SettingsManager &settings_manager)
 
 void MidiExporter::save(const boost::filesystem::path &filename, const Score &score)
 {
-    boost::filesystem::ofstream os(filename, std::ios::out | std::ios::binary);
-    os.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
+    save(filename, score, getLoadOptions());
+}
+
+void MidiExporter::saveAll(
+    const std::vector<boost::filesystem::path> &filenames,
+    const std::vector<const Score *> &scores)
+{
+    assert(filenames.size() == scores.size());
+    const MidiFile::LoadOptions options = getLoadOptions();
+
+    // The files are written one at a time, since MidiFile::load() already
+    // spreads the staves of each score across the available cores.
+    for (size_t i = 0; i < scores.size(); ++i)
+        save(filenames[i], *scores[i], options);
+}
 
+MidiFile::LoadOptions MidiExporter::getLoadOptions() const
+{
     MidiFile::LoadOptions options;
     options.myEnableMetronome = false;
     options.myRecordPositionChanges = false;
-    {
-        auto settings = mySettingsManager.getReadHandle();
-        options.myMetronomePreset = settings->get(Settings::MetronomePreset) +
-                                    Midi::MIDI_PERCUSSION_PRESET_OFFSET;
-        options.myStrongAccentVel =
-            settings->get(Settings::MetronomeStrongAccent);
-        options.myWeakAccentVel = settings->get(Settings::MetronomeWeakAccent);
-        options.myVibratoStrength = settings->get(Settings::MidiVibratoLevel);
-        options.myWideVibratoStrength =
-            settings->get(Settings::MidiWideVibratoLevel);
-    }
 
+    auto settings = mySettingsManager.getReadHandle();
+    options.myMetronomePreset = settings->get(Settings::MetronomePreset) +
+                                Midi::MIDI_PERCUSSION_PRESET_OFFSET;
+    options.myStrongAccentVel = settings->get(Settings::MetronomeStrongAccent);
+    options.myWeakAccentVel = settings->get(Settings::MetronomeWeakAccent);
+    options.myVibratoStrength = settings->get(Settings::MidiVibratoLevel);
+    options.myWideVibratoStrength =
+        settings->get(Settings::MidiWideVibratoLevel);
+    options.myCurveResolution = settings->get(Settings::MidiCurveResolution);
+
+    return options;
+}
+
+void MidiExporter::save(const boost::filesystem::path &filename,
+                        const Score &score,
+                        const MidiFile::LoadOptions &options)
+{
     MidiFile file;
     file.load(score, options);
-    writeHeader(os, file);
+    const std::vector<uint8_t> data = serialize(file);
+
+    boost::filesystem::ofstream os(filename, std::ios::out | std::ios::binary);
+    os.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
+    os.write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+std::vector<uint8_t> MidiExporter::serialize(const MidiFile &file)
+{
+    // Reserve enough space for the largest possible output (i.e. a four byte
+    // delta time and the full message for every event).
+    size_t max_size = 14;
+    for (const MidiEventList &track : file.getTracks())
+    {
+        max_size += 8;
+        for (const MidiEvent &event : track)
+            max_size += 4 + event.getData().size();
+    }
 
+    std::vector<uint8_t> buffer;
+    buffer.reserve(max_size);
+
+    writeHeader(buffer, file);
     for (const MidiEventList &track : file.getTracks())
-        writeTrack(os, track);
+        writeTrack(buffer, track);
+
+    return buffer;
 }
 
-void MidiExporter::writeHeader(std::ostream &os, const MidiFile &file)
+void MidiExporter::writeHeader(std::vector<uint8_t> &buffer,
+                               const MidiFile &file)
 {
     // Chunk ID for the header chunk.
-    os << "MThd";
+    writeChunkId(buffer, "MThd");
     // 6 bytes will follow the chunk size.
-    write(os, static_cast<uint32_t>(6));
+    write(buffer, static_cast<uint32_t>(6));
 
     // A format type of 1 indicates that we'll have multiple tracks.
-    write(os, static_cast<uint16_t>(1));
-    write(os, static_cast<uint16_t>(file.getTracks().size()));
+    write(buffer, static_cast<uint16_t>(1));
+    write(buffer, static_cast<uint16_t>(file.getTracks().size()));
 
     // Time division.
-    write(os, static_cast<uint16_t>(file.getTicksPerBeat()));
+    write(buffer, static_cast<uint16_t>(file.getTicksPerBeat()));
 }
 
-void MidiExporter::writeTrack(std::ostream & os, const MidiEventList & events)
+void MidiExporter::writeTrack(std::vector<uint8_t> &buffer,
+                              const MidiEventList &events)
 {
     // Chunk ID for a track chunk.
-    os << "MTrk";
+    writeChunkId(buffer, "MTrk");
 
-    // Size in bytes of the track chunk. This will be updated after writing out
-    // all of the data.
-    const std::iostream::pos_type chunk_len_pos = os.tellp();
-    write(os, static_cast<uint32_t>(0));
+    // Size in bytes of the track chunk. This will be filled in after writing
+    // out all of the data.
+    const size_t chunk_len_pos = buffer.size();
+    write(buffer, static_cast<uint32_t>(0));
 
     // Write out the MIDI events.
-    const std::iostream::pos_type chunk_start_pos = os.tellp();
+    const size_t chunk_start_pos = buffer.size();
+    uint8_t running_status = 0;
     for (const MidiEvent &event : events)
     {
-        writeVariableLength(os, event.getTicks());
-        os.write(reinterpret_cast<const char *>(event.getData().data()),
-                 event.getData().size());
+        writeVariableLength(buffer, event.getTicks());
+
+        const std::vector<uint8_t> &data = event.getData();
+
+        // The status byte can be omitted for a channel message if it is the
+        // same as the previous event's. Meta and system exclusive events
+        // cancel the running status.
+        auto begin = data.begin();
+        const uint8_t status = data.front();
+        if (status < 0xf0)
+        {
+            if (status == running_status)
+                ++begin;
+
+            running_status = status;
+        }
+        else
+            running_status = 0;
+
+        buffer.insert(buffer.end(), begin, data.end());
     }
 
-    const std::iostream::pos_type chunk_end_pos = os.tellp();
-
     // Record the size in bytes of the track chunk.
-    os.seekp(chunk_len_pos);
-    write(os, static_cast<uint32_t>(chunk_end_pos - chunk_start_pos));
-    os.seekp(chunk_end_pos);
+    const uint32_t chunk_len = boost::endian::native_to_big(
+        static_cast<uint32_t>(buffer.size() - chunk_start_pos));
+    std::memcpy(buffer.data() + chunk_len_pos, &chunk_len, sizeof(chunk_len));
 }
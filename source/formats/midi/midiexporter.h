@@ -19,9 +19,12 @@
 #define FORMATS_MIDIEXPORTER_H
 
 #include <formats/fileformatmanager.h>
+#include <midi/midifile.h>
+
+#include <cstdint>
+#include <vector>
 
 class MidiEventList;
-class MidiFile;
 
 class MidiExporter : public FileFormatExporter
 {
@@ -31,9 +34,25 @@ public:
     virtual void save(const boost::filesystem::path &filename,
                       const Score &score) override;
 
+    /// Exports several scores (e.g. for batch conversions), reading the
+    /// settings only once. Each score is written to the filename with the
+    /// same index.
+    void saveAll(const std::vector<boost::filesystem::path> &filenames,
+                 const std::vector<const Score *> &scores);
+
+    /// Serializes the MIDI file into a single buffer, using running status
+    /// for consecutive channel messages with the same status byte.
+    static std::vector<uint8_t> serialize(const MidiFile &file);
+
 private:
-    static void writeHeader(std::ostream &os, const MidiFile &file);
-    static void writeTrack(std::ostream &os, const MidiEventList &events);
+    MidiFile::LoadOptions getLoadOptions() const;
+    static void save(const boost::filesystem::path &filename,
+                     const Score &score, const MidiFile::LoadOptions &options);
+
+    static void writeHeader(std::vector<uint8_t> &buffer,
+                            const MidiFile &file);
+    static void writeTrack(std::vector<uint8_t> &buffer,
+                           const MidiEventList &events);
 
     const SettingsManager &mySettingsManager;
 };
@@ -0,0 +1,628 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "midiimporter.h"
+
+#include "smfreader.h"
+
+#include <algorithm>
+#include <array>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cmath>
+#include <score/generalmidi.h>
+#include <score/note.h>
+#include <score/playerchange.h>
+#include <score/position.h>
+#include <score/score.h>
+#include <score/system.h>
+#include <score/tempomarker.h>
+#include <score/timesignature.h>
+#include <score/utils/scorepolisher.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+/// The number of bars to place in each system.
+constexpr int BARS_PER_SYSTEM = 4;
+/// Notes are quantized to 32nd notes.
+constexpr int UNITS_PER_QUARTER_NOTE = 8;
+constexpr int PERCUSSION_CHANNEL = 9;
+
+struct ImportedNote
+{
+    /// The start and end times, in ticks until they are quantized.
+    int myStart;
+    int myEnd = 0;
+    uint8_t myPitch;
+};
+
+/// The notes from one channel of a track, which are imported as a player.
+struct Part
+{
+    std::string myName;
+    uint8_t myProgram = 0;
+    std::vector<ImportedNote> myNotes;
+};
+
+struct TempoChange
+{
+    /// The time of the change, in ticks until it is quantized.
+    int myTime;
+    int myBeatsPerMinute;
+};
+
+struct TimeSignatureChange
+{
+    /// The time of the change, in ticks until it is quantized.
+    int myTime;
+    int myBeatsPerMeasure;
+    int myBeatValue;
+};
+
+struct ImportedFile
+{
+    int myTicksPerBeat = 0;
+    /// The tempo and time signature changes from all tracks, in the order
+    /// that they were read.
+    std::vector<TempoChange> myTempoChanges;
+    std::vector<TimeSignatureChange> myTimeSignatureChanges;
+    std::vector<Part> myParts;
+};
+
+/// The layout of a bar, in 32nd notes.
+struct BarInfo
+{
+    int myStart;
+    int myLength;
+    const TimeSignatureChange *myTimeSignature;
+    const TempoChange *myTempo;
+};
+
+/// A group of notes that start at the same time.
+struct Chord
+{
+    int myStart;
+    int myEnd = 0;
+    /// The pitches, from highest to lowest.
+    std::vector<uint8_t> myPitches;
+};
+
+/// Notes that are still held at the end of a bar, and continue into the
+/// following bar.
+struct HeldNotes
+{
+    int myEnd = 0;
+    std::vector<Note> myNotes;
+};
+
+/// A duration that can be represented by a single position.
+struct DurationUnit
+{
+    int myLength;
+    Position::DurationType myType;
+    bool myDotted;
+};
+
+/// The durations that can be represented by a single position (in 32nd
+/// notes), from longest to shortest.
+const std::array<DurationUnit, 11> THE_DURATIONS = { {
+    { 48, Position::WholeNote, true },
+    { 32, Position::WholeNote, false },
+    { 24, Position::HalfNote, true },
+    { 16, Position::HalfNote, false },
+    { 12, Position::QuarterNote, true },
+    { 8, Position::QuarterNote, false },
+    { 6, Position::EighthNote, true },
+    { 4, Position::EighthNote, false },
+    { 3, Position::SixteenthNote, true },
+    { 2, Position::SixteenthNote, false },
+    { 1, Position::ThirtySecondNote, false },
+} };
+} // namespace
+
+MidiImporter::MidiImporter()
+    : FileFormatImporter(FileFormat("MIDI File", { "mid" }))
+{
+}
+
+void MidiImporter::load(const boost::filesystem::path &filename, Score &score)
+{
+    boost::iostreams::mapped_file_source file;
+    try
+    {
+        // Empty files can't be mapped, and are rejected with the same error
+        // as any other truncated file.
+        if (boost::filesystem::file_size(filename) != 0)
+            file.open(filename);
+    }
+    catch (const std::exception &e)
+    {
+        throw FileFormatException(std::string("Unable to read the MIDI file: ") +
+                                  e.what());
+    }
+
+    if (!file.is_open())
+        throw FileFormatException("Unexpected end of MIDI file.");
+
+    load(reinterpret_cast<const uint8_t *>(file.data()), file.size(), score);
+}
+
+/// Reads the notes from each track, along with the tempo and time signature
+/// changes.
+static ImportedFile readFile(const uint8_t *data, size_t size)
+{
+    SmfReader reader(data, size);
+
+    ImportedFile file;
+    file.myTicksPerBeat = reader.getTicksPerBeat();
+
+    // The start tick of each active note, or -1.
+    std::array<std::array<int, 128>, 16> note_starts;
+    // The part for each channel in the current track, or -1.
+    std::array<int, 16> channel_parts;
+    std::array<uint8_t, 16> channel_programs;
+
+    SmfReader::Event event;
+    int track_index = 0;
+    while (reader.nextTrack())
+    {
+        for (auto &starts : note_starts)
+            starts.fill(-1);
+        channel_parts.fill(-1);
+        channel_programs.fill(0);
+
+        const size_t first_part = file.myParts.size();
+        std::string track_name;
+        int last_tick = 0;
+
+        auto end_note = [&](int channel, int pitch, int tick) {
+            int &start = note_starts[channel][pitch];
+            if (start < 0)
+                return;
+
+            file.myParts[channel_parts[channel]].myNotes.push_back(
+                { start, tick, static_cast<uint8_t>(pitch) });
+            start = -1;
+        };
+
+        while (reader.nextEvent(event))
+        {
+            const int tick = static_cast<int>(event.myTicks);
+            last_tick = tick;
+
+            if (event.myStatus == SmfReader::META_EVENT)
+            {
+                if (event.myMetaType == SmfReader::META_TRACK_NAME)
+                {
+                    track_name.assign(
+                        reinterpret_cast<const char *>(event.myData),
+                        event.mySize);
+                }
+                else if (event.myMetaType == SmfReader::META_TEMPO &&
+                         event.mySize == 3)
+                {
+                    const int usec_per_beat = (event.myData[0] << 16) |
+                                              (event.myData[1] << 8) |
+                                              event.myData[2];
+                    if (usec_per_beat > 0)
+                    {
+                        file.myTempoChanges.push_back(
+                            { tick, static_cast<int>(
+                                        std::lround(60e6 / usec_per_beat)) });
+                    }
+                }
+                else if (event.myMetaType == SmfReader::META_TIME_SIGNATURE &&
+                         event.mySize >= 2)
+                {
+                    file.myTimeSignatureChanges.push_back(
+                        { tick, std::max<int>(1, event.myData[0]),
+                          1 << std::min<int>(event.myData[1], 5) });
+                }
+
+                continue;
+            }
+
+            // Skip system exclusive messages, and percussion since it can't be
+            // assigned to strings.
+            const int channel = event.myStatus & 0x0f;
+            const uint8_t type = event.myStatus & 0xf0;
+            if (event.myStatus >= 0xf0 || channel == PERCUSSION_CHANNEL)
+                continue;
+
+            if (type == 0x90 && event.myData[1] != 0)
+            {
+                const int pitch = event.myData[0] & 0x7f;
+                if (channel_parts[channel] < 0)
+                {
+                    channel_parts[channel] =
+                        static_cast<int>(file.myParts.size());
+                    file.myParts.emplace_back();
+                    file.myParts.back().myProgram = channel_programs[channel];
+                }
+
+                // Finish the previous note if it is retriggered.
+                end_note(channel, pitch, tick);
+                note_starts[channel][pitch] = tick;
+            }
+            else if (type == 0x80 || type == 0x90)
+                end_note(channel, event.myData[0] & 0x7f, tick);
+            else if (type == 0xc0 && channel_parts[channel] < 0)
+                channel_programs[channel] = event.myData[0] & 0x7f;
+        }
+
+        // Finish any notes that are still held at the end of the track.
+        for (int channel = 0; channel < 16; ++channel)
+        {
+            for (int pitch = 0; pitch < 128; ++pitch)
+                end_note(channel, pitch, last_tick);
+        }
+
+        ++track_index;
+        for (size_t i = first_part; i < file.myParts.size(); ++i)
+        {
+            file.myParts[i].myName =
+                !track_name.empty() ? track_name
+                                    : "Track " + std::to_string(track_index);
+        }
+    }
+
+    return file;
+}
+
+/// Converts a time in ticks to the nearest 32nd note.
+static int quantize(int ticks, int ticks_per_beat)
+{
+    return static_cast<int>(
+        (static_cast<int64_t>(ticks) * UNITS_PER_QUARTER_NOTE +
+         ticks_per_beat / 2) /
+        ticks_per_beat);
+}
+
+/// Quantizes the notes to 32nd notes, and groups the notes that start at the
+/// same time into chords.
+static std::vector<Chord> createChords(std::vector<ImportedNote> &notes,
+                                       int ticks_per_beat)
+{
+    for (ImportedNote &note : notes)
+    {
+        note.myStart = quantize(note.myStart, ticks_per_beat);
+        note.myEnd = std::max(quantize(note.myEnd, ticks_per_beat),
+                              note.myStart + 1);
+    }
+
+    std::sort(notes.begin(), notes.end(),
+              [](const ImportedNote &a, const ImportedNote &b) {
+                  return a.myStart != b.myStart ? a.myStart < b.myStart
+                                                : a.myPitch > b.myPitch;
+              });
+
+    std::vector<Chord> chords;
+    for (const ImportedNote &note : notes)
+    {
+        if (chords.empty() || chords.back().myStart != note.myStart)
+            chords.push_back({ note.myStart, note.myEnd, {} });
+
+        Chord &chord = chords.back();
+        if (chord.myPitches.empty() || chord.myPitches.back() != note.myPitch)
+            chord.myPitches.push_back(note.myPitch);
+        chord.myEnd = std::max(chord.myEnd, note.myEnd);
+    }
+
+    // Each chord lasts until the next chord starts.
+    for (size_t i = 1; i < chords.size(); ++i)
+        chords[i - 1].myEnd = std::min(chords[i - 1].myEnd, chords[i].myStart);
+
+    return chords;
+}
+
+/// Assigns each pitch to a string, using the lowest available fret. Pitches
+/// that can't be played with the tuning are dropped.
+static std::vector<Note> assignStrings(const std::vector<uint8_t> &pitches,
+                                       const Tuning &tuning)
+{
+    std::vector<Note> notes;
+    std::vector<bool> used_strings(tuning.getStringCount(), false);
+
+    for (uint8_t pitch : pitches)
+    {
+        int best_string = -1;
+        int best_fret = 0;
+        for (int string = 0; string < tuning.getStringCount(); ++string)
+        {
+            const int fret =
+                pitch - tuning.getNote(string, false) - tuning.getCapo();
+            if (used_strings[string] || fret < 0 ||
+                fret > Note::MAX_FRET_NUMBER)
+            {
+                continue;
+            }
+
+            if (best_string < 0 || fret < best_fret)
+            {
+                best_string = string;
+                best_fret = fret;
+            }
+        }
+
+        if (best_string >= 0)
+        {
+            used_strings[best_string] = true;
+            notes.emplace_back(best_string, best_fret);
+        }
+    }
+
+    return notes;
+}
+
+/// Inserts positions for the given length of time. Notes that are longer than
+/// a single position are continued with tied notes, and if tie_first is set
+/// the first position also continues notes from the previous position.
+static void insertPositions(Voice &voice, int &position, int length,
+                            const std::vector<Note> &notes,
+                            bool tie_first = false)
+{
+    bool first = !tie_first;
+    while (length > 0)
+    {
+        const DurationUnit &unit = *std::find_if(
+            THE_DURATIONS.begin(), THE_DURATIONS.end(),
+            [=](const DurationUnit &unit) { return unit.myLength <= length; });
+
+        Position pos(position++, unit.myType);
+        if (unit.myDotted)
+            pos.setProperty(Position::Dotted);
+
+        if (notes.empty())
+            pos.setRest();
+
+        for (Note note : notes)
+        {
+            if (!first)
+                note.setProperty(Note::Tied);
+            pos.insertNote(note);
+        }
+
+        voice.insertPosition(pos);
+        length -= unit.myLength;
+        first = false;
+    }
+}
+
+/// Quantizes the tempo and time signature changes, and lays out bars until
+/// the end time is reached. A time signature change takes effect at the first
+/// bar that starts at or after it, and the last tempo change before the end of
+/// a bar is applied at the start of that bar.
+static std::vector<BarInfo> createBars(ImportedFile &file, int end_time)
+{
+    auto by_time = [](const auto &a, const auto &b) {
+        return a.myTime < b.myTime;
+    };
+
+    for (TempoChange &change : file.myTempoChanges)
+        change.myTime = quantize(change.myTime, file.myTicksPerBeat);
+    std::stable_sort(file.myTempoChanges.begin(), file.myTempoChanges.end(),
+                     by_time);
+    if (file.myTempoChanges.empty() || file.myTempoChanges[0].myTime != 0)
+    {
+        file.myTempoChanges.insert(
+            file.myTempoChanges.begin(),
+            { 0, TempoMarker::DEFAULT_BEATS_PER_MINUTE });
+    }
+
+    for (TimeSignatureChange &change : file.myTimeSignatureChanges)
+        change.myTime = quantize(change.myTime, file.myTicksPerBeat);
+    std::stable_sort(file.myTimeSignatureChanges.begin(),
+                     file.myTimeSignatureChanges.end(), by_time);
+    if (file.myTimeSignatureChanges.empty() ||
+        file.myTimeSignatureChanges[0].myTime != 0)
+    {
+        file.myTimeSignatureChanges.insert(
+            file.myTimeSignatureChanges.begin(), { 0, 4, 4 });
+    }
+
+    std::vector<BarInfo> bars;
+    size_t tempo_index = 0;
+    size_t time_sig_index = 0;
+    int start = 0;
+    do
+    {
+        while (time_sig_index + 1 < file.myTimeSignatureChanges.size() &&
+               file.myTimeSignatureChanges[time_sig_index + 1].myTime <= start)
+        {
+            ++time_sig_index;
+        }
+
+        const TimeSignatureChange &time_sig =
+            file.myTimeSignatureChanges[time_sig_index];
+        const int length =
+            std::max(1, time_sig.myBeatsPerMeasure * UNITS_PER_QUARTER_NOTE *
+                            4 / time_sig.myBeatValue);
+
+        while (tempo_index + 1 < file.myTempoChanges.size() &&
+               file.myTempoChanges[tempo_index + 1].myTime < start + length)
+        {
+            ++tempo_index;
+        }
+
+        bars.push_back({ start, length, &time_sig,
+                         &file.myTempoChanges[tempo_index] });
+        start += length;
+    } while (start < end_time);
+
+    return bars;
+}
+
+/// Creates the positions for a bar, starting with any notes that are held
+/// over from the previous bar and then the next chord. Notes that last past
+/// the end of the bar are stored in held_notes, and continued in the next bar
+/// with tied notes.
+static void convertBar(Voice &voice, int &position, const Tuning &tuning,
+                       const std::vector<Chord> &chords, size_t &chord_index,
+                       HeldNotes &held_notes, int bar_start, int bar_end)
+{
+    int time = bar_start;
+    if (!held_notes.myNotes.empty())
+    {
+        time = std::min(held_notes.myEnd, bar_end);
+        insertPositions(voice, position, time - bar_start,
+                        held_notes.myNotes, true);
+
+        if (held_notes.myEnd <= bar_end)
+            held_notes.myNotes.clear();
+    }
+
+    for (; chord_index < chords.size() &&
+           chords[chord_index].myStart < bar_end;
+         ++chord_index)
+    {
+        const Chord &chord = chords[chord_index];
+        insertPositions(voice, position, chord.myStart - time, {});
+
+        std::vector<Note> notes = assignStrings(chord.myPitches, tuning);
+        const int end = std::min(chord.myEnd, bar_end);
+        insertPositions(voice, position, end - chord.myStart, notes);
+        time = end;
+
+        if (chord.myEnd > bar_end && !notes.empty())
+        {
+            held_notes.myEnd = chord.myEnd;
+            held_notes.myNotes = std::move(notes);
+        }
+    }
+
+    insertPositions(voice, position, bar_end - time, {});
+}
+
+void MidiImporter::load(const uint8_t *data, size_t size, Score &score)
+{
+    ImportedFile file = readFile(data, size);
+    if (file.myParts.empty())
+        throw FileFormatException("The MIDI file does not contain any notes.");
+
+    const std::vector<std::string> preset_names = Midi::getPresetNames();
+
+    std::vector<std::vector<Chord>> part_chords;
+    int end_time = 0;
+    for (Part &part : file.myParts)
+    {
+        part_chords.push_back(createChords(part.myNotes, file.myTicksPerBeat));
+        if (!part_chords.back().empty())
+            end_time = std::max(end_time, part_chords.back().back().myEnd);
+
+        Player player;
+        player.setDescription(part.myName);
+        score.insertPlayer(player);
+
+        Instrument instrument;
+        instrument.setDescription(preset_names.at(part.myProgram));
+        instrument.setMidiPreset(part.myProgram);
+        score.insertInstrument(instrument);
+    }
+
+    const std::vector<BarInfo> bars = createBars(file, end_time);
+    const int num_bars = static_cast<int>(bars.size());
+
+    auto make_time_sig = [](const BarInfo &bar) {
+        TimeSignature time_sig;
+        time_sig.setBeatsPerMeasure(bar.myTimeSignature->myBeatsPerMeasure);
+        time_sig.setNumPulses(bar.myTimeSignature->myBeatsPerMeasure);
+        time_sig.setBeatValue(bar.myTimeSignature->myBeatValue);
+        return time_sig;
+    };
+
+    std::vector<size_t> chord_indices(file.myParts.size(), 0);
+    std::vector<HeldNotes> held_notes(file.myParts.size());
+    for (int bar_begin = 0; bar_begin < num_bars; bar_begin += BARS_PER_SYSTEM)
+    {
+        const int bar_end = std::min(bar_begin + BARS_PER_SYSTEM, num_bars);
+        System system;
+
+        // For the first system, assign the players to the staves.
+        if (bar_begin == 0)
+        {
+            PlayerChange player_change;
+            for (int i = 0; i < static_cast<int>(file.myParts.size()); ++i)
+                player_change.insertActivePlayer(i, ActivePlayer(i, i));
+            system.insertPlayerChange(player_change);
+        }
+
+        for (const Player &player : score.getPlayers())
+            system.insertStaff(Staff(player.getTuning().getStringCount()));
+
+        int start_pos = 0;
+        for (int bar_idx = bar_begin; bar_idx < bar_end; ++bar_idx)
+        {
+            const BarInfo &bar = bars[bar_idx];
+            const BarInfo *prev_bar = bar_idx > 0 ? &bars[bar_idx - 1] : nullptr;
+
+            // Add a tempo marker for the first bar and whenever the tempo
+            // changes.
+            if (!prev_bar ||
+                bar.myTempo->myBeatsPerMinute !=
+                    prev_bar->myTempo->myBeatsPerMinute)
+            {
+                TempoMarker marker(start_pos);
+                marker.setBeatsPerMinute(bar.myTempo->myBeatsPerMinute);
+                system.insertTempoMarker(marker);
+            }
+
+            int end_pos = start_pos;
+            for (size_t i = 0; i < file.myParts.size(); ++i)
+            {
+                Voice &voice = system.getStaves()[i].getVoices()[0];
+                int position = start_pos;
+                convertBar(voice, position,
+                           score.getPlayers()[i].getTuning(), part_chords[i],
+                           chord_indices[i], held_notes[i], bar.myStart,
+                           bar.myStart + bar.myLength);
+                end_pos = std::max(end_pos, position);
+            }
+
+            // Only display the time signature at the start of the score and
+            // when it changes.
+            const TimeSignature time_sig = make_time_sig(bar);
+            Barline &start_bar = system.getBarlines()[bar_idx - bar_begin];
+            TimeSignature start_time_sig(time_sig);
+            start_time_sig.setVisible(!prev_bar ||
+                                      !(time_sig == make_time_sig(*prev_bar)));
+            start_bar.setTimeSignature(start_time_sig);
+
+            Barline end_bar(end_pos, (bar_idx == num_bars - 1)
+                                         ? Barline::DoubleBarFine
+                                         : Barline::SingleBar);
+            end_bar.setTimeSignature(time_sig);
+
+            // Insert a new barline unless we're finishing the system, in which
+            // case we just need to modify the end bar.
+            if (bar_idx != bar_end - 1)
+                system.insertBarline(end_bar);
+            else
+                system.getBarlines().back() = end_bar;
+
+            start_pos = end_pos + 1;
+        }
+
+        score.insertSystem(std::move(system));
+    }
+
+    ScoreUtils::polishScore(score);
+    ScoreUtils::addStandardFilters(score);
+}
@@ -0,0 +1,43 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FORMATS_MIDIIMPORTER_H
+#define FORMATS_MIDIIMPORTER_H
+
+#include <formats/fileformat.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/// Imports Standard MIDI Files (type 0 or 1). Each track and channel with
+/// notes becomes a player, and the notes are quantized to 32nd notes and
+/// assigned to strings using the player's tuning. Tempo changes are applied at
+/// the start of the bar that they occur in, and time signature changes take
+/// effect at the next barline. Percussion (channel 10) is not imported.
+class MidiImporter : public FileFormatImporter
+{
+public:
+    MidiImporter();
+
+    void load(const boost::filesystem::path &filename, Score &score) override;
+
+    /// Imports a MIDI file that has already been loaded into memory.
+    static void load(const uint8_t *data, size_t size, Score &score);
+};
+
+#endif
@@ -0,0 +1,184 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "smfreader.h"
+
+#include <cstring>
+#include <formats/fileformat.h>
+
+SmfReader::SmfReader(const uint8_t *data, size_t size)
+    : myPos(data),
+      myEnd(data + size),
+      myTrackEnd(data + size),
+      myFormat(0),
+      myTrackCount(0),
+      myTicksPerBeat(0),
+      myTicks(0),
+      myRunningStatus(0)
+{
+    require(14);
+    if (std::memcmp(myPos, "MThd", 4) != 0)
+        throw FileFormatException("Not a MIDI file.");
+    myPos += 4;
+
+    const uint32_t header_size = readUInt32();
+    if (header_size < 6)
+        throw FileFormatException("Invalid MIDI file header.");
+
+    require(header_size);
+    const uint8_t *header_end = myPos + header_size;
+
+    myFormat = readUInt16();
+    myTrackCount = readUInt16();
+    const uint16_t division = readUInt16();
+
+    if (myFormat > 1)
+        throw FileFormatException("Unsupported MIDI file format.");
+    // The high bit is set for SMPTE time divisions.
+    if ((division & 0x8000) || division == 0)
+        throw FileFormatException("Unsupported MIDI time division.");
+
+    myTicksPerBeat = division;
+    myPos = header_end;
+    myTrackEnd = myPos;
+}
+
+bool SmfReader::nextTrack()
+{
+    myPos = myTrackEnd;
+    myTrackEnd = myEnd;
+
+    while (myEnd - myPos >= 8)
+    {
+        const bool is_track = std::memcmp(myPos, "MTrk", 4) == 0;
+        myPos += 4;
+
+        const uint32_t chunk_size = readUInt32();
+        require(chunk_size);
+        myTrackEnd = myPos + chunk_size;
+
+        if (is_track)
+        {
+            myTicks = 0;
+            myRunningStatus = 0;
+            return true;
+        }
+
+        myPos = myTrackEnd;
+    }
+
+    myPos = myEnd;
+    return false;
+}
+
+bool SmfReader::nextEvent(Event &event)
+{
+    if (myPos >= myTrackEnd)
+        return false;
+
+    myTicks += readVariableLength();
+    event.myTicks = myTicks;
+    event.myMetaType = 0;
+
+    uint8_t status = readByte();
+    if (status < 0x80)
+    {
+        // Running status - the byte is the first data byte.
+        if (myRunningStatus == 0)
+            throw FileFormatException("Invalid MIDI event.");
+
+        status = myRunningStatus;
+        --myPos;
+    }
+
+    event.myStatus = status;
+
+    if (status == META_EVENT)
+    {
+        event.myMetaType = readByte();
+        event.mySize = readVariableLength();
+        myRunningStatus = 0;
+    }
+    else if (status == 0xf0 || status == 0xf7)
+    {
+        // System exclusive messages.
+        event.mySize = readVariableLength();
+        myRunningStatus = 0;
+    }
+    else if (status >= 0xf0)
+        throw FileFormatException("Invalid MIDI event.");
+    else
+    {
+        const uint8_t type = status & 0xf0;
+        event.mySize = (type == 0xc0 || type == 0xd0) ? 1 : 2;
+        myRunningStatus = status;
+    }
+
+    if (static_cast<size_t>(myTrackEnd - myPos) < event.mySize)
+        throw FileFormatException("Unexpected end of MIDI track.");
+
+    event.myData = myPos;
+    myPos += event.mySize;
+
+    // Ignore any data after the end of the track.
+    if (status == META_EVENT && event.myMetaType == META_END_OF_TRACK)
+        myPos = myTrackEnd;
+
+    return true;
+}
+
+void SmfReader::require(size_t num_bytes) const
+{
+    if (static_cast<size_t>(myEnd - myPos) < num_bytes)
+        throw FileFormatException("Unexpected end of MIDI file.");
+}
+
+uint8_t SmfReader::readByte()
+{
+    if (myPos >= myTrackEnd)
+        throw FileFormatException("Unexpected end of MIDI data.");
+
+    return *myPos++;
+}
+
+uint16_t SmfReader::readUInt16()
+{
+    const uint16_t high = readByte();
+    return static_cast<uint16_t>((high << 8) | readByte());
+}
+
+uint32_t SmfReader::readUInt32()
+{
+    const uint32_t high = readUInt16();
+    return (high << 16) | readUInt16();
+}
+
+uint32_t SmfReader::readVariableLength()
+{
+    // Variable length quantities have at most four bytes.
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        const uint8_t byte = readByte();
+        value = (value << 7) | (byte & 0x7f);
+        if (!(byte & 0x80))
+            return value;
+    }
+
+    throw FileFormatException("Invalid variable length quantity.");
+}
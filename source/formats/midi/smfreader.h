@@ -0,0 +1,85 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FORMATS_SMFREADER_H
+#define FORMATS_SMFREADER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/// Reads the events of a Standard MIDI File (type 0 or 1) directly from a
+/// buffer in a single pass. The event data is not copied, and no memory is
+/// allocated while reading, so the buffer must outlive the reader.
+class SmfReader
+{
+public:
+    static constexpr uint8_t META_EVENT = 0xff;
+    static constexpr uint8_t META_TRACK_NAME = 0x03;
+    static constexpr uint8_t META_END_OF_TRACK = 0x2f;
+    static constexpr uint8_t META_TEMPO = 0x51;
+    static constexpr uint8_t META_TIME_SIGNATURE = 0x58;
+
+    struct Event
+    {
+        /// The absolute tick of the event within its track.
+        uint32_t myTicks;
+        /// The status byte (after expanding running status), or META_EVENT.
+        uint8_t myStatus;
+        /// The type of a meta event.
+        uint8_t myMetaType;
+        /// The bytes following the status byte, or the payload of a meta or
+        /// system exclusive event. This points into the file's buffer.
+        const uint8_t *myData;
+        uint32_t mySize;
+    };
+
+    /// Reads the header chunk.
+    /// @throws FileFormatException if the header is invalid.
+    SmfReader(const uint8_t *data, size_t size);
+
+    int getFormat() const { return myFormat; }
+    int getTrackCount() const { return myTrackCount; }
+    int getTicksPerBeat() const { return myTicksPerBeat; }
+
+    /// Moves to the next track chunk, skipping any unknown chunks.
+    /// @returns False if there are no more tracks.
+    bool nextTrack();
+
+    /// Reads the next event in the current track.
+    /// @returns False at the end of the track.
+    /// @throws FileFormatException if the event is invalid.
+    bool nextEvent(Event &event);
+
+private:
+    void require(size_t num_bytes) const;
+    uint8_t readByte();
+    uint16_t readUInt16();
+    uint32_t readUInt32();
+    uint32_t readVariableLength();
+
+    const uint8_t *myPos;
+    const uint8_t *myEnd;
+    const uint8_t *myTrackEnd;
+    int myFormat;
+    int myTrackCount;
+    int myTicksPerBeat;
+    uint32_t myTicks;
+    uint8_t myRunningStatus;
+};
+
+#endif
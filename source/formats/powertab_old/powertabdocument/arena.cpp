@@ -0,0 +1,56 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "arena.h"
+
+namespace PowerTabDocument {
+
+const size_t Arena::BLOCK_SIZE = 64 * 1024;
+
+/// Default Constructor
+Arena::Arena() :
+    m_current(nullptr), m_remaining(0)
+{
+}
+
+/// Allocates a new block of memory, and returns memory from it with the
+/// requested size and alignment
+void* Arena::AllocateBlock(size_t size, size_t alignment)
+{
+    // Large objects get a block of their own, so that the remainder of the
+    // current block isn't wasted
+    const size_t blockSize = size + alignment;
+    if (blockSize > BLOCK_SIZE)
+    {
+        m_blocks.emplace_back(new std::byte[blockSize]);
+        void* ptr = m_blocks.back().get();
+        size_t space = blockSize;
+        return std::align(alignment, size, ptr, space);
+    }
+
+    m_blocks.emplace_back(new std::byte[BLOCK_SIZE]);
+    m_current = m_blocks.back().get();
+    m_remaining = BLOCK_SIZE;
+
+    void* ptr = m_current;
+    std::align(alignment, size, ptr, m_remaining);
+    m_current = static_cast<std::byte*>(ptr) + size;
+    m_remaining -= size;
+    return ptr;
+}
+
+}
@@ -0,0 +1,112 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace PowerTabDocument {
+
+/// Bump allocator for the objects that are read from a document. Individual
+/// allocations are never freed - all of the memory is released at once when
+/// the arena is destroyed, so the arena must outlive the objects in it.
+class Arena
+{
+public:
+    static const size_t BLOCK_SIZE;                         ///< Size of each block of memory that is allocated
+
+    // Member Variables
+private:
+    std::vector<std::unique_ptr<std::byte[]>> m_blocks;     ///< The blocks of memory that have been allocated
+    std::byte* m_current;                                   ///< Start of the unused memory in the current block
+    size_t m_remaining;                                     ///< Amount of unused memory in the current block
+
+public:
+    // Constructor/Destructor
+    Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// Returns uninitialized memory with the requested size and alignment
+    void* Allocate(size_t size, size_t alignment)
+    {
+        void* ptr = m_current;
+        if (!std::align(alignment, size, ptr, m_remaining))
+            return AllocateBlock(size, alignment);
+
+        m_current = static_cast<std::byte*>(ptr) + size;
+        m_remaining -= size;
+        return ptr;
+    }
+
+private:
+    void* AllocateBlock(size_t size, size_t alignment);
+};
+
+/// Standard allocator interface for an Arena, for use with
+/// std::allocate_shared
+template <class T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    // Member Variables
+private:
+    template <class U>
+    friend class ArenaAllocator;
+
+    Arena* m_arena;                                         ///< The arena that memory is allocated from
+
+public:
+    explicit ArenaAllocator(Arena& arena) : m_arena(&arena)
+    {
+    }
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.m_arena)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(m_arena->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t)
+    {
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const
+    {
+        return m_arena == other.m_arena;
+    }
+
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const
+    {
+        return m_arena != other.m_arena;
+    }
+};
+
+}
+
+#endif // ARENA_H
@@ -10,6 +10,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "powertabdocument.h"
+#include "arena.h"
 #include "powertabinputstream.h"
 #include "powertaboutputstream.h"
 
@@ -216,14 +217,21 @@ bool Document::Save(const PathType& fileName) const
 
 /// Loads a power tab file.
 /// @param fileName Full path of the file to load.
+/// @param systemHandler If provided, each system is passed to the handler as
+/// it is read, and the scores are left without any systems.
 /// @throw std::ifstream::failure
-void Document::Load(const boost::filesystem::path& fileName)
+void Document::Load(const boost::filesystem::path& fileName,
+                    const Score::SystemHandler& systemHandler)
 {
+    DeleteContents();
+
+    // The previous document's objects were freed above, so its arena can be
+    // released as well.
+    m_arena = std::make_unique<Arena>();
+
     boost::filesystem::ifstream fileStream(fileName, std::ifstream::in |
                                                          std::ifstream::binary);
-    PowerTabInputStream stream(fileStream);
-
-    DeleteContents();
+    PowerTabInputStream stream(fileStream, m_arena.get());
 
     // read the header
     if (!m_header.Deserialize(stream))
@@ -232,7 +240,7 @@ void Document::Load(const boost::filesystem::path& fileName)
     }
 
     // read the rest of the document
-    Deserialize(stream);
+    Deserialize(stream, systemHandler);
 
 #if 0
     m_header.SetVersion(PowerTabFileHeader::FILEVERSION_CURRENT);
@@ -242,16 +250,19 @@ void Document::Load(const boost::filesystem::path& fileName)
 
 /// Deserializes a file from an input stream
 /// @param stream Input stream to read from
+/// @param systemHandler If provided, each system is passed to the handler as
+/// it is read instead of being stored
 /// @return True if the document was deserialized, false if not
-bool Document::Deserialize(PowerTabInputStream& stream)
+bool Document::Deserialize(PowerTabInputStream& stream,
+                           const Score::SystemHandler& systemHandler)
 {
     // Set the version
     const uint16_t version = m_header.GetVersion();
 
     m_scoreArray.push_back(new Score("Guitar Score"));
     m_scoreArray.push_back(new Score("Bass Score"));
-    m_scoreArray[0]->Deserialize(stream, version);
-    m_scoreArray[1]->Deserialize(stream, version);
+    m_scoreArray[0]->Deserialize(stream, version, systemHandler);
+    m_scoreArray[1]->Deserialize(stream, version, systemHandler);
 
     // Read the document font settings
     for (size_t fontSettingIndex = 0; fontSettingIndex < NUM_FONT_SETTINGS;
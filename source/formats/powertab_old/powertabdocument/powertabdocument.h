@@ -14,15 +14,17 @@
 
 #include "powertabfileheader.h"
 #include "fontsetting.h"
+#include "score.h"
 
 #include <array>
 #include <boost/filesystem/path.hpp>
+#include <memory>
 #include <vector>
 
 namespace PowerTabDocument {
 
+class Arena;
 class Guitar;
-class Score;
 
 /// Loads and saves Power Tab files (.ptb)
 class Document
@@ -53,6 +55,7 @@ public:
     // Member Variables
 private:
     PowerTabFileHeader  m_header;                                   ///< The one and only header (contains file information)
+    std::unique_ptr<Arena> m_arena;                                 ///< Storage for the objects read by Load() (must outlive the scores)
     std::vector<Score*> m_scoreArray;                               ///< List of scores (zeroth element = guitar score, first element = bass score)
 
     std::array<FontSetting, NUM_FONT_SETTINGS> m_fontSettings; ///< List of global font settings
@@ -66,9 +69,11 @@ public:
     ~Document();
 
     bool Save(const PathType& fileName) const;
-    void Load(const PathType& fileName);
+    void Load(const PathType& fileName,
+              const Score::SystemHandler& systemHandler = Score::SystemHandler());
 
-    bool Deserialize(PowerTabInputStream& stream);
+    bool Deserialize(PowerTabInputStream& stream,
+                     const Score::SystemHandler& systemHandler = Score::SystemHandler());
 
     void DeleteContents();
 
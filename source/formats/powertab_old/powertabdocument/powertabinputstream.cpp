@@ -14,15 +14,27 @@
 #include "rect.h"
 #include "macros.h"
 
+#include <string>
+
 namespace PowerTabDocument {
 
 using std::string;
 
-PowerTabInputStream::PowerTabInputStream(std::istream& stream) :
-    m_stream(stream)
+PowerTabInputStream::PowerTabInputStream(std::istream& stream, Arena* arena) :
+    m_position(0), m_arena(arena)
 {
     // ensure that the stream will throw std::ifstream::failure if any errors occur
     stream.exceptions(std::istream::failbit | std::istream::badbit | std::istream::eofbit);
+
+    // Read the whole file up front rather than issuing a stream read for
+    // each field.
+    stream.seekg(0, std::ios_base::end);
+    const std::streamoff size = stream.tellg();
+    stream.seekg(0, std::ios_base::beg);
+
+    m_data.resize(static_cast<size_t>(size));
+    if (size != 0)
+        stream.read(m_data.data(), size);
 }
 
 // Read Functions
@@ -58,7 +70,7 @@ void PowerTabInputStream::ReadMFCString(string& str)
 
 	if (length != 0)
 	{
-		m_stream.read(&str[0], length);
+		std::memcpy(&str[0], Advance(length), length);
 	}
 }
 
@@ -129,7 +141,7 @@ void PowerTabInputStream::ReadClassInformation()
 
         *this >> schema;
         *this >> length;
-        m_stream.seekg(length, std::ios_base::cur);
+        Advance(length);
     }
 
     // otherwise, existing class index in obj_tag followed by new object
@@ -137,6 +149,14 @@ void PowerTabInputStream::ReadClassInformation()
 }
 
 
+void PowerTabInputStream::ThrowEndOfFile(size_t count) const
+{
+    throw std::ios_base::failure(
+        "Unexpected end of file at offset " + std::to_string(m_position) +
+        " while reading " + std::to_string(count) + " bytes (file size " +
+        std::to_string(m_data.size()) + ")");
+}
+
 /// Reads the length of a string from a data input stream.
 /// @return The length of the string, in characters
 uint32_t PowerTabInputStream::ReadMFCStringLength()
@@ -12,8 +12,11 @@
 #ifndef POWERTABINPUTSTREAM_H
 #define POWERTABINPUTSTREAM_H
 
+#include "arena.h"
+
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <istream>
 #include <memory>
 #include <vector>
@@ -28,10 +31,16 @@ class PowerTabInputStream
 {
     // Member Variables
 private:
-    std::istream& m_stream;
+    std::vector<char> m_data;
+    size_t m_position;
+    Arena* m_arena;
 
 public:
-    PowerTabInputStream(std::istream& stream);
+    /// Reads the entire contents of the stream into memory.
+    /// @param arena If provided, the document's objects are allocated from
+    /// the arena, which must outlive them.
+    /// @throw std::ifstream::failure if the stream cannot be read
+    PowerTabInputStream(std::istream& stream, Arena* arena = nullptr);
 
     // Read Functions
     uint32_t ReadCount();
@@ -43,6 +52,21 @@ private:
     void ReadClassInformation();
     uint32_t ReadMFCStringLength();
 
+    /// Returns a pointer to the next count bytes of data and advances past
+    /// them.
+    /// @throw std::ifstream::failure if the end of the data is reached
+    inline const char* Advance(size_t count)
+    {
+        if (count > m_data.size() - m_position)
+            ThrowEndOfFile(count);
+
+        const char* data = m_data.data() + m_position;
+        m_position += count;
+        return data;
+    }
+
+    [[noreturn]] void ThrowEndOfFile(size_t count) const;
+
 public:
 
     template <class T>
@@ -60,12 +84,46 @@ public:
         }
     }
 
+    /// Reads a list of objects like ReadVector, but passes each object to the
+    /// handler as soon as it is read rather than storing it. Each object is
+    /// allocated from its own arena, which is released after the handler
+    /// returns.
+    template <class T, class Handler>
+    void ReadEach(uint16_t version, Handler handler)
+    {
+        const uint32_t count = ReadCount();
+        Arena* const documentArena = m_arena;
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ReadClassInformation();
+
+            Arena objectArena;
+            m_arena = &objectArena;
+
+            std::shared_ptr<T> object;
+            try
+            {
+                object = std::allocate_shared<T>(ArenaAllocator<T>(objectArena));
+                object->Deserialize(*this, version);
+            }
+            catch (...)
+            {
+                m_arena = documentArena;
+                throw;
+            }
+
+            m_arena = documentArena;
+            handler(i, static_cast<const T&>(*object));
+        }
+    }
+
     /// Read data from the input stream
     /// @throw std::ifstream::failure if any errors occur
     template<class T>
     inline PowerTabInputStream& operator>>(T& data)
     {
-        m_stream.read(reinterpret_cast<char *>(&data), sizeof(data));
+        std::memcpy(&data, Advance(sizeof(data)), sizeof(data));
         return *this;
     }
 
@@ -78,7 +136,8 @@ public:
         vect.clear();
         vect.resize(size);
 
-        m_stream.read((char*)&vect[0], size * sizeof(T));
+        if (size != 0)
+            std::memcpy(&vect[0], Advance(size * sizeof(T)), size * sizeof(T));
     }
 
     template <class T, size_t N>
@@ -87,7 +146,10 @@ public:
         uint8_t size = 0;
         *this >> size;
 
-        m_stream.read((char*)&array[0], size * sizeof(T));
+        if (size > N)
+            throw std::ios_base::failure("Invalid array size");
+
+        std::memcpy(&array[0], Advance(size * sizeof(T)), size * sizeof(T));
     }
 
 private:
@@ -103,7 +165,9 @@ private:
     inline void ReadObject(std::vector<std::shared_ptr<T> >& vect,
                            uint16_t version)
     {
-        std::shared_ptr<T> object(std::make_shared<T>());
+        std::shared_ptr<T> object(
+            m_arena ? std::allocate_shared<T>(ArenaAllocator<T>(*m_arena))
+                    : std::make_shared<T>());
         object->Deserialize(*this, version);
         vect.push_back(object);
     }
@@ -79,6 +79,18 @@ bool Score::Serialize(PowerTabOutputStream& stream) const
 /// @param version File version
 /// @return True if the object was deserialized, false if not
 bool Score::Deserialize(PowerTabInputStream& stream, uint16_t version)
+{
+    return Deserialize(stream, version, SystemHandler());
+}
+
+/// Performs deserialization for the class
+/// @param stream Power Tab input stream to load from
+/// @param version File version
+/// @param systemHandler If provided, each system is passed to the handler as
+/// it is read instead of being stored in the score
+/// @return True if the object was deserialized, false if not
+bool Score::Deserialize(PowerTabInputStream& stream, uint16_t version,
+                        const SystemHandler& systemHandler)
 {
     stream.ReadVector(m_guitarArray, version);
     stream.ReadVector(m_chordDiagramArray, version);
@@ -87,7 +99,18 @@ bool Score::Deserialize(PowerTabInputStream& stream, uint16_t version)
     stream.ReadVector(m_tempoMarkerArray, version);
     stream.ReadVector(m_dynamicArray, version);
     stream.ReadVector(m_alternateEndingArray, version);
-    stream.ReadVector(m_systemArray, version);
+
+    // The symbols above refer to systems by index, so they are all available
+    // by the time the systems are read.
+    if (systemHandler)
+    {
+        m_systemArray.clear();
+        stream.ReadEach<System>(version, [&](size_t index, const System& system) {
+            systemHandler(*this, index, system);
+        });
+    }
+    else
+        stream.ReadVector(m_systemArray, version);
 
     return true;
 }
@@ -155,20 +178,20 @@ int Score::FindSystemIndex(const SystemConstPtr& system) const
 
 
 /// Finds all of the tempo markers that are in the given system
-void Score::GetTempoMarkersInSystem(std::vector<TempoMarkerPtr>& tempoMarkers, SystemConstPtr system) const
+void Score::GetTempoMarkersInSystem(std::vector<TempoMarkerPtr>& tempoMarkers, size_t systemIndex) const
 {
-    GetSymbolsInSystem(tempoMarkers, m_tempoMarkerArray, FindSystemIndex(system));
+    GetSymbolsInSystem(tempoMarkers, m_tempoMarkerArray, systemIndex);
 }
 
-void Score::GetAlternateEndingsInSystem(std::vector<AlternateEndingPtr>& endings, SystemConstPtr system) const
+void Score::GetAlternateEndingsInSystem(std::vector<AlternateEndingPtr>& endings, size_t systemIndex) const
 {
-    GetSymbolsInSystem(endings, m_alternateEndingArray, FindSystemIndex(system));
+    GetSymbolsInSystem(endings, m_alternateEndingArray, systemIndex);
 }
 
 /// Returns all of the dynamics located in the given system
-void Score::GetDynamicsInSystem(std::vector<Score::DynamicPtr> &dynamics, Score::SystemConstPtr system) const
+void Score::GetDynamicsInSystem(std::vector<Score::DynamicPtr> &dynamics, size_t systemIndex) const
 {
-    GetSymbolsInSystem(dynamics, m_dynamicArray, FindSystemIndex(system));
+    GetSymbolsInSystem(dynamics, m_dynamicArray, systemIndex);
 }
 
 /// Determines if a alternate ending index is valid
@@ -345,9 +368,9 @@ Score::GuitarInPtr Score::GetGuitarIn(size_t index) const
 }
 
 void Score::GetGuitarInsInSystem(std::vector<Score::GuitarInPtr> &guitarIns,
-                                 Score::SystemConstPtr system) const
+                                 size_t systemIndex) const
 {
-    GetSymbolsInSystem(guitarIns, m_guitarInArray, FindSystemIndex(system));
+    GetSymbolsInSystem(guitarIns, m_guitarInArray, systemIndex);
 }
 
 // Tempo Marker Functions
@@ -14,6 +14,7 @@
 
 #include "powertabobject.h"
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -51,6 +52,11 @@ public:
     typedef std::shared_ptr<const GuitarIn> GuitarInConstPtr;
     typedef std::shared_ptr<TempoMarker> TempoMarkerPtr;
 
+    /// Receives each system as it is read, for deserializing a score without
+    /// keeping all of its systems in memory.
+    typedef std::function<void(const Score &score, size_t systemIndex,
+                               const System &system)> SystemHandler;
+
 // Constructor/Destructor
 public:
     Score(const char* name);
@@ -58,6 +64,8 @@ public:
 // Serialization Functions
     bool Serialize(PowerTabOutputStream &stream) const override;
     bool Deserialize(PowerTabInputStream &stream, uint16_t version) override;
+    bool Deserialize(PowerTabInputStream &stream, uint16_t version,
+                     const SystemHandler &systemHandler);
 
     // TODO - these should probably not be here, since this class was not part
     // of the original power tab file format
@@ -90,7 +98,7 @@ public:
     size_t GetGuitarInCount() const;
     GuitarInPtr GetGuitarIn(size_t index) const;
     void GetGuitarInsInSystem(std::vector<GuitarInPtr>& guitarIns,
-                              SystemConstPtr system) const;
+                              size_t systemIndex) const;
 
 // Tempo Marker Functions
     bool IsValidTempoMarkerIndex(size_t index) const;
@@ -98,20 +106,20 @@ public:
     TempoMarkerPtr GetTempoMarker(size_t index) const;
 
     void GetTempoMarkersInSystem(std::vector<TempoMarkerPtr>& tempoMarkers,
-                                 SystemConstPtr system) const;
+                                 size_t systemIndex) const;
 
 // Dynamic Functions
     bool IsValidDynamicIndex(size_t index) const;
     size_t GetDynamicCount() const;
     DynamicPtr GetDynamic(size_t index) const;
-    void GetDynamicsInSystem(std::vector<DynamicPtr>& dynamics, SystemConstPtr system) const;
+    void GetDynamicsInSystem(std::vector<DynamicPtr>& dynamics, size_t systemIndex) const;
 
 // Alternate Ending Functions
     bool IsValidAlternateEndingIndex(size_t index) const;
     size_t GetAlternateEndingCount() const;
     AlternateEndingPtr GetAlternateEnding(size_t index) const;
 
-    void GetAlternateEndingsInSystem(std::vector<AlternateEndingPtr>& endings, SystemConstPtr system) const;
+    void GetAlternateEndingsInSystem(std::vector<AlternateEndingPtr>& endings, size_t systemIndex) const;
 
 // System Functions
     bool IsValidSystemIndex(size_t index) const;
@@ -38,36 +38,63 @@
 #include <score/utils/scoremerger.h>
 #include <score/utils/scorepolisher.h>
 
+#include <array>
 #include <cmath>
+#include <utility>
 
 PowerTabOldImporter::PowerTabOldImporter()
     : FileFormatImporter(FileFormat("Power Tab 1.7 Document", { "ptb" }))
 {
 }
 
+/// Holds a score that is being converted while the v1.7 document is read.
+struct PowerTabOldImporter::ScoreConversion
+{
+    Score myScore;
+
+    /// For each floating text item, its location in the first system below it
+    /// or, if there isn't one, the last system.
+    std::vector<SystemLocation> myTextLocations;
+    std::vector<bool> myIsTextPlaced;
+};
+
 void PowerTabOldImporter::load(const boost::filesystem::path &filename,
                                Score &score)
 {
-    PowerTabDocument::Document document;
-    document.Load(filename);
-
-    // TODO - handle font settings, etc.
-    ScoreInfo info;
-    convert(document.GetHeader(), info);
-    score.setScoreInfo(info);
-    score.setLineSpacing(document.GetTablatureStaffLineSpacing());
-    ScoreUtils::addStandardFilters(score);
-    
-    assert(document.GetNumberOfScores() == 2);
-
-    // Convert the guitar score.
-    Score guitarScore;
-    convert(*document.GetScore(0), guitarScore);
-
-    // Convert and then merge the bass score.
-    Score bassScore;
-    convert(*document.GetScore(1), bassScore);
-    ScoreMerger::merge(score, guitarScore, bassScore);
+    {
+        // Convert each system as soon as it has been read, rather than loading
+        // the entire v1.7 document and then converting it.
+        std::array<ScoreConversion, 2> conversions;
+        {
+            PowerTabDocument::Document document;
+            document.Load(filename,
+                          [&](const PowerTabDocument::Score &oldScore,
+                              size_t systemIndex,
+                              const PowerTabDocument::System &oldSystem) {
+                              ScoreConversion &conversion =
+                                  (&oldScore == document.GetScore(0))
+                                      ? conversions[0]
+                                      : conversions[1];
+                              convert(oldScore, systemIndex, oldSystem,
+                                      conversion);
+                          });
+
+            // TODO - handle font settings, etc.
+            ScoreInfo info;
+            convert(document.GetHeader(), info);
+            score.setScoreInfo(info);
+            score.setLineSpacing(document.GetTablatureStaffLineSpacing());
+            ScoreUtils::addStandardFilters(score);
+
+            assert(document.GetNumberOfScores() == 2);
+            for (size_t i = 0; i < conversions.size(); ++i)
+                convert(*document.GetScore(i), conversions[i]);
+        }
+
+        // Merge the guitar and bass scores.
+        ScoreMerger::merge(score, conversions[0].myScore,
+                           conversions[1].myScore);
+    }
 
     // Reformat the score, since the guitar and bass score from v1.7 may have
     // had different spacing.
@@ -148,27 +175,44 @@ void PowerTabOldImporter::convert(
 }
 
 void PowerTabOldImporter::convert(const PowerTabDocument::Score &oldScore,
-                                  Score &score)
+                                  ScoreConversion &conversion)
 {
+    Score &score = conversion.myScore;
+
     // Convert guitars to players and instruments.
     for (size_t i = 0; i < oldScore.GetGuitarCount(); ++i)
         convert(*oldScore.GetGuitar(i), score);
 
-    for (size_t i = 0; i < oldScore.GetSystemCount(); ++i)
-    {
-        System system;
-        convert(oldScore, oldScore.GetSystem(i), system);
-        score.insertSystem(system);
-    }
-
     // Convert Guitar In's to player changes.
     convertGuitarIns(oldScore, score);
 
     // Set up an initial dynamic for each guitar's initial volumes.
     convertInitialVolumes(oldScore, score);
 
+    // Attach any remaining floating text to the last system.
+    for (size_t i = 0; i < conversion.myTextLocations.size(); ++i)
+    {
+        if (conversion.myIsTextPlaced[i])
+            continue;
+
+        const SystemLocation &location = conversion.myTextLocations[i];
+        TextItem item(location.getPosition(),
+                      oldScore.GetFloatingText(i)->GetText());
+        score.getSystems()[location.getSystem()].insertTextItem(item);
+    }
+}
+
+void PowerTabOldImporter::convert(const PowerTabDocument::Score &oldScore,
+                                  size_t systemIndex,
+                                  const PowerTabDocument::System &oldSystem,
+                                  ScoreConversion &conversion)
+{
+    System system;
+    convert(oldScore, systemIndex, oldSystem, system);
+    conversion.myScore.insertSystem(std::move(system));
+
     // Convert floating text to the new text items.
-    convertFloatingText(oldScore, score);
+    convertFloatingText(oldScore, systemIndex, oldSystem, conversion);
 }
 
 void PowerTabOldImporter::convert(const PowerTabDocument::Guitar &guitar,
@@ -206,7 +250,8 @@ void PowerTabOldImporter::convert(const PowerTabDocument::Tuning &oldTuning,
 }
 
 void PowerTabOldImporter::convert(const PowerTabDocument::Score &oldScore,
-                                  PowerTabDocument::Score::SystemConstPtr oldSystem,
+                                  size_t systemIndex,
+                                  const PowerTabDocument::System &oldSystem,
                                   System &system)
 {
     // Ensure that there are a reasonable number of positions in the staff
@@ -215,21 +260,21 @@ void PowerTabOldImporter::convert(const PowerTabDocument::Score &oldScore,
 
     // Import barlines.
     Barline &startBar = system.getBarlines()[0];
-    convert(*oldSystem->GetStartBar(), startBar);
+    convert(*oldSystem.GetStartBar(), startBar);
 
     Barline &endBar = system.getBarlines()[1];
-    convert(*oldSystem->GetEndBar(), endBar);
+    convert(*oldSystem.GetEndBar(), endBar);
 
-    for (size_t i = 0; i < oldSystem->GetBarlineCount(); ++i)
+    for (size_t i = 0; i < oldSystem.GetBarlineCount(); ++i)
     {
         Barline bar;
-        convert(*oldSystem->GetBarline(i), bar);
+        convert(*oldSystem.GetBarline(i), bar);
         system.insertBarline(bar);
         lastPosition = std::max(lastPosition, bar.getPosition());
 
         // Copy the key and time signature of the last bar into the end bar,
         // since the v2.0 file format expects this.
-        if (i == oldSystem->GetBarlineCount() - 1)
+        if (i == oldSystem.GetBarlineCount() - 1)
         {
             KeySignature key = bar.getKeySignature();
             key.setVisible(false);
@@ -243,7 +288,7 @@ void PowerTabOldImporter::convert(const PowerTabDocument::Score &oldScore,
 
     // Import tempo markers.
     std::vector<std::shared_ptr<PowerTabDocument::TempoMarker>> tempos;
-    oldScore.GetTempoMarkersInSystem(tempos, oldSystem);
+    oldScore.GetTempoMarkersInSystem(tempos, systemIndex);
     for (auto &tempo : tempos)
     {
         TempoMarker marker;
@@ -253,7 +298,7 @@ void PowerTabOldImporter::convert(const PowerTabDocument::Score &oldScore,
 
     // Import alternate endings.
     std::vector<std::shared_ptr<PowerTabDocument::AlternateEnding>> endings;
-    oldScore.GetAlternateEndingsInSystem(endings, oldSystem);
+    oldScore.GetAlternateEndingsInSystem(endings, systemIndex);
     for (auto &ending : endings)
     {
         AlternateEnding newEnding;
@@ -262,26 +307,26 @@ void PowerTabOldImporter::convert(const PowerTabDocument::Score &oldScore,
     }
 
     // Import directions.
-    for (size_t i = 0; i < oldSystem->GetDirectionCount(); ++i)
+    for (size_t i = 0; i < oldSystem.GetDirectionCount(); ++i)
     {
         Direction direction;
-        convert(*oldSystem->GetDirection(i), direction);
+        convert(*oldSystem.GetDirection(i), direction);
         system.insertDirection(direction);
     }
 
     // Import chord text symbols.
-    for (size_t i = 0; i < oldSystem->GetChordTextCount(); ++i)
+    for (size_t i = 0; i < oldSystem.GetChordTextCount(); ++i)
     {
         ChordText chord;
-        convert(*oldSystem->GetChordText(i), chord);
+        convert(*oldSystem.GetChordText(i), chord);
         system.insertChord(chord);
     }
 
     std::vector<PowerTabDocument::Score::DynamicPtr> dynamics;
-    oldScore.GetDynamicsInSystem(dynamics, oldSystem);
+    oldScore.GetDynamicsInSystem(dynamics, systemIndex);
 
     // Import staves.
-    for (size_t i = 0; i < oldSystem->GetStaffCount(); ++i)
+    for (size_t i = 0; i < oldSystem.GetStaffCount(); ++i)
     {
         // Dynamics are now stored in the staff instead of the system.
         std::vector<PowerTabDocument::Score::DynamicPtr> dynamicsInStaff;
@@ -292,7 +337,7 @@ void PowerTabOldImporter::convert(const PowerTabDocument::Score &oldScore,
         }
 
         Staff staff;
-        int lastPosInStaff = convert(*oldSystem->GetStaff(i), dynamicsInStaff,
+        int lastPosInStaff = convert(*oldSystem.GetStaff(i), dynamicsInStaff,
                                      staff);
         system.insertStaff(staff);
         lastPosition = std::max(lastPosition, lastPosInStaff);
@@ -844,10 +889,10 @@ void PowerTabOldImporter::convertGuitarIns(
     std::array<int, PowerTabDocument::Score::MAX_NUM_GUITARS> activePlayers;
     activePlayers.fill(-1);
 
-    for (size_t i = 0; i < oldScore.GetSystemCount(); ++i)
+    for (size_t i = 0; i < score.getSystems().size(); ++i)
     {
         std::vector<PowerTabDocument::Score::GuitarInPtr> guitarIns;
-        oldScore.GetGuitarInsInSystem(guitarIns, oldScore.GetSystem(i));
+        oldScore.GetGuitarInsInSystem(guitarIns, i);
         if (guitarIns.empty())
             continue;
 
@@ -947,34 +992,35 @@ void PowerTabOldImporter::convertInitialVolumes(
 }
 
 void PowerTabOldImporter::convertFloatingText(
-    const PowerTabDocument::Score &oldScore, Score &score)
+    const PowerTabDocument::Score &oldScore, size_t systemIndex,
+    const PowerTabDocument::System &oldSystem, ScoreConversion &conversion)
 {
-    for (size_t i = 0, n = oldScore.GetFloatingTextCount(); i < n; ++i)
+    const size_t n = oldScore.GetFloatingTextCount();
+    conversion.myTextLocations.resize(n);
+    conversion.myIsTextPlaced.resize(n);
+
+    for (size_t i = 0; i < n; ++i)
     {
+        if (conversion.myIsTextPlaced[i])
+            continue;
+
         // Convert from an absolute (x,y) position to a (system,position)
-        // location.
+        // location. Until a system below the text is found, remember the
+        // location in the current system in case it is the last one.
         auto floatingText = oldScore.GetFloatingText(i);
         PowerTabDocument::Rect location = floatingText->GetRect();
 
-        // Figure out which system to attach to.
-        size_t attachedSystemIdx = oldScore.GetSystemCount() - 1;
-        for (size_t j = 0, n = oldScore.GetSystemCount(); j < n; ++j)
-        {
-            auto system = oldScore.GetSystem(j);
-            if (system->GetRect().GetBottom() > location.GetTop())
-            {
-                attachedSystemIdx = j;
-                break;
-            }
-        }
-
-        // Figure out what position in the system to use.
-        auto system = oldScore.GetSystem(attachedSystemIdx);
         const int position =
-            static_cast<int>(system->GetPositionFromX(location.GetX()));
+            static_cast<int>(oldSystem.GetPositionFromX(location.GetX()));
+        conversion.myTextLocations[i] =
+            SystemLocation(static_cast<int>(systemIndex), position);
 
-        // Create the text item in the new score.
-        TextItem item(position, floatingText->GetText());
-        score.getSystems()[attachedSystemIdx].insertTextItem(item);
+        if (oldSystem.GetRect().GetBottom() > location.GetTop())
+        {
+            // Create the text item in the new score.
+            TextItem item(position, floatingText->GetText());
+            conversion.myScore.getSystems()[systemIndex].insertTextItem(item);
+            conversion.myIsTextPlaced[i] = true;
+        }
     }
 }
@@ -67,15 +67,22 @@ public:
 private:
     static void convert(const PowerTabDocument::PowerTabFileHeader &header,
                         ScoreInfo &info);
+    struct ScoreConversion;
+
+    static void convert(const PowerTabDocument::Score &oldScore,
+                        ScoreConversion &conversion);
     static void convert(const PowerTabDocument::Score &oldScore,
-                        Score &score);
+                        size_t systemIndex,
+                        const PowerTabDocument::System &oldSystem,
+                        ScoreConversion &conversion);
 
     static void convert(const PowerTabDocument::Guitar &guitar, Score &score);
     static void convert(const PowerTabDocument::Tuning &oldTuning,
                         Tuning &tuning);
 
     static void convert(const PowerTabDocument::Score &oldScore,
-                        std::shared_ptr<const PowerTabDocument::System> oldSystem,
+                        size_t systemIndex,
+                        const PowerTabDocument::System &oldSystem,
                         System &system);
 
     static void convert(const PowerTabDocument::Barline &oldBar, Barline &bar);
@@ -112,7 +119,9 @@ private:
     static void convertInitialVolumes(const PowerTabDocument::Score &oldScore,
                                       Score &score);
     static void convertFloatingText(const PowerTabDocument::Score &oldScore,
-                                    Score &score);
+                                    size_t systemIndex,
+                                    const PowerTabDocument::System &oldSystem,
+                                    ScoreConversion &conversion);
 
     static void merge(Score &score1, Score &score2);
 };
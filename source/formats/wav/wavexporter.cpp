@@ -0,0 +1,186 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "wavexporter.h"
+
+#include <app/settingsmanager.h>
+#include <audio/settings.h>
+#include <midi/midifile.h>
+#include <midi/softwaresynth.h>
+
+#include <algorithm>
+#include <boost/endian/conversion.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <cmath>
+#include <cstdint>
+
+static const int SAMPLE_RATE = SoftwareSynth::DEFAULT_SAMPLE_RATE;
+static const int NUM_AUDIO_CHANNELS = 2;
+static const int BITS_PER_SAMPLE = 16;
+static const int BLOCK_SIZE = 1024;
+/// Extra time to render after the last event so that notes can ring out.
+static const int TAIL_MILLISECONDS = 2000;
+
+template <typename T>
+static void write(std::ostream &os, T val)
+{
+    val = boost::endian::native_to_little(val);
+    os.write(reinterpret_cast<const char *>(&val), sizeof(T));
+}
+
+namespace
+{
+/// A MIDI event, along with the audio frame where it should occur.
+struct TimedEvent
+{
+    int64_t myFrame;
+    const MidiEvent *myEvent;
+};
+} // namespace
+
+/// Merges the events from all tracks and computes their times, taking any
+/// tempo changes into account.
+static std::vector<TimedEvent> scheduleEvents(MidiFile &file)
+{
+    std::vector<TimedEvent> events;
+    for (MidiEventList &track : file.getTracks())
+    {
+        track.convertToAbsoluteTicks();
+        for (const MidiEvent &event : track)
+            events.push_back({ 0, &event });
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TimedEvent &a, const TimedEvent &b) {
+                         return a.myEvent->getTicks() < b.myEvent->getTicks();
+                     });
+
+    const int64_t ticks_per_beat = file.getTicksPerBeat();
+    Midi::Tempo tempo = Midi::BEAT_DURATION_120_BPM;
+    int prev_tick = 0;
+    // Accumulate the time in units of microseconds / ticks_per_beat to avoid
+    // rounding errors.
+    int64_t elapsed = 0;
+
+    for (TimedEvent &event : events)
+    {
+        elapsed += (event.myEvent->getTicks() - prev_tick) * tempo.count();
+        prev_tick = event.myEvent->getTicks();
+
+        event.myFrame = static_cast<int64_t>(std::llround(
+            static_cast<double>(elapsed) / ticks_per_beat * SAMPLE_RATE /
+            1000000.0));
+
+        if (event.myEvent->isTempoChange())
+            tempo = event.myEvent->getTempo();
+    }
+
+    return events;
+}
+
+static void writeHeader(std::ostream &os, uint32_t num_frames)
+{
+    const uint32_t block_align = NUM_AUDIO_CHANNELS * BITS_PER_SAMPLE / 8;
+    const uint32_t data_size = num_frames * block_align;
+
+    os << "RIFF";
+    write(os, static_cast<uint32_t>(36 + data_size));
+    os << "WAVE";
+
+    os << "fmt ";
+    write(os, static_cast<uint32_t>(16));
+    // PCM format.
+    write(os, static_cast<uint16_t>(1));
+    write(os, static_cast<uint16_t>(NUM_AUDIO_CHANNELS));
+    write(os, static_cast<uint32_t>(SAMPLE_RATE));
+    write(os, static_cast<uint32_t>(SAMPLE_RATE * block_align));
+    write(os, static_cast<uint16_t>(block_align));
+    write(os, static_cast<uint16_t>(BITS_PER_SAMPLE));
+
+    os << "data";
+    write(os, data_size);
+}
+
+WavExporter::WavExporter(const SettingsManager &settings_manager)
+    : FileFormatExporter(FileFormat("WAV Audio File", { "wav" })),
+      mySettingsManager(settings_manager)
+{
+}
+
+void WavExporter::save(const boost::filesystem::path &filename,
+                       const Score &score)
+{
+    boost::filesystem::ofstream os(filename, std::ios::out | std::ios::binary);
+    os.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
+
+    MidiFile::LoadOptions options;
+    options.myEnableMetronome = false;
+    options.myRecordPositionChanges = false;
+    {
+        auto settings = mySettingsManager.getReadHandle();
+        options.myVibratoStrength = settings->get(Settings::MidiVibratoLevel);
+        options.myWideVibratoStrength =
+            settings->get(Settings::MidiWideVibratoLevel);
+        options.myCurveResolution =
+            settings->get(Settings::MidiCurveResolution);
+    }
+
+    MidiFile file;
+    file.load(score, options);
+
+    const std::vector<TimedEvent> events = scheduleEvents(file);
+    const int64_t end_frame = events.empty() ? 0 : events.back().myFrame;
+    const int64_t num_frames =
+        end_frame + static_cast<int64_t>(SAMPLE_RATE) * TAIL_MILLISECONDS / 1000;
+
+    writeHeader(os, static_cast<uint32_t>(num_frames));
+
+    SoftwareSynth synth(SAMPLE_RATE);
+    std::vector<float> buffer(BLOCK_SIZE * NUM_AUDIO_CHANNELS);
+    std::vector<int16_t> samples(buffer.size());
+    int64_t current_frame = 0;
+
+    auto render_until = [&](int64_t frame) {
+        while (current_frame < frame)
+        {
+            const int block_size = static_cast<int>(
+                std::min<int64_t>(BLOCK_SIZE, frame - current_frame));
+            const size_t num_samples = block_size * NUM_AUDIO_CHANNELS;
+
+            synth.render(buffer.data(), block_size);
+
+            for (size_t i = 0; i < num_samples; ++i)
+            {
+                const float sample = std::clamp(buffer[i], -1.0f, 1.0f);
+                samples[i] = boost::endian::native_to_little(
+                    static_cast<int16_t>(std::lround(sample * 32767)));
+            }
+
+            os.write(reinterpret_cast<const char *>(samples.data()),
+                     num_samples * sizeof(int16_t));
+            current_frame += block_size;
+        }
+    };
+
+    for (const TimedEvent &event : events)
+    {
+        render_until(event.myFrame);
+        synth.processMessage(event.myEvent->getData());
+    }
+
+    render_until(num_frames);
+}
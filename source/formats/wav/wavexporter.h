@@ -0,0 +1,37 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FORMATS_WAVEXPORTER_H
+#define FORMATS_WAVEXPORTER_H
+
+#include <formats/fileformatmanager.h>
+
+/// Renders the score to audio with the built-in software synthesizer, and
+/// writes a 16-bit stereo WAV file.
+class WavExporter : public FileFormatExporter
+{
+public:
+    WavExporter(const SettingsManager &settings_manager);
+
+    virtual void save(const boost::filesystem::path &filename,
+                      const Score &score) override;
+
+private:
+    const SettingsManager &mySettingsManager;
+};
+
+#endif
@@ -0,0 +1,132 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "durationutils.h"
+
+#include <algorithm>
+#include <boost/rational.hpp>
+#include <score/system.h>
+#include <score/utils.h>
+#include <score/voiceutils.h>
+
+int DurationUtils::getTimeSignatureTicks(const TimeSignature &time_sig,
+                                         int ticks_per_beat)
+{
+    return boost::rational_cast<int>(
+        ticks_per_beat * time_sig.getBeatsPerMeasure() *
+        boost::rational<int>(4, time_sig.getBeatValue()));
+}
+
+int DurationUtils::getPulseTicks(const TimeSignature &time_sig,
+                                 int ticks_per_beat)
+{
+    return boost::rational_cast<int>(
+        boost::rational<int>(4, time_sig.getBeatValue()) *
+        boost::rational<int>(time_sig.getBeatsPerMeasure(),
+                             time_sig.getNumPulses()) *
+        ticks_per_beat);
+}
+
+int DurationUtils::getPositionTicks(const System &system, const Voice &voice,
+                                    const Position &pos, int bar_start,
+                                    int bar_end, int ticks_per_beat)
+{
+    int duration = boost::rational_cast<int>(
+        ticks_per_beat * VoiceUtils::getDurationTime(voice, pos));
+
+    // Whole rests must last for the entire bar, regardless of the time
+    // signature, unless they aren't the only item in the bar.
+    if (pos.isRest() && pos.getDurationType() == Position::WholeNote)
+    {
+        auto positions = ScoreUtils::findInRange(voice.getPositions(),
+                                                 bar_start, bar_end - 1);
+        if (std::all_of(positions.begin(), positions.end(),
+                        [&](const Position &other) { return &other == &pos; }))
+        {
+            const Barline *barline =
+                ScoreUtils::findByPosition(system.getBarlines(), bar_start);
+            duration = getTimeSignatureTicks(barline->getTimeSignature(),
+                                             ticks_per_beat);
+        }
+
+        if (pos.hasMultiBarRest())
+            duration *= pos.getMultiBarRestCount();
+    }
+
+    return duration;
+}
+
+int DurationUtils::getVoiceTicks(const System &system, const Voice &voice,
+                                 int bar_start, int bar_end, int end_position,
+                                 int ticks_per_beat)
+{
+    int duration = 0;
+    for (const Position &pos : ScoreUtils::findInRange(
+             voice.getPositions(), bar_start, end_position - 1))
+    {
+        duration += getPositionTicks(system, voice, pos, bar_start, bar_end,
+                                     ticks_per_beat);
+    }
+
+    return duration;
+}
+
+int DurationUtils::getMultiBarRestCount(const System &system, int bar_start,
+                                        int bar_end)
+{
+    int count = 1;
+    for (const Staff &staff : system.getStaves())
+    {
+        for (const Voice &voice : staff.getVoices())
+        {
+            for (const Position &pos : ScoreUtils::findInRange(
+                     voice.getPositions(), bar_start, bar_end))
+            {
+                if (pos.hasMultiBarRest())
+                    count = std::max(count, pos.getMultiBarRestCount());
+            }
+        }
+    }
+
+    return count;
+}
+
+int DurationUtils::getBarTicks(const System &system, int bar_start,
+                               int bar_end, int ticks_per_beat)
+{
+    int duration = 0;
+    for (const Staff &staff : system.getStaves())
+    {
+        for (const Voice &voice : staff.getVoices())
+        {
+            duration = std::max(duration,
+                                getVoiceTicks(system, voice, bar_start,
+                                              bar_end, bar_end, ticks_per_beat));
+        }
+    }
+
+    // The metronome plays each pulse of the time signature, and also fills
+    // any multi-bar rests.
+    const Barline *barline =
+        ScoreUtils::findByPosition(system.getBarlines(), bar_start);
+    const TimeSignature &time_sig = barline->getTimeSignature();
+    const int metronome_duration =
+        getMultiBarRestCount(system, bar_start, bar_end) *
+        time_sig.getNumPulses() * getPulseTicks(time_sig, ticks_per_beat);
+
+    return std::max(duration, metronome_duration);
+}
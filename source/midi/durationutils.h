@@ -0,0 +1,61 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MIDI_DURATIONUTILS_H
+#define MIDI_DURATIONUTILS_H
+
+class Position;
+class System;
+class TimeSignature;
+class Voice;
+
+/// Helpers for computing how many ticks the items in a score are played for,
+/// which are shared by the MIDI generation and the score timeline.
+namespace DurationUtils
+{
+/// Returns the expected duration (in ticks) of a bar with the time signature.
+/// This might not be the actual duration if the bar has too many notes.
+int getTimeSignatureTicks(const TimeSignature &time_sig, int ticks_per_beat);
+
+/// Returns the duration (in ticks) of one of the time signature's metronome
+/// pulses.
+int getPulseTicks(const TimeSignature &time_sig, int ticks_per_beat);
+
+/// Returns the number of ticks that the position is played for. A whole rest
+/// that is the only item in its bar lasts for the entire bar, and is extended
+/// for multi-bar rests.
+int getPositionTicks(const System &system, const Voice &voice,
+                     const Position &pos, int bar_start, int bar_end,
+                     int ticks_per_beat);
+
+/// Returns the number of ticks spanned by the voice's positions in the bar
+/// that occur before the end position.
+int getVoiceTicks(const System &system, const Voice &voice, int bar_start,
+                  int bar_end, int end_position, int ticks_per_beat);
+
+/// Returns the largest multi-bar rest count in the bar, or 1 if there isn't a
+/// multi-bar rest.
+int getMultiBarRestCount(const System &system, int bar_start, int bar_end);
+
+/// Returns the number of ticks that a bar spans when it is played. This is
+/// the longest of its voices, or the length of the time signature (for the
+/// metronome), including any multi-bar rests.
+int getBarTicks(const System &system, int bar_start, int bar_end,
+                int ticks_per_beat);
+} // namespace DurationUtils
+
+#endif
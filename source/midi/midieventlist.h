@@ -39,6 +39,8 @@ public:
 
     void concat(const MidiEventList &other);
 
+    size_t size() const { return myEvents.size(); }
+
     typedef std::vector<MidiEvent>::iterator iterator;
     typedef std::vector<MidiEvent>::const_iterator const_iterator;
 
@@ -17,10 +17,15 @@
   
 #include "midifile.h"
 
-#include "repeatcontroller.h"
-
+#include <algorithm>
+#include <array>
 #include <boost/rational.hpp>
 #include <chrono>
+#include <future>
+#include <midi/durationutils.h>
+#include <midi/playbackorder.h>
+#include <midi/scoretimeline.h>
+#include <thread>
 
 #include <score/generalmidi.h>
 #include <score/score.h>
@@ -31,20 +36,42 @@
 
 static const int PERCUSSION_CHANNEL = 9;
 static const int METRONOME_CHANNEL = PERCUSSION_CHANNEL;
-static const int DEFAULT_PPQ = 480;
 
 static const int PITCH_BEND_RANGE = 24;
 static const int DEFAULT_BEND = 64;
 static const int SLIDE_OUT_STEPS = 5;
 
-/// Pitch bend amount to bend a note by a quarter tone.
-static const boost::rational<int> BEND_QUARTER_TONE(
-    (Midi::MAX_MIDI_CHANNEL_EFFECT_LEVEL - DEFAULT_BEND), 2 * PITCH_BEND_RANGE);
+/// The largest bend (in quarter tones) that the pitch wheel can reach.
+static constexpr int MAX_BEND_QUARTER_TONES = 2 * PITCH_BEND_RANGE;
 
-static const int SLIDE_BELOW_BEND = boost::rational_cast<int>(
-    DEFAULT_BEND - SLIDE_OUT_STEPS * 2 * BEND_QUARTER_TONE);
-static const int SLIDE_ABOVE_BEND = boost::rational_cast<int>(
-    DEFAULT_BEND + SLIDE_OUT_STEPS * 2 * BEND_QUARTER_TONE);
+/// Pitch bend amounts to bend a note by each number of quarter tones, from
+/// -MAX_BEND_QUARTER_TONES to MAX_BEND_QUARTER_TONES.
+static constexpr std::array<uint8_t, 2 * MAX_BEND_QUARTER_TONES + 1>
+    THE_BEND_AMOUNTS = []() {
+        std::array<uint8_t, 2 * MAX_BEND_QUARTER_TONES + 1> amounts = {};
+        for (int i = 0; i < static_cast<int>(amounts.size()); ++i)
+        {
+            const int quarter_tones = i - MAX_BEND_QUARTER_TONES;
+            amounts[i] = static_cast<uint8_t>(
+                (DEFAULT_BEND * MAX_BEND_QUARTER_TONES +
+                 quarter_tones *
+                     (Midi::MAX_MIDI_CHANNEL_EFFECT_LEVEL - DEFAULT_BEND)) /
+                MAX_BEND_QUARTER_TONES);
+        }
+        return amounts;
+    }();
+
+/// Returns the pitch bend amount to bend a note by the given number of quarter
+/// tones.
+static int getBendAmount(int quarter_tones)
+{
+    return THE_BEND_AMOUNTS[std::clamp(quarter_tones, -MAX_BEND_QUARTER_TONES,
+                                       MAX_BEND_QUARTER_TONES) +
+                            MAX_BEND_QUARTER_TONES];
+}
+
+static const int SLIDE_BELOW_BEND = getBendAmount(-SLIDE_OUT_STEPS * 2);
+static const int SLIDE_ABOVE_BEND = getBendAmount(SLIDE_OUT_STEPS * 2);
 
 enum Velocity : uint8_t
 {
@@ -69,81 +96,6 @@ static int getChannel(const ActivePlayer &player)
     return getChannel(player.getPlayerNumber());
 }
 
-static bool findPositionChange(MidiEventList &event_list, int ticks,
-                               bool record_position_changes,
-                               RepeatController &repeat_controller,
-                               const SystemLocation &prev_location,
-                               SystemLocation &location)
-{
-    SystemLocation new_location;
-    if (repeat_controller.checkForRepeat(prev_location, location, new_location))
-    {
-        if (record_position_changes)
-        {
-            event_list.append(MidiEvent::positionChange(ticks, new_location));
-        }
-
-        location = new_location;
-        return true;
-    }
-
-    return false;
-}
-
-static SystemLocation moveToNextBar(MidiEventList &event_list, int ticks,
-                                    bool record_position_changes,
-                                    const System &system,
-                                    SystemLocation location, int next_bar_pos,
-                                    RepeatController &repeat_controller)
-{
-    SystemLocation prev_location = location;
-    SystemLocation new_location;
-
-    // Move to the next barline and follow any directions / repeats / alternate
-    // endings.
-    location.setPosition(next_bar_pos);
-
-    if (findPositionChange(event_list, ticks, record_position_changes,
-                           repeat_controller, prev_location, location))
-    {
-        return location;
-    }
-
-    // If we're at the end of the system, shift to the next system and also
-    // check for a position change there.
-    if (next_bar_pos == system.getBarlines().back().getPosition())
-    {
-        location.setSystem(location.getSystem() + 1);
-        location.setPosition(0);
-
-        if (findPositionChange(event_list, ticks, record_position_changes,
-                               repeat_controller, prev_location, location))
-        {
-            return location;
-        }
-    }
-
-    return location;
-}
-
-/// Returns the start and end barline around the given position.
-std::pair<const Barline &, const Barline &>
-getSurroundingBarlines(const System &system, int position)
-{
-    // If we're exactly on top of a barline, use that instead of grabbing the
-    // preceding barline.
-    const Barline *current_bar = ScoreUtils::findByPosition(
-        system.getBarlines(), position);
-    if (!current_bar)
-        current_bar = system.getPreviousBarline(position);
-
-    const Barline *next_bar = system.getNextBarline(position);
-    assert(next_bar);
-
-    return { *current_bar, *next_bar };
-}
-
-
 MidiFile::MidiFile() : myTicksPerBeat(0)
 {
 }
@@ -151,15 +103,15 @@ MidiFile::MidiFile() : myTicksPerBeat(0)
 void MidiFile::load(const Score &score, const LoadOptions &options)
 {
     myTicksPerBeat = DEFAULT_PPQ;
-
-    RepeatController repeat_controller(score);
+    myPlaybackOrder = PlaybackOrder(score);
 
     MidiEventList master_track;
     MidiEventList metronome_track;
 
     // Set the initial channel volume and pitch bend range..
-    std::vector<MidiEventList> regular_tracks(score.getPlayers().size());
-    for (unsigned int i = 0; i < score.getPlayers().size(); ++i)
+    const int num_players = static_cast<int>(score.getPlayers().size());
+    std::vector<MidiEventList> regular_tracks(num_players);
+    for (int i = 0; i < num_players; ++i)
     {
         regular_tracks[i].append(MidiEvent::volumeChange(
             0, getChannel(i), static_cast<uint8_t>(VolumeLevel::fff)));
@@ -172,58 +124,69 @@ void MidiFile::load(const Score &score, const LoadOptions &options)
 
     }
 
-    SystemLocation location(0, 0);
-    std::vector<uint8_t> active_bends;
-    int system_index = -1;
-    int current_tick = 0;
-    Midi::Tempo current_tempo = Midi::BEAT_DURATION_120_BPM;
+    // First, walk through the score in playback order to determine the start
+    // tick and tempo of each bar. This also generates the tempo and metronome
+    // events.
+    std::vector<PerformedBar> bars;
+    const int end_tick = generateTimeline(score, options, master_track,
+                                          metronome_track, bars);
 
-    while (location.getSystem() < static_cast<int>(score.getSystems().size()))
-    {
-        const System &system = score.getSystems()[location.getSystem()];
-        auto [current_bar, next_bar] =
-            getSurroundingBarlines(system, location.getPosition());
+    // Each staff only depends on the bar timeline, so the staves can be
+    // processed in parallel.
+    size_t num_staves = 0;
+    for (const System &system : score.getSystems())
+        num_staves = std::max(num_staves, system.getStaves().size());
 
-        if (location.getSystem() != system_index)
-        {
-            active_bends.resize(system.getStaves().size(), DEFAULT_BEND);
-            system_index = location.getSystem();
-        }
+    std::vector<std::vector<MidiEventList>> staff_tracks(num_staves);
+    std::vector<std::vector<size_t>> staff_bar_offsets(num_staves);
 
-        const int start_tick = current_tick;
-        current_tempo =
-            addTempoEvent(master_track, start_tick, current_tempo, score,
-                          location, repeat_controller,
-                          current_bar.getPosition(), next_bar.getPosition());
+    const int num_threads = std::max(
+        1, std::min(static_cast<int>(num_staves),
+                    static_cast<int>(std::thread::hardware_concurrency())));
+    std::vector<std::future<void>> tasks;
+
+    for (int i = 0; i < num_threads; ++i)
+    {
+        tasks.push_back(std::async(std::launch::async, [&](int first) {
+            for (size_t staff_index = first; staff_index < num_staves;
+                 staff_index += num_threads)
+            {
+                staff_tracks[staff_index].resize(num_players);
+                generateStaffEvents(staff_tracks[staff_index],
+                                    staff_bar_offsets[staff_index], score,
+                                    bars, static_cast<int>(staff_index),
+                                    options);
+            }
+        }, i));
+    }
 
-        for (unsigned int staff_index = 0; staff_index < system.getStaves().size();
-             ++staff_index)
+    for (auto &&task : tasks)
+        task.get();
+
+    // Merge the events for each staff, in the same order that they would have
+    // been generated by processing each bar sequentially. This ensures that
+    // the output doesn't depend on how the work was scheduled.
+    for (size_t bar = 0; bar < bars.size(); ++bar)
+    {
+        for (size_t staff_index = 0; staff_index < num_staves; ++staff_index)
         {
-            const Staff &staff = system.getStaves()[staff_index];
+            const std::vector<MidiEventList> &tracks =
+                staff_tracks[staff_index];
+            const std::vector<size_t> &offsets = staff_bar_offsets[staff_index];
 
-            for (unsigned int voice_index = 0; voice_index < staff.getVoices().size();
-                 ++voice_index)
+            for (int player = 0; player < num_players; ++player)
             {
-                const int end_tick = addEventsForBar(
-                    regular_tracks, active_bends[staff_index], start_tick,
-                    current_tempo, score, system, location.getSystem(), staff,
-                    staff_index, staff.getVoices()[voice_index], voice_index,
-                    current_bar.getPosition(), next_bar.getPosition(),
-                    options);
-
-                current_tick = std::max(current_tick, end_tick);
+                const size_t begin =
+                    (bar == 0) ? 0 : offsets[(bar - 1) * num_players + player];
+                const size_t end = offsets[bar * num_players + player];
+
+                std::for_each(tracks[player].begin() + begin,
+                              tracks[player].begin() + end,
+                              [&](const MidiEvent &event) {
+                                  regular_tracks[player].append(event);
+                              });
             }
         }
-
-        // Generate metronome events.
-        current_tick = std::max(current_tick,
-                                generateMetronome(metronome_track, start_tick,
-                                                  system, current_bar, next_bar,
-                                                  location, options));
-
-        location = moveToNextBar(
-            metronome_track, current_tick, options.myRecordPositionChanges,
-            system, location, next_bar.getPosition(), repeat_controller);
     }
 
     myTracks.push_back(master_track);
@@ -233,9 +196,11 @@ void MidiFile::load(const Score &score, const LoadOptions &options)
 
     for (MidiEventList &track : myTracks)
     {
-        track.append(MidiEvent::endOfTrack(current_tick));
+        track.append(MidiEvent::endOfTrack(end_tick));
         track.convertToDeltaTicks();
     }
+
+    myPerformedBars = std::move(bars);
 }
 
 int MidiFile::generateMetronome(MidiEventList &event_list, int current_tick,
@@ -248,33 +213,12 @@ int MidiFile::generateMetronome(MidiEventList &event_list, int current_tick,
     const TimeSignature &time_sig = current_bar.getTimeSignature();
 
     const int num_pulses = time_sig.getNumPulses();
-    const int beats_per_measure = time_sig.getBeatsPerMeasure();
-    const int beat_value = time_sig.getBeatValue();
-
-    // Figure out the duration of a pulse.
-    const int duration = boost::rational_cast<int>(
-        boost::rational<int>(4, beat_value) *
-        boost::rational<int>(beats_per_measure, num_pulses) * myTicksPerBeat);
+    const int duration = DurationUtils::getPulseTicks(time_sig, myTicksPerBeat);
 
     // Check for multi-bar rests, as we need to generate more metronome events
     // to fill the extra bars.
-    int num_repeats = 1;
-    for (const Staff &staff : system.getStaves())
-    {
-        for (const Voice &voice : staff.getVoices())
-        {
-            for (const Position &pos : ScoreUtils::findInRange(
-                     voice.getPositions(), current_bar.getPosition(),
-                     next_bar.getPosition()))
-            {
-                if (pos.hasMultiBarRest())
-                {
-                    num_repeats =
-                        std::max(num_repeats, pos.getMultiBarRestCount());
-                }
-            }
-        }
-    }
+    const int num_repeats = DurationUtils::getMultiBarRestCount(
+        system, current_bar.getPosition(), next_bar.getPosition());
 
     for (int repeat = 0; repeat < num_repeats; ++repeat)
     {
@@ -298,69 +242,32 @@ int MidiFile::generateMetronome(MidiEventList &event_list, int current_tick,
     return current_tick;
 }
 
-/// Return the expected duration (in ticks) of the bar. This might not be the
-/// actual duration if the bar has too many notes.
-static int
-computeBarDurationTicks(const TimeSignature &time_sig, int ticks_per_beat)
-{
-    return boost::rational_cast<int>(
-        ticks_per_beat * time_sig.getBeatsPerMeasure() *
-        boost::rational<int>(4, time_sig.getBeatValue()));
-}
-
-/// Compute the tempo in microseconds.
-static Midi::Tempo
-computeTempo(const TempoMarker &marker)
-{
-    // Convert the values in the TempoMarker::BeatType enum to a factor that
-    // will scale the bpm value to be in terms of quarter notes.
-    boost::rational<int> scale(2, 1 << (marker.getBeatType() / 2));
-    if (marker.getBeatType() % 2 != 0)
-        scale *= boost::rational<int>(3, 2);
-
-    // Compute the number of microseconds per quarter note.
-    return Midi::Tempo(boost::rational_cast<int>(
-        60000000 / (scale * marker.getBeatsPerMinute())));
-}
-
-/// Finds the next tempo marker, along with the duration in ticks between the
-/// two bars.
-/// Note that this takes a copy of the repeat controller, since it shouldn't
-/// affect the main loop's state.
+/// Finds the next tempo marker after the given bar (in playback order), along
+/// with the duration in ticks between the two bars.
 static const TempoMarker *
-findNextTempoMarker(const Score &score, SystemLocation location,
-                    RepeatController repeat_controller,
-                    const int ticks_per_beat, int &duration)
+findNextTempoMarker(const Score &score, const PlaybackOrder &order,
+                    size_t bar_index, const int ticks_per_beat, int &duration)
 {
-    const SystemLocation start_location = location;
-
-    // Unused since moveToNextBar() is not configured to record position
-    // changes.
-    MidiEventList event_list;
-    const int current_tick = -1;
+    const std::vector<PlaybackOrder::Bar> &bars = order.getBars();
+    const SystemLocation &start_location = bars[bar_index].myLocation;
 
-    const int num_systems = static_cast<int>(score.getSystems().size());
-    while (location.getSystem() < num_systems)
+    for (size_t i = bar_index; i < bars.size(); ++i)
     {
-        const System &system = score.getSystems()[location.getSystem()];
-        auto [current_bar, next_bar] =
-            getSurroundingBarlines(system, location.getPosition());
+        const PlaybackOrder::Bar &bar = bars[i];
+        const System &system = score.getSystems()[bar.myLocation.getSystem()];
 
         // Loop until we find the next tempo marker.
-        auto markers = ScoreUtils::findInRange(system.getTempoMarkers(),
-                                               current_bar.getPosition(),
-                                               next_bar.getPosition() - 1);
+        auto markers = ScoreUtils::findInRange(
+            system.getTempoMarkers(), bar.myBarStart, bar.myBarEnd - 1);
         // Ensure we don't find our original tempo marker we started from.
-        if (!markers.empty() && location != start_location)
+        if (!markers.empty() && bar.myLocation != start_location)
             return &markers.back();
 
         // Count how much time there is between the two tempo markers.
-        duration += computeBarDurationTicks(current_bar.getTimeSignature(),
-                                            ticks_per_beat);
-
-        location = moveToNextBar(
-            event_list, current_tick, /* record_position_changes */ false,
-            system, location, next_bar.getPosition(), repeat_controller);
+        const Barline *barline =
+            ScoreUtils::findByPosition(system.getBarlines(), bar.myBarStart);
+        duration += DurationUtils::getTimeSignatureTicks(
+            barline->getTimeSignature(), ticks_per_beat);
     }
 
     return nullptr;
@@ -369,13 +276,12 @@ findNextTempoMarker(const Score &score, SystemLocation location,
 Midi::Tempo
 MidiFile::addTempoEvent(MidiEventList &event_list, int current_tick,
                         Midi::Tempo current_tempo, const Score &score,
-                        const SystemLocation &location,
-                        const RepeatController &repeat_controller,
-                        int bar_start, int bar_end)
+                        const PlaybackOrder &order, size_t bar_index)
 {
-    const System &system = score.getSystems()[location.getSystem()];
-    auto markers = ScoreUtils::findInRange(system.getTempoMarkers(), bar_start,
-                                           bar_end - 1);
+    const PlaybackOrder::Bar &bar = order.getBars()[bar_index];
+    const System &system = score.getSystems()[bar.myLocation.getSystem()];
+    auto markers = ScoreUtils::findInRange(system.getTempoMarkers(),
+                                           bar.myBarStart, bar.myBarEnd - 1);
     if (markers.empty())
         return current_tempo;
 
@@ -385,7 +291,7 @@ MidiFile::addTempoEvent(MidiEventList &event_list, int current_tick,
     if (marker.getMarkerType() != TempoMarker::AlterationOfPace)
     {
         // Simple change of tempo.
-        current_tempo = computeTempo(marker);
+        current_tempo = ScoreTimeline::computeTempo(marker);
         event_list.append(MidiEvent::setTempo(current_tick, current_tempo));
     }
     else
@@ -393,7 +299,7 @@ MidiFile::addTempoEvent(MidiEventList &event_list, int current_tick,
         // Find the next tempo marker, if any.
         int duration = 0;
         const TempoMarker *next_marker = findNextTempoMarker(
-            score, location, repeat_controller, myTicksPerBeat, duration);
+            score, order, bar_index, myTicksPerBeat, duration);
 
         // Skip if the next tempo marker is also an alteration of pace!
         if (next_marker &&
@@ -408,7 +314,10 @@ MidiFile::addTempoEvent(MidiEventList &event_list, int current_tick,
         // tempo!
         Midi::Tempo delta_tempo{ 0 };
         if (next_marker)
-            delta_tempo = computeTempo(*next_marker) - current_tempo;
+        {
+            delta_tempo =
+                ScoreTimeline::computeTempo(*next_marker) - current_tempo;
+        }
         else if (marker.getAlterationOfPace() == TempoMarker::Accelerando)
             delta_tempo = -current_tempo / 2;
         else if (marker.getAlterationOfPace() == TempoMarker::Ritardando)
@@ -433,28 +342,6 @@ MidiFile::addTempoEvent(MidiEventList &event_list, int current_tick,
     return current_tempo;
 }
 
-static int getWholeRestDuration(const System &system, const Voice &voice,
-                                const Position &pos, int bar_start, int bar_end,
-                                int original_duration, int ticks_per_beat)
-{
-    // If the whole rest is not the only item in the bar, treat it like a
-    // regular rest.
-    for (int i = bar_start; i < bar_end; ++i)
-    {
-        const Position *other_pos =
-            ScoreUtils::findByPosition(voice.getPositions(), i);
-
-        if (other_pos && other_pos != &pos)
-            return original_duration;
-    }
-
-    // Otherwise, extend the rest for the entire bar.
-    const Barline *barline =
-        ScoreUtils::findByPosition(system.getBarlines(), bar_start);
-    const TimeSignature& time_sig = barline->getTimeSignature();
-    return computeBarDurationTicks(time_sig, ticks_per_beat);
-}
-
 static int getActualNotePitch(const Note &note, const Tuning &tuning)
 {
     const int open_string_pitch =
@@ -528,35 +415,44 @@ struct BendEventInfo
     uint8_t myBendAmount;
 };
 
+/// Returns the number of events for a gradual change of the given number of
+/// steps (e.g. pitch wheel values). By default there is an event for each
+/// step, but the curve resolution can limit the number of events per beat.
+static int getCurveEventCount(int num_steps, int duration, int ppq,
+                              int resolution)
+{
+    if (resolution <= 0)
+        return num_steps;
+
+    return std::min(num_steps, std::max(1, duration * resolution / ppq));
+}
+
 static void generateGradualBend(std::vector<BendEventInfo> &bends,
                                 int start_tick, int duration, int start_bend,
-                                int release_bend)
+                                int release_bend, int ppq, int resolution)
 {
-    const int num_events = std::abs(start_bend - release_bend);
+    const int delta = release_bend - start_bend;
+    const int num_events =
+        getCurveEventCount(std::abs(delta), duration, ppq, resolution);
     if (!num_events)
         return;
 
     const int event_duration = duration / num_events;
     for (int i = 1; i <= num_events; ++i)
     {
-        const int tick = start_tick + i * event_duration;
-        if (start_bend < release_bend)
-            bends.push_back(BendEventInfo(tick, start_bend + i));
-        else
-            bends.push_back(BendEventInfo(tick, start_bend - i));
+        bends.emplace_back(start_tick + i * event_duration,
+                           start_bend + delta * i / num_events);
     }
 }
 
 static void generateBends(std::vector<BendEventInfo> &bends,
                           uint8_t &active_bend, int start_tick, int duration,
-                          int ppq, const Note &note)
+                          int ppq, int resolution, const Note &note)
 {
     const Bend &bend = note.getBend();
 
-    const int bend_amount = boost::rational_cast<int>(
-        DEFAULT_BEND + bend.getBentPitch() * BEND_QUARTER_TONE);
-    const int release_amount = boost::rational_cast<int>(
-        DEFAULT_BEND + bend.getReleasePitch() * BEND_QUARTER_TONE);
+    const int bend_amount = getBendAmount(bend.getBentPitch());
+    const int release_amount = getBendAmount(bend.getReleasePitch());
 
     switch (bend.getType())
     {
@@ -573,13 +469,13 @@ static void generateBends(std::vector<BendEventInfo> &bends,
             {
                 // Bend over a 32nd note.
                 generateGradualBend(bends, start_tick, ppq / 8, DEFAULT_BEND,
-                                    bend_amount);
+                                    bend_amount, ppq, resolution);
             }
             else if (bend.getDuration() == 1)
             {
                 // Bend over the current note duration.
                 generateGradualBend(bends, start_tick, duration, DEFAULT_BEND,
-                                    bend_amount);
+                                    bend_amount, ppq, resolution);
             }
             // TODO - implement bends that stretch over multiple notes.
             break;
@@ -587,7 +483,7 @@ static void generateBends(std::vector<BendEventInfo> &bends,
         case Bend::BendAndRelease:
             // Bend up to the bent pitch for half of the note duration.
             generateGradualBend(bends, start_tick, duration / 2, DEFAULT_BEND,
-                                bend_amount);
+                                bend_amount, ppq, resolution);
             break;
         default:
             break;
@@ -605,17 +501,17 @@ static void generateBends(std::vector<BendEventInfo> &bends,
 
         case Bend::PreBendAndRelease:
             generateGradualBend(bends, start_tick, duration, bend_amount,
-                                release_amount);
+                                release_amount, ppq, resolution);
             break;
 
         case Bend::BendAndRelease:
             generateGradualBend(bends, start_tick + duration / 2, duration / 2,
-                                bend_amount, release_amount);
+                                bend_amount, release_amount, ppq, resolution);
             break;
 
         case Bend::GradualRelease:
             generateGradualBend(bends, start_tick, duration, active_bend,
-                                release_amount);
+                                release_amount, ppq, resolution);
             break;
         default:
             break;
@@ -636,8 +532,8 @@ static void generateBends(std::vector<BendEventInfo> &bends,
 }
 
 static void generateSlides(std::vector<BendEventInfo> &bends, int start_tick,
-                           int note_duration, int ppq, const Note &note,
-                           const Note *next_note)
+                           int note_duration, int ppq, int resolution,
+                           const Note &note, const Note *next_note)
 {
     if (note.hasProperty(Note::ShiftSlide) ||
         note.hasProperty(Note::LegatoSlide) ||
@@ -651,10 +547,8 @@ static void generateSlides(std::vector<BendEventInfo> &bends, int start_tick,
         {
             if (next_note)
             {
-                bend_amount = boost::rational_cast<int>(
-                    DEFAULT_BEND +
-                    (next_note->getFretNumber() - note.getFretNumber()) * 2 *
-                        BEND_QUARTER_TONE);
+                bend_amount = getBendAmount(
+                    (next_note->getFretNumber() - note.getFretNumber()) * 2);
             }
             else
             {
@@ -671,7 +565,8 @@ static void generateSlides(std::vector<BendEventInfo> &bends, int start_tick,
         // somewhat more realistic-sounding.
         const int slide_duration = note_duration / 3;
         generateGradualBend(bends, start_tick + note_duration - slide_duration,
-                            slide_duration, DEFAULT_BEND, bend_amount);
+                            slide_duration, DEFAULT_BEND, bend_amount, ppq,
+                            resolution);
 
         // Reset pitch wheel after note is played.
         bends.push_back(
@@ -688,7 +583,7 @@ static void generateSlides(std::vector<BendEventInfo> &bends, int start_tick,
         // Slide over a 16th note.
         const int slide_duration = ppq / 4;
         generateGradualBend(bends, start_tick, slide_duration, bend_amount,
-                            DEFAULT_BEND);
+                            DEFAULT_BEND, ppq, resolution);
     }
 }
 
@@ -715,8 +610,8 @@ struct VolumeSwellEvent
 
 static std::vector<VolumeSwellEvent>
 generateVolumeSwell(const int start_tick, int duration,
-                    const int ticks_per_beat, const Voice &voice,
-                    const Position &start_pos)
+                    const int ticks_per_beat, const int resolution,
+                    const Voice &voice, const Position &start_pos)
 {
     std::vector<VolumeSwellEvent> events;
 
@@ -737,17 +632,18 @@ generateVolumeSwell(const int start_tick, int duration,
 
     const auto start_vol = static_cast<int>(swell.getStartVolume());
     const auto end_vol = static_cast<int>(swell.getEndVolume());
-    const int num_events = std::abs(start_vol - end_vol);
+    const int delta = end_vol - start_vol;
+    const int num_events = getCurveEventCount(std::abs(delta), duration,
+                                              ticks_per_beat, resolution);
     if (!num_events)
         return {};
 
     events.reserve(num_events);
     const int event_duration = duration / num_events;
-    const int increment = (start_vol < end_vol) ? 1 : -1;
     for (int i = 0; i < num_events; ++i)
     {
-        const int tick = start_tick + i * event_duration;
-        events.emplace_back(tick, start_vol + i * increment);
+        events.emplace_back(start_tick + i * event_duration,
+                            start_vol + delta * i / num_events);
     }
 
     return events;
@@ -760,7 +656,7 @@ MidiFile::addEventsForBar(std::vector<MidiEventList> &tracks,
                           const System &system, int system_index,
                           const Staff &staff, int staff_index,
                           const Voice &voice, int voice_index, int bar_start,
-                          int bar_end, const LoadOptions &options)
+                          int bar_end, const LoadOptions &options) const
 {
     ScoreLocation location(score, system_index, staff_index, voice_index);
     const Voice *prev_voice = VoiceUtils::getAdjacentVoice(location, -1);
@@ -815,22 +711,11 @@ MidiFile::addEventsForBar(std::vector<MidiEventList> &tracks,
             continue;
 
         const SystemLocation system_location(system_index, position);
-        int duration = getDurationTicks(voice, *pos, myTicksPerBeat);
+        int duration = DurationUtils::getPositionTicks(
+            system, voice, *pos, bar_start, bar_end, myTicksPerBeat);
 
         if (pos->isRest())
         {
-            // For whole rests, they must last for the entire bar, regardless
-            // of time signature.
-            if (pos->getDurationType() == Position::WholeNote)
-            {
-                duration = getWholeRestDuration(system, voice, *pos, bar_start,
-                                                bar_end, duration, myTicksPerBeat);
-
-                // Extend for multi-bar rests.
-                if (pos->hasMultiBarRest())
-                    duration *= pos->getMultiBarRestCount();
-            }
-
             current_tick += duration;
             continue;
         }
@@ -853,7 +738,8 @@ MidiFile::addEventsForBar(std::vector<MidiEventList> &tracks,
         if (pos->hasVolumeSwell())
         {
             std::vector<VolumeSwellEvent> events = generateVolumeSwell(
-                current_tick, duration, myTicksPerBeat, voice, *pos);
+                current_tick, duration, myTicksPerBeat,
+                options.myCurveResolution, voice, *pos);
 
             for (const VolumeSwellEvent &event : events)
             {
@@ -1005,7 +891,8 @@ MidiFile::addEventsForBar(std::vector<MidiEventList> &tracks,
                     note.hasProperty(Note::SlideOutOfUpwards))
                 {
                     generateSlides(bend_events, current_tick, duration,
-                                   myTicksPerBeat, note,
+                                   myTicksPerBeat, options.myCurveResolution,
+                                   note,
                                    VoiceUtils::getNextNote(voice, position,
                                                            note.getString(),
                                                            next_voice));
@@ -1014,7 +901,8 @@ MidiFile::addEventsForBar(std::vector<MidiEventList> &tracks,
                 if (note.hasBend())
                 {
                     generateBends(bend_events, active_bend, current_tick,
-                                  duration, myTicksPerBeat, note);
+                                  duration, myTicksPerBeat,
+                                  options.myCurveResolution, note);
                 }
 
                 for (const BendEventInfo &event : bend_events)
@@ -1109,3 +997,109 @@ MidiFile::addEventsForBar(std::vector<MidiEventList> &tracks,
 
     return current_tick;
 }
+
+int MidiFile::generateTimeline(const Score &score, const LoadOptions &options,
+                               MidiEventList &master_track,
+                               MidiEventList &metronome_track,
+                               std::vector<PerformedBar> &bars)
+{
+    int current_tick = 0;
+    Midi::Tempo current_tempo = Midi::BEAT_DURATION_120_BPM;
+
+    const std::vector<PlaybackOrder::Bar> &order = myPlaybackOrder.getBars();
+    bars.reserve(order.size());
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        const PlaybackOrder::Bar &bar = order[i];
+        const SystemLocation &location = bar.myLocation;
+        const System &system = score.getSystems()[location.getSystem()];
+        const Barline &current_bar =
+            *ScoreUtils::findByPosition(system.getBarlines(), bar.myBarStart);
+        const Barline &next_bar =
+            *ScoreUtils::findByPosition(system.getBarlines(), bar.myBarEnd);
+
+        const int start_tick = current_tick;
+
+        // Record any repeats or directions that were followed to reach this
+        // bar.
+        if (bar.myIsJump && options.myRecordPositionChanges)
+        {
+            metronome_track.append(
+                MidiEvent::positionChange(start_tick, location));
+        }
+
+        current_tempo = addTempoEvent(master_track, start_tick, current_tempo,
+                                      score, myPlaybackOrder, i);
+
+        bars.push_back({ location.getSystem(), bar.myBarStart, bar.myBarEnd,
+                         start_tick, current_tempo });
+
+        // Generate metronome events.
+        generateMetronome(metronome_track, start_tick, system, current_bar,
+                          next_bar, location, options);
+
+        current_tick =
+            start_tick + DurationUtils::getBarTicks(system, bar.myBarStart,
+                                                    bar.myBarEnd,
+                                                    myTicksPerBeat);
+    }
+
+    return current_tick;
+}
+
+void MidiFile::generateStaffEvents(std::vector<MidiEventList> &tracks,
+                                   std::vector<size_t> &bar_offsets,
+                                   const Score &score,
+                                   const std::vector<PerformedBar> &bars,
+                                   int staff_index,
+                                   const LoadOptions &options) const
+{
+    const size_t num_players = tracks.size();
+    bar_offsets.reserve(bars.size() * num_players);
+
+    // The active bend is carried between bars, but is reset if we move to a
+    // system that doesn't contain this staff.
+    uint8_t active_bend = DEFAULT_BEND;
+    bool has_active_bend = false;
+    int system_index = -1;
+
+    for (const PerformedBar &bar : bars)
+    {
+        const System &system = score.getSystems()[bar.mySystemIndex];
+        const bool has_staff =
+            staff_index < static_cast<int>(system.getStaves().size());
+
+        if (bar.mySystemIndex != system_index)
+        {
+            system_index = bar.mySystemIndex;
+
+            if (!has_staff)
+                has_active_bend = false;
+            else if (!has_active_bend)
+            {
+                active_bend = DEFAULT_BEND;
+                has_active_bend = true;
+            }
+        }
+
+        if (has_staff)
+        {
+            const Staff &staff = system.getStaves()[staff_index];
+
+            for (unsigned int voice_index = 0;
+                 voice_index < staff.getVoices().size(); ++voice_index)
+            {
+                addEventsForBar(tracks, active_bend, bar.myStartTick,
+                                bar.myTempo, score, system, system_index, staff,
+                                staff_index, staff.getVoices()[voice_index],
+                                voice_index, bar.myBarStart, bar.myBarEnd,
+                                options);
+            }
+        }
+
+        // Record where the events for this bar end in each track.
+        for (const MidiEventList &track : tracks)
+            bar_offsets.push_back(track.size());
+    }
+}
@@ -19,12 +19,12 @@
 #define MIDI_MIDIFILE_H
 
 #include <midi/midieventlist.h>
+#include <midi/playbackorder.h>
 
 #include <cstdint>
 #include <vector>
 
 class Barline;
-class RepeatController;
 class Score;
 class Staff;
 class System;
@@ -34,6 +34,8 @@ class Voice;
 class MidiFile
 {
 public:
+    static constexpr int DEFAULT_PPQ = 480;
+
     struct LoadOptions
     {
         LoadOptions()
@@ -43,7 +45,8 @@ public:
               myStrongAccentVel(0),
               myWeakAccentVel(0),
               myMetronomePreset(0),
-              myRecordPositionChanges(false)
+              myRecordPositionChanges(false),
+              myCurveResolution(0)
         {
         }
 
@@ -54,6 +57,20 @@ public:
         uint8_t myWeakAccentVel;
         uint8_t myMetronomePreset;
         bool myRecordPositionChanges;
+        /// The maximum number of events per beat for gradual bends, slides
+        /// and volume swells, or 0 for an event at every step of the curve.
+        uint8_t myCurveResolution;
+    };
+
+    /// Information about a bar in the order that it is performed (i.e. after
+    /// following repeats and directions).
+    struct PerformedBar
+    {
+        int mySystemIndex;
+        int myBarStart;
+        int myBarEnd;
+        int myStartTick;
+        Midi::Tempo myTempo;
     };
 
     MidiFile();
@@ -64,7 +81,29 @@ public:
     std::vector<MidiEventList> &getTracks() { return myTracks; }
     const std::vector<MidiEventList> &getTracks() const { return myTracks; }
 
+    /// Returns the order in which the score's bars are performed.
+    const PlaybackOrder &getPlaybackOrder() const { return myPlaybackOrder; }
+
+    /// Returns the bars in the order that they are performed, along with the
+    /// (absolute) tick where each bar starts. These correspond to the bars in
+    /// the playback order.
+    const std::vector<PerformedBar> &getPerformedBars() const
+    {
+        return myPerformedBars;
+    }
+
 private:
+    int generateTimeline(const Score &score, const LoadOptions &options,
+                         MidiEventList &master_track,
+                         MidiEventList &metronome_track,
+                         std::vector<PerformedBar> &bars);
+
+    void generateStaffEvents(std::vector<MidiEventList> &tracks,
+                             std::vector<size_t> &bar_offsets,
+                             const Score &score,
+                             const std::vector<PerformedBar> &bars,
+                             int staff_index, const LoadOptions &options) const;
+
     int generateMetronome(MidiEventList &event_list, int current_tick,
                           const System &system, const Barline &current_bar,
                           const Barline &next_bar,
@@ -73,9 +112,7 @@ private:
 
     Midi::Tempo addTempoEvent(MidiEventList &event_list, int current_tick,
                               Midi::Tempo current_tempo, const Score &score,
-                              const SystemLocation &location,
-                              const RepeatController &repeat_controller,
-                              int bar_start, int bar_end);
+                              const PlaybackOrder &order, size_t bar_index);
 
     int addEventsForBar(std::vector<MidiEventList> &tracks,
                         uint8_t &active_bend, int current_tick,
@@ -83,10 +120,12 @@ private:
                         const System &system, int system_index,
                         const Staff &staff, int staff_index, const Voice &voice,
                         int voice_index, int bar_start, int bar_end,
-                        const LoadOptions &options);
+                        const LoadOptions &options) const;
 
     int myTicksPerBeat;
     std::vector<MidiEventList> myTracks;
+    PlaybackOrder myPlaybackOrder;
+    std::vector<PerformedBar> myPerformedBars;
 };
 
 #endif
@@ -0,0 +1,163 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "midiseekindex.h"
+
+#include <midi/midieventlist.h>
+
+#include <algorithm>
+
+constexpr std::array<uint8_t, 8> MidiSeekIndex::TRACKED_CONTROLLERS;
+
+MidiSeekIndex::ChannelState::ChannelState()
+    : myProgram(UNSET), myPitchWheelLsb(UNSET), myPitchWheelMsb(UNSET)
+{
+    myControllers.fill(UNSET);
+}
+
+/// Updates the channel state and tempo with the effects of the event.
+static void applyEvent(MidiSeekIndex::Snapshot &state, const MidiEvent &event)
+{
+    if (event.isTempoChange())
+    {
+        state.myTempo = event.getTempo();
+        return;
+    }
+
+    const std::vector<uint8_t> &data = event.getData();
+    if (data.empty() || data[0] >= MidiEvent::SysEx)
+        return;
+
+    MidiSeekIndex::ChannelState &channel =
+        state.myChannels[event.getChannel()];
+
+    switch (data[0] & 0xf0)
+    {
+        case MidiEvent::ProgramChange:
+            channel.myProgram = data[1];
+            break;
+
+        case MidiEvent::ControlChange:
+        {
+            auto &controllers = MidiSeekIndex::TRACKED_CONTROLLERS;
+            auto it =
+                std::find(controllers.begin(), controllers.end(), data[1]);
+            if (it != controllers.end())
+                channel.myControllers[it - controllers.begin()] = data[2];
+            break;
+        }
+
+        case MidiEvent::PitchWheel:
+            channel.myPitchWheelLsb = data[1];
+            channel.myPitchWheelMsb = data[2];
+            break;
+
+        default:
+            break;
+    }
+}
+
+std::vector<std::vector<uint8_t>>
+MidiSeekIndex::Snapshot::getRestoreMessages() const
+{
+    std::vector<std::vector<uint8_t>> messages;
+
+    for (int i = 0; i < NUM_CHANNELS; ++i)
+    {
+        const ChannelState &channel = myChannels[i];
+        const uint8_t channel_index = static_cast<uint8_t>(i);
+
+        if (channel.myProgram != UNSET)
+        {
+            messages.push_back({ static_cast<uint8_t>(MidiEvent::ProgramChange +
+                                                      channel_index),
+                                 channel.myProgram });
+        }
+
+        for (size_t j = 0; j < TRACKED_CONTROLLERS.size(); ++j)
+        {
+            if (channel.myControllers[j] != UNSET)
+            {
+                messages.push_back(
+                    { static_cast<uint8_t>(MidiEvent::ControlChange +
+                                           channel_index),
+                      TRACKED_CONTROLLERS[j], channel.myControllers[j] });
+            }
+        }
+
+        if (channel.myPitchWheelMsb != UNSET)
+        {
+            messages.push_back(
+                { static_cast<uint8_t>(MidiEvent::PitchWheel + channel_index),
+                  channel.myPitchWheelLsb, channel.myPitchWheelMsb });
+        }
+    }
+
+    return messages;
+}
+
+MidiSeekIndex::MidiSeekIndex(const MidiEventList &events,
+                             const std::vector<MidiFile::PerformedBar> &bars,
+                             const PlaybackOrder &order)
+    : myPlaybackOrder(order)
+{
+    Snapshot state;
+    state.myEventIndex = 0;
+    state.myTempo = Midi::BEAT_DURATION_120_BPM;
+
+    myBarSnapshots.reserve(bars.size());
+
+    auto event = events.begin();
+    for (size_t i = 0; i < bars.size(); ++i)
+    {
+        for (; event != events.end() && event->getTicks() < bars[i].myStartTick;
+             ++event)
+        {
+            applyEvent(state, *event);
+        }
+
+        // Only the first performance of a bar is needed for seeking.
+        if (order.isFirstPerformance(static_cast<int>(i)))
+        {
+            state.myEventIndex = static_cast<size_t>(event - events.begin());
+            myBarSnapshots.push_back(static_cast<int>(mySnapshots.size()));
+            mySnapshots.push_back(state);
+        }
+        else
+            myBarSnapshots.push_back(-1);
+    }
+}
+
+const MidiSeekIndex::Snapshot *
+MidiSeekIndex::findSnapshot(const SystemLocation &location) const
+{
+    const int bar = myPlaybackOrder.findFirstPerformance(location);
+    if (bar < 0 || bar >= static_cast<int>(myBarSnapshots.size()))
+        return nullptr;
+
+    return &mySnapshots[myBarSnapshots[bar]];
+}
+
+const MidiSeekIndex::Snapshot *
+MidiSeekIndex::getBarSnapshot(size_t bar_index) const
+{
+    if (bar_index >= myBarSnapshots.size() || myBarSnapshots[bar_index] < 0)
+        return nullptr;
+
+    return &mySnapshots[myBarSnapshots[bar_index]];
+}
@@ -0,0 +1,94 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MIDI_MIDISEEKINDEX_H
+#define MIDI_MIDISEEKINDEX_H
+
+#include <midi/midievent.h>
+#include <midi/midifile.h>
+#include <midi/playbackorder.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MidiEventList;
+
+/// Records the state of each MIDI channel (program, controllers, pitch wheel)
+/// and the tempo at the start of every performed bar. This allows playback to
+/// begin at any bar by sending a few messages to restore the channel state,
+/// rather than replaying every event before the start location.
+class MidiSeekIndex
+{
+public:
+    static constexpr int NUM_CHANNELS = 16;
+    /// The controllers whose values are tracked (RPN MSB / LSB, data entry
+    /// coarse / fine, volume, pan, modulation, and hold pedal), in the order
+    /// that they should be restored. The RPN selection must be restored before
+    /// the data entry values (the pitch bend range is the only RPN used).
+    static constexpr std::array<uint8_t, 8> TRACKED_CONTROLLERS = {
+        101, 100, 6, 38, 7, 10, 1, 64
+    };
+    /// Used for values that have not been set yet.
+    static constexpr uint8_t UNSET = 0xff;
+
+    struct ChannelState
+    {
+        ChannelState();
+
+        uint8_t myProgram;
+        std::array<uint8_t, TRACKED_CONTROLLERS.size()> myControllers;
+        uint8_t myPitchWheelLsb;
+        uint8_t myPitchWheelMsb;
+    };
+
+    struct Snapshot
+    {
+        /// Index of the first event at or after the start of the bar.
+        size_t myEventIndex;
+        Midi::Tempo myTempo;
+        std::array<ChannelState, NUM_CHANNELS> myChannels;
+
+        /// Returns the messages that are needed to restore the channel state.
+        std::vector<std::vector<uint8_t>> getRestoreMessages() const;
+    };
+
+    /// Builds the index from a list of events that are sorted by their
+    /// absolute tick. The playback order must outlive the index.
+    MidiSeekIndex(const MidiEventList &events,
+                  const std::vector<MidiFile::PerformedBar> &bars,
+                  const PlaybackOrder &order);
+
+    /// Returns the snapshot for the first time that the bar containing the
+    /// location is performed, or null if the bar is never performed.
+    const Snapshot *findSnapshot(const SystemLocation &location) const;
+
+    /// Returns the snapshot for the given performed bar, or null if the bar
+    /// was already performed earlier in the playback order.
+    const Snapshot *getBarSnapshot(size_t bar_index) const;
+
+private:
+    const PlaybackOrder &myPlaybackOrder;
+    std::vector<Snapshot> mySnapshots;
+    /// The index of the snapshot for each performed bar, or -1 for bars that
+    /// were already performed earlier.
+    std::vector<int> myBarSnapshots;
+};
+
+#endif
@@ -0,0 +1,166 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "playbackorder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <midi/repeatcontroller.h>
+#include <score/score.h>
+#include <score/utils.h>
+
+/// Checks for a repeat or direction when moving to the given location.
+static bool findPositionChange(RepeatController &repeat_controller,
+                               const SystemLocation &prev_location,
+                               SystemLocation &location)
+{
+    SystemLocation new_location;
+    if (repeat_controller.checkForRepeat(prev_location, location, new_location))
+    {
+        location = new_location;
+        return true;
+    }
+
+    return false;
+}
+
+/// Moves to the next bar and follows any directions / repeats / alternate
+/// endings.
+static SystemLocation moveToNextBar(const System &system,
+                                    SystemLocation location, int next_bar_pos,
+                                    RepeatController &repeat_controller,
+                                    bool &is_jump)
+{
+    SystemLocation prev_location = location;
+    location.setPosition(next_bar_pos);
+
+    is_jump = findPositionChange(repeat_controller, prev_location, location);
+    if (is_jump)
+        return location;
+
+    // If we're at the end of the system, shift to the next system and also
+    // check for a position change there.
+    if (next_bar_pos == system.getBarlines().back().getPosition())
+    {
+        location.setSystem(location.getSystem() + 1);
+        location.setPosition(0);
+
+        is_jump =
+            findPositionChange(repeat_controller, prev_location, location);
+    }
+
+    return location;
+}
+
+PlaybackOrder::PlaybackOrder(const Score &score)
+{
+    RepeatController repeat_controller(score);
+
+    SystemLocation location(0, 0);
+    bool is_jump = false;
+
+    const int num_systems = static_cast<int>(score.getSystems().size());
+    while (location.getSystem() < num_systems)
+    {
+        const System &system = score.getSystems()[location.getSystem()];
+
+        // If we're exactly on top of a barline, use that instead of grabbing
+        // the preceding barline.
+        const Barline *current_bar = ScoreUtils::findByPosition(
+            system.getBarlines(), location.getPosition());
+        if (!current_bar)
+            current_bar = system.getPreviousBarline(location.getPosition());
+
+        const Barline *next_bar =
+            system.getNextBarline(location.getPosition());
+        assert(next_bar);
+
+        myBars.push_back({ location, current_bar->getPosition(),
+                           next_bar->getPosition(), is_jump });
+
+        location = moveToNextBar(system, location, next_bar->getPosition(),
+                                 repeat_controller, is_jump);
+    }
+
+    buildIndex();
+}
+
+PlaybackOrder::PlaybackOrder(std::vector<Bar> bars) : myBars(std::move(bars))
+{
+    buildIndex();
+}
+
+void PlaybackOrder::buildIndex()
+{
+    for (int i = 0; i < static_cast<int>(myBars.size()); ++i)
+    {
+        const Bar &bar = myBars[i];
+        const int system_index = bar.myLocation.getSystem();
+        if (system_index >= static_cast<int>(mySystemBars.size()))
+            mySystemBars.resize(system_index + 1);
+
+        std::vector<BarEntry> &entries = mySystemBars[system_index];
+        if (std::none_of(entries.begin(), entries.end(),
+                         [&](const BarEntry &entry) {
+                             return entry.myBarStart == bar.myBarStart;
+                         }))
+        {
+            entries.push_back({ bar.myBarStart, bar.myBarEnd, i });
+        }
+    }
+
+    for (std::vector<BarEntry> &entries : mySystemBars)
+    {
+        std::sort(entries.begin(), entries.end(),
+                  [](const BarEntry &a, const BarEntry &b) {
+                      return a.myBarStart < b.myBarStart;
+                  });
+    }
+}
+
+int PlaybackOrder::findFirstPerformance(const SystemLocation &location) const
+{
+    if (location.getSystem() < 0 ||
+        location.getSystem() >= static_cast<int>(mySystemBars.size()))
+    {
+        return -1;
+    }
+
+    const std::vector<BarEntry> &entries = mySystemBars[location.getSystem()];
+    auto it = std::upper_bound(entries.begin(), entries.end(),
+                               location.getPosition(),
+                               [](int position, const BarEntry &entry) {
+                                   return position < entry.myBarStart;
+                               });
+    if (it == entries.begin())
+        return -1;
+
+    --it;
+    if (location.getPosition() >= it->myBarEnd)
+        return -1;
+
+    return it->myIndex;
+}
+
+bool PlaybackOrder::isFirstPerformance(int index) const
+{
+    const Bar &bar = myBars[index];
+    return findFirstPerformance(
+               SystemLocation(bar.myLocation.getSystem(), bar.myBarStart)) ==
+           index;
+}
@@ -0,0 +1,75 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MIDI_PLAYBACKORDER_H
+#define MIDI_PLAYBACKORDER_H
+
+#include <score/systemlocation.h>
+
+#include <vector>
+
+class Score;
+
+/// The sequence of bars in the order that they are performed, after following
+/// repeats, alternate endings, and musical directions (D.C., D.S., Coda, etc).
+/// This is compiled once for a score so that playback, MIDI export, seeking,
+/// etc can traverse the performed bars without simulating the repeat state.
+class PlaybackOrder
+{
+public:
+    struct Bar
+    {
+        /// The location where playback enters the bar.
+        SystemLocation myLocation;
+        int myBarStart;
+        int myBarEnd;
+        /// Whether the bar was reached by following a repeat or direction,
+        /// rather than moving to the next bar.
+        bool myIsJump;
+    };
+
+    PlaybackOrder() = default;
+    explicit PlaybackOrder(const Score &score);
+    explicit PlaybackOrder(std::vector<Bar> bars);
+
+    const std::vector<Bar> &getBars() const { return myBars; }
+
+    /// Returns the index of the first performance of the bar containing the
+    /// location, or -1 if that bar is never performed.
+    int findFirstPerformance(const SystemLocation &location) const;
+
+    /// Returns whether this is the first time that the bar is performed.
+    bool isFirstPerformance(int index) const;
+
+private:
+    void buildIndex();
+
+    struct BarEntry
+    {
+        int myBarStart;
+        int myBarEnd;
+        int myIndex;
+    };
+
+    std::vector<Bar> myBars;
+    /// For each system, the first performance of each bar that is played
+    /// (ordered by position).
+    std::vector<std::vector<BarEntry>> mySystemBars;
+};
+
+#endif
@@ -0,0 +1,202 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "scoretimeline.h"
+
+#include <algorithm>
+#include <boost/rational.hpp>
+#include <midi/durationutils.h>
+#include <score/score.h>
+#include <score/utils.h>
+
+ScoreTimeline::ScoreTimeline(const Score &score, int ticks_per_beat)
+    : myScore(score),
+      myTicksPerBeat(ticks_per_beat),
+      myTotalTicks(0),
+      myTotalTime(0)
+{
+    update();
+}
+
+void ScoreTimeline::update()
+{
+    const int num_systems = static_cast<int>(myScore.getSystems().size());
+    mySystemBars.assign(num_systems, {});
+    for (int i = 0; i < num_systems; ++i)
+        computeSystem(i);
+
+    computeBars();
+}
+
+void ScoreTimeline::updateSystem(int system_index)
+{
+    if (mySystemBars.size() != myScore.getSystems().size())
+    {
+        update();
+        return;
+    }
+
+    // Only the edited system needs to be scanned, but the playback order and
+    // the start of each bar may have changed for the remainder of the score.
+    computeSystem(system_index);
+    computeBars();
+}
+
+void ScoreTimeline::computeSystem(int system_index)
+{
+    const System &system = myScore.getSystems()[system_index];
+    std::vector<SystemBar> &bars = mySystemBars[system_index];
+    bars.clear();
+
+    const auto &barlines = system.getBarlines();
+    for (size_t i = 0; i + 1 < barlines.size(); ++i)
+    {
+        const int bar_start = barlines[i].getPosition();
+        const int bar_end = barlines[i + 1].getPosition();
+
+        SystemBar bar;
+        bar.myBarStart = bar_start;
+        bar.myDuration = DurationUtils::getBarTicks(system, bar_start, bar_end,
+                                                    myTicksPerBeat);
+
+        // If multiple tempo markers occur in a bar, the last one is used.
+        // Gradual tempo changes are ignored.
+        auto markers = ScoreUtils::findInRange(system.getTempoMarkers(),
+                                               bar_start, bar_end - 1);
+        if (!markers.empty() &&
+            markers.back().getMarkerType() != TempoMarker::AlterationOfPace)
+        {
+            bar.myTempo = computeTempo(markers.back());
+        }
+
+        bars.push_back(bar);
+    }
+}
+
+void ScoreTimeline::computeBars()
+{
+    myPlaybackOrder = PlaybackOrder(myScore);
+
+    const std::vector<PlaybackOrder::Bar> &order = myPlaybackOrder.getBars();
+    myBars.clear();
+    myBars.reserve(order.size());
+
+    int tick = 0;
+    Duration time(0);
+    Midi::Tempo tempo = Midi::BEAT_DURATION_120_BPM;
+
+    for (const PlaybackOrder::Bar &bar : order)
+    {
+        const int system_index = bar.myLocation.getSystem();
+        const std::vector<SystemBar> &system_bars = mySystemBars[system_index];
+        auto system_bar = std::lower_bound(
+            system_bars.begin(), system_bars.end(), bar.myBarStart,
+            [](const SystemBar &b, int position) {
+                return b.myBarStart < position;
+            });
+
+        const int duration =
+            (system_bar != system_bars.end()) ? system_bar->myDuration : 0;
+        if (system_bar != system_bars.end() && system_bar->myTempo)
+            tempo = *system_bar->myTempo;
+
+        myBars.push_back({ system_index, bar.myBarStart, bar.myBarEnd, tick,
+                           duration, tempo, time });
+
+        tick += duration;
+        time += Duration(static_cast<int64_t>(duration) * tempo.count() /
+                         myTicksPerBeat);
+    }
+
+    myTotalTicks = tick;
+    myTotalTime = time;
+}
+
+int ScoreTimeline::findBarAtTime(Duration time) const
+{
+    if (time >= myTotalTime)
+        return -1;
+
+    auto it = std::upper_bound(
+        myBars.begin(), myBars.end(), time,
+        [](Duration t, const Bar &bar) { return t < bar.myStartTime; });
+    return (it == myBars.begin()) ? 0
+                                  : static_cast<int>(it - myBars.begin()) - 1;
+}
+
+int ScoreTimeline::findBarAtTick(int tick) const
+{
+    if (tick >= myTotalTicks)
+        return -1;
+
+    auto it = std::upper_bound(
+        myBars.begin(), myBars.end(), tick,
+        [](int t, const Bar &bar) { return t < bar.myStartTick; });
+    return (it == myBars.begin()) ? 0
+                                  : static_cast<int>(it - myBars.begin()) - 1;
+}
+
+std::optional<ScoreTimeline::Duration>
+ScoreTimeline::getTime(const SystemLocation &location) const
+{
+    int index = myPlaybackOrder.findFirstPerformance(location);
+
+    // The last barline in a system isn't the start of a bar, so use the end
+    // of the bar before it.
+    if (index < 0 && location.getPosition() > 0)
+    {
+        index = myPlaybackOrder.findFirstPerformance(
+            SystemLocation(location.getSystem(), location.getPosition() - 1));
+    }
+    if (index < 0)
+        return {};
+
+    const Bar &bar = myBars[index];
+    const System &system = myScore.getSystems()[bar.mySystemIndex];
+
+    // Find how far into the bar the location is.
+    int offset = 0;
+    for (const Staff &staff : system.getStaves())
+    {
+        for (const Voice &voice : staff.getVoices())
+        {
+            offset = std::max(offset, DurationUtils::getVoiceTicks(
+                                          system, voice, bar.myBarStart,
+                                          bar.myBarEnd, location.getPosition(),
+                                          myTicksPerBeat));
+        }
+    }
+    offset = std::min(offset, bar.myDuration);
+
+    return bar.myStartTime +
+           Duration(static_cast<int64_t>(offset) * bar.myTempo.count() /
+                    myTicksPerBeat);
+}
+
+Midi::Tempo ScoreTimeline::computeTempo(const TempoMarker &marker)
+{
+    // Convert the values in the TempoMarker::BeatType enum to a factor that
+    // will scale the bpm value to be in terms of quarter notes.
+    boost::rational<int> scale(2, 1 << (marker.getBeatType() / 2));
+    if (marker.getBeatType() % 2 != 0)
+        scale *= boost::rational<int>(3, 2);
+
+    // Compute the number of microseconds per quarter note.
+    return Midi::Tempo(boost::rational_cast<int>(
+        60000000 / (scale * marker.getBeatsPerMinute())));
+}
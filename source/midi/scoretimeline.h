@@ -0,0 +1,111 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MIDI_SCORETIMELINE_H
+#define MIDI_SCORETIMELINE_H
+
+#include <midi/midievent.h>
+#include <midi/playbackorder.h>
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+class Score;
+class TempoMarker;
+
+/// Index of when each bar is performed, in ticks and in real time (at 100%
+/// playback speed). This is computed once for a score and can be updated
+/// cheaply after a single system is edited, so that the elapsed time for a
+/// location or the location for a time can be looked up without regenerating
+/// any MIDI events.
+class ScoreTimeline
+{
+public:
+    using Duration = std::chrono::microseconds;
+
+    struct Bar
+    {
+        int mySystemIndex;
+        int myBarStart;
+        int myBarEnd;
+        int myStartTick;
+        /// The number of ticks that the bar spans.
+        int myDuration;
+        /// The tempo in effect at the start of the bar. Gradual tempo changes
+        /// (accel. / rit.) are not included.
+        Midi::Tempo myTempo;
+        /// The time from the start of the score until the bar is played.
+        Duration myStartTime;
+    };
+
+    ScoreTimeline(const Score &score, int ticks_per_beat);
+
+    /// Recomputes the timeline for the entire score.
+    void update();
+
+    /// Recomputes the timeline after the given system was edited. The other
+    /// systems must not have changed since the timeline was last updated.
+    void updateSystem(int system_index);
+
+    int getTicksPerBeat() const { return myTicksPerBeat; }
+    const PlaybackOrder &getPlaybackOrder() const { return myPlaybackOrder; }
+
+    /// Returns the bars in the order that they are performed, which
+    /// correspond to the bars in the playback order.
+    const std::vector<Bar> &getBars() const { return myBars; }
+
+    int getTotalTicks() const { return myTotalTicks; }
+    Duration getTotalTime() const { return myTotalTime; }
+
+    /// Returns the index of the performed bar that is playing at the given
+    /// time or tick, or -1 if it is past the end of the score.
+    int findBarAtTime(Duration time) const;
+    int findBarAtTick(int tick) const;
+
+    /// Returns the time when the location is first played, or an empty value
+    /// if the location is never played.
+    std::optional<Duration> getTime(const SystemLocation &location) const;
+
+    /// Returns the duration of a quarter note for the tempo marker.
+    static Midi::Tempo computeTempo(const TempoMarker &marker);
+
+private:
+    /// The information for a bar that only depends on its own system.
+    struct SystemBar
+    {
+        int myBarStart;
+        int myDuration;
+        /// The tempo that is set in the bar, if any.
+        std::optional<Midi::Tempo> myTempo;
+    };
+
+    void computeSystem(int system_index);
+    void computeBars();
+
+    const Score &myScore;
+    const int myTicksPerBeat;
+    PlaybackOrder myPlaybackOrder;
+    /// Cached bar information for each system, ordered by position.
+    std::vector<std::vector<SystemBar>> mySystemBars;
+    std::vector<Bar> myBars;
+    int myTotalTicks;
+    Duration myTotalTime;
+};
+
+#endif
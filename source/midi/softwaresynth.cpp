@@ -0,0 +1,472 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "softwaresynth.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr double PI = 3.14159265358979323846;
+static constexpr int PERCUSSION_CHANNEL = 9;
+
+/// Number of frames that are rendered before the pitch of a voice is updated.
+static constexpr int CONTROL_BLOCK_SIZE = 64;
+/// Scale the output down to leave some headroom when many voices are active.
+static constexpr float MASTER_GAIN = 0.25f;
+static constexpr double VIBRATO_RATE = 5.5;
+/// Pitch variation (in semitones) when the modulation wheel is fully on.
+static constexpr double MAX_VIBRATO_DEPTH = 0.5;
+
+enum StatusByte : uint8_t
+{
+    NoteOff = 0x80,
+    NoteOn = 0x90,
+    ControlChange = 0xb0,
+    ProgramChange = 0xc0,
+    PitchWheel = 0xe0
+};
+
+enum Controller : uint8_t
+{
+    ModWheel = 0x01,
+    DataEntryCoarse = 0x06,
+    ChannelVolume = 0x07,
+    Pan = 0x0a,
+    HoldPedal = 0x40,
+    RpnLsb = 0x64,
+    RpnMsb = 0x65,
+    AllSoundOff = 0x78,
+    ResetControllers = 0x79,
+    AllNotesOff = 0x7b
+};
+
+namespace
+{
+/// Single-cycle band-limited waveforms, indexed by phase.
+class Wavetables
+{
+public:
+    static constexpr int SIZE = 2048;
+    static constexpr int NUM_HARMONICS = 32;
+
+    Wavetables()
+    {
+        for (int i = 0; i < SIZE; ++i)
+        {
+            const double phase = 2 * PI * i / SIZE;
+            mySine[i] = static_cast<float>(std::sin(phase));
+
+            double triangle = 0, saw = 0, square = 0;
+            for (int n = 1; n <= NUM_HARMONICS; ++n)
+            {
+                const double harmonic = std::sin(n * phase) / n;
+                saw += harmonic;
+
+                if (n % 2 == 1)
+                {
+                    square += harmonic;
+                    triangle += ((n / 2) % 2 == 0 ? 1 : -1) *
+                                std::sin(n * phase) / (n * n);
+                }
+            }
+
+            myTriangle[i] = static_cast<float>(triangle * 8 / (PI * PI));
+            mySawtooth[i] = static_cast<float>(saw * 2 / PI);
+            mySquare[i] = static_cast<float>(square * 4 / PI);
+        }
+    }
+
+    std::array<float, SIZE> mySine;
+    std::array<float, SIZE> myTriangle;
+    std::array<float, SIZE> mySawtooth;
+    std::array<float, SIZE> mySquare;
+};
+} // namespace
+
+static const Wavetables &getWavetables()
+{
+    static const Wavetables theTables;
+    return theTables;
+}
+
+SoftwareSynth::SoftwareSynth(int sample_rate)
+    : mySampleRate(sample_rate)
+{
+    // Generate the tables up front rather than during the first render.
+    getWavetables();
+}
+
+void SoftwareSynth::processMessage(const std::vector<uint8_t> &data)
+{
+    processMessage(data.data(), data.size());
+}
+
+void SoftwareSynth::processMessage(const uint8_t *data, size_t size)
+{
+    if (size == 0)
+        return;
+
+    const uint8_t status = data[0] & 0xf0;
+    const int channel = data[0] & 0x0f;
+
+    // System messages (e.g. meta events from a MIDI file) are ignored.
+    if (status == 0xf0)
+        return;
+
+    // Data bytes only have 7 bits. Masking them ensures that e.g. a program
+    // number from a malformed message can't be used past the end of the
+    // patch table.
+    const uint8_t data1 = size > 1 ? (data[1] & 0x7f) : 0;
+    const uint8_t data2 = size > 2 ? (data[2] & 0x7f) : 0;
+
+    switch (status)
+    {
+        case StatusByte::NoteOn:
+            if (data2 == 0)
+                noteOff(channel, data1);
+            else
+                noteOn(channel, data1, data2);
+            break;
+        case StatusByte::NoteOff:
+            noteOff(channel, data1);
+            break;
+        case StatusByte::ControlChange:
+            controlChange(channel, data1, data2);
+            break;
+        case StatusByte::ProgramChange:
+            myChannels[channel].myProgram = data1;
+            break;
+        case StatusByte::PitchWheel:
+            myChannels[channel].myPitchBend = (data2 << 7) | data1;
+            break;
+        default:
+            break;
+    }
+}
+
+void SoftwareSynth::noteOn(int channel, int pitch, int velocity)
+{
+    // Find a free voice. If there aren't any, steal the oldest voice
+    // (preferring voices that have already been released).
+    auto is_better_victim = [](const Voice &a, const Voice &b) {
+        const bool a_released = a.myStage == EnvelopeStage::Release;
+        const bool b_released = b.myStage == EnvelopeStage::Release;
+        if (a_released != b_released)
+            return a_released;
+
+        return a.myStartOrder < b.myStartOrder;
+    };
+
+    Voice *voice = &myVoices.front();
+    for (Voice &v : myVoices)
+    {
+        if (v.myStage == EnvelopeStage::Off)
+        {
+            voice = &v;
+            break;
+        }
+
+        if (is_better_victim(v, *voice))
+            voice = &v;
+    }
+
+    voice->myChannel = channel;
+    voice->myPitch = pitch;
+    voice->myVelocity = velocity / 127.0f;
+    voice->myPatch = &getPatch(channel);
+    voice->myPhase = 0;
+    voice->myEnvelope = 0;
+    voice->myStage = EnvelopeStage::Attack;
+    voice->mySustained = false;
+    voice->myNoiseState = 0x12345u + static_cast<uint32_t>(pitch);
+    voice->myStartOrder = myNextStartOrder++;
+}
+
+void SoftwareSynth::noteOff(int channel, int pitch)
+{
+    for (Voice &voice : myVoices)
+    {
+        if (voice.myStage == EnvelopeStage::Off ||
+            voice.myStage == EnvelopeStage::Release ||
+            voice.myChannel != channel || voice.myPitch != pitch)
+        {
+            continue;
+        }
+
+        if (myChannels[channel].myHoldPedal)
+            voice.mySustained = true;
+        else
+            releaseVoice(voice);
+    }
+}
+
+void SoftwareSynth::releaseVoice(Voice &voice)
+{
+    voice.mySustained = false;
+    voice.myStage = EnvelopeStage::Release;
+}
+
+void SoftwareSynth::controlChange(int channel, uint8_t controller,
+                                  uint8_t value)
+{
+    Channel &state = myChannels[channel];
+
+    switch (controller)
+    {
+        case Controller::ModWheel:
+            state.myModulation = value;
+            break;
+        case Controller::ChannelVolume:
+            state.myVolume = value;
+            break;
+        case Controller::Pan:
+            state.myPan = value;
+            break;
+        case Controller::HoldPedal:
+            state.myHoldPedal = value >= 64;
+            if (!state.myHoldPedal)
+            {
+                for (Voice &voice : myVoices)
+                {
+                    if (voice.myChannel == channel && voice.mySustained &&
+                        voice.myStage != EnvelopeStage::Off)
+                    {
+                        releaseVoice(voice);
+                    }
+                }
+            }
+            break;
+        case Controller::RpnMsb:
+            state.myRpnMsb = value;
+            break;
+        case Controller::RpnLsb:
+            state.myRpnLsb = value;
+            break;
+        case Controller::DataEntryCoarse:
+            // RPN 0 is the pitch bend range.
+            if (state.myRpnMsb == 0 && state.myRpnLsb == 0)
+                state.myPitchBendRange = value;
+            break;
+        case Controller::AllSoundOff:
+            for (Voice &voice : myVoices)
+            {
+                if (voice.myChannel == channel)
+                    voice.myStage = EnvelopeStage::Off;
+            }
+            break;
+        case Controller::ResetControllers:
+            state.myModulation = 0;
+            state.myPitchBend = 8192;
+            state.myHoldPedal = false;
+            break;
+        case Controller::AllNotesOff:
+            for (Voice &voice : myVoices)
+            {
+                if (voice.myChannel == channel &&
+                    voice.myStage != EnvelopeStage::Off)
+                {
+                    releaseVoice(voice);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+const SoftwareSynth::Patch &SoftwareSynth::getPatch(int channel) const
+{
+    static const Patch thePercussionPatch = { Waveform::Noise, 0.001f, 0.15f,
+                                              0.0f, 0.05f };
+
+    // One patch for each family of General MIDI presets.
+    static const std::array<Patch, 16> thePatches = { {
+        { Waveform::Triangle, 0.002f, 1.5f, 0.0f, 0.3f },  // Piano
+        { Waveform::Sine, 0.001f, 0.8f, 0.0f, 0.3f },      // Chromatic Perc.
+        { Waveform::Square, 0.01f, 0.1f, 0.8f, 0.1f },     // Organ
+        { Waveform::Sawtooth, 0.002f, 2.0f, 0.0f, 0.15f }, // Guitar
+        { Waveform::Triangle, 0.005f, 1.5f, 0.2f, 0.1f },  // Bass
+        { Waveform::Sawtooth, 0.08f, 0.3f, 0.8f, 0.3f },   // Strings
+        { Waveform::Sawtooth, 0.1f, 0.3f, 0.8f, 0.4f },    // Ensemble
+        { Waveform::Sawtooth, 0.03f, 0.2f, 0.7f, 0.15f },  // Brass
+        { Waveform::Square, 0.02f, 0.2f, 0.7f, 0.1f },     // Reed
+        { Waveform::Sine, 0.03f, 0.1f, 0.8f, 0.15f },      // Pipe
+        { Waveform::Square, 0.005f, 0.2f, 0.7f, 0.1f },    // Synth Lead
+        { Waveform::Triangle, 0.2f, 0.5f, 0.7f, 0.5f },    // Synth Pad
+        { Waveform::Sine, 0.05f, 0.5f, 0.5f, 0.5f },       // Synth Effects
+        { Waveform::Sawtooth, 0.002f, 1.0f, 0.0f, 0.2f },  // Ethnic
+        { Waveform::Sine, 0.001f, 0.3f, 0.0f, 0.1f },      // Percussive
+        { Waveform::Noise, 0.01f, 0.3f, 0.3f, 0.2f },      // Sound Effects
+    } };
+
+    if (channel == PERCUSSION_CHANNEL)
+        return thePercussionPatch;
+
+    return thePatches[myChannels[channel].myProgram / 8];
+}
+
+void SoftwareSynth::render(float *output, int num_frames)
+{
+    std::fill(output, output + 2 * num_frames, 0.0f);
+
+    for (int offset = 0; offset < num_frames; offset += CONTROL_BLOCK_SIZE)
+    {
+        const int block_size = std::min(CONTROL_BLOCK_SIZE, num_frames - offset);
+
+        for (Voice &voice : myVoices)
+        {
+            if (voice.myStage != EnvelopeStage::Off)
+                renderVoice(voice, output + 2 * offset, block_size);
+        }
+
+        for (Channel &channel : myChannels)
+        {
+            channel.myVibratoPhase += VIBRATO_RATE * block_size / mySampleRate;
+            channel.myVibratoPhase -= std::floor(channel.myVibratoPhase);
+        }
+    }
+}
+
+void SoftwareSynth::renderVoice(Voice &voice, float *output, int num_frames)
+{
+    const Channel &channel = myChannels[voice.myChannel];
+    const Wavetables &tables = getWavetables();
+
+    // The pitch is only updated once per block.
+    double pitch = voice.myPitch;
+    pitch += (channel.myPitchBend - 8192) / 8192.0 * channel.myPitchBendRange;
+    pitch += std::sin(2 * PI * channel.myVibratoPhase) * MAX_VIBRATO_DEPTH *
+             channel.myModulation / 127.0;
+
+    const double frequency = 440.0 * std::pow(2.0, (pitch - 69) / 12.0);
+    const double phase_increment = frequency / mySampleRate;
+
+    const float volume = channel.myVolume / 127.0f;
+    const float gain =
+        MASTER_GAIN * voice.myVelocity * voice.myVelocity * volume * volume;
+    const float pan = channel.myPan / 127.0f;
+    const float left_gain = gain * static_cast<float>(std::cos(pan * PI / 2));
+    const float right_gain = gain * static_cast<float>(std::sin(pan * PI / 2));
+
+    const float *table = nullptr;
+    switch (voice.myPatch->myWaveform)
+    {
+        case Waveform::Sine:
+            table = tables.mySine.data();
+            break;
+        case Waveform::Triangle:
+            table = tables.myTriangle.data();
+            break;
+        case Waveform::Sawtooth:
+            table = tables.mySawtooth.data();
+            break;
+        case Waveform::Square:
+            table = tables.mySquare.data();
+            break;
+        case Waveform::Noise:
+            break;
+    }
+
+    for (int i = 0; i < num_frames; ++i)
+    {
+        float sample;
+        if (table)
+        {
+            const double index = voice.myPhase * Wavetables::SIZE;
+            const int i0 = static_cast<int>(index);
+            const int i1 = (i0 + 1) % Wavetables::SIZE;
+            const float frac = static_cast<float>(index - i0);
+            sample = table[i0] + (table[i1] - table[i0]) * frac;
+
+            voice.myPhase += phase_increment;
+            voice.myPhase -= std::floor(voice.myPhase);
+        }
+        else
+        {
+            // Xorshift noise generator.
+            uint32_t &x = voice.myNoiseState;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            sample = static_cast<float>(x) / 2147483648.0f - 1.0f;
+        }
+
+        sample *= advanceEnvelope(voice);
+        output[2 * i] += sample * left_gain;
+        output[2 * i + 1] += sample * right_gain;
+
+        if (voice.myStage == EnvelopeStage::Off)
+            break;
+    }
+}
+
+float SoftwareSynth::advanceEnvelope(Voice &voice)
+{
+    const Patch &patch = *voice.myPatch;
+    const float dt = 1.0f / mySampleRate;
+
+    switch (voice.myStage)
+    {
+        case EnvelopeStage::Attack:
+            voice.myEnvelope += dt / patch.myAttack;
+            if (voice.myEnvelope >= 1.0f)
+            {
+                voice.myEnvelope = 1.0f;
+                voice.myStage = EnvelopeStage::Decay;
+            }
+            break;
+        case EnvelopeStage::Decay:
+            voice.myEnvelope -= dt / patch.myDecay;
+            if (voice.myEnvelope <= patch.mySustain)
+            {
+                voice.myEnvelope = patch.mySustain;
+                voice.myStage = (patch.mySustain > 0) ? EnvelopeStage::Sustain
+                                                       : EnvelopeStage::Off;
+            }
+            break;
+        case EnvelopeStage::Sustain:
+            break;
+        case EnvelopeStage::Release:
+            voice.myEnvelope -= dt / patch.myRelease;
+            if (voice.myEnvelope <= 0.0f)
+            {
+                voice.myEnvelope = 0.0f;
+                voice.myStage = EnvelopeStage::Off;
+            }
+            break;
+        case EnvelopeStage::Off:
+            break;
+    }
+
+    return voice.myEnvelope;
+}
+
+void SoftwareSynth::reset()
+{
+    for (Voice &voice : myVoices)
+        voice.myStage = EnvelopeStage::Off;
+
+    myChannels.fill(Channel());
+}
+
+int SoftwareSynth::getActiveVoiceCount() const
+{
+    return static_cast<int>(
+        std::count_if(myVoices.begin(), myVoices.end(), [](const Voice &voice) {
+            return voice.myStage != EnvelopeStage::Off;
+        }));
+}
@@ -0,0 +1,128 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MIDI_SOFTWARESYNTH_H
+#define MIDI_SOFTWARESYNTH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// A simple, portable synthesizer which renders MIDI messages to audio using
+/// wavetable oscillators, without requiring any sample banks or MIDI hardware.
+/// Messages are passed to processMessage() and the audio is pulled with
+/// render(), e.g. for offline rendering to a WAV file.
+class SoftwareSynth
+{
+public:
+    static constexpr int NUM_CHANNELS = 16;
+    static constexpr int MAX_VOICES = 64;
+    static constexpr int DEFAULT_SAMPLE_RATE = 44100;
+
+    explicit SoftwareSynth(int sample_rate = DEFAULT_SAMPLE_RATE);
+
+    int getSampleRate() const { return mySampleRate; }
+
+    /// Applies a MIDI message immediately.
+    void processMessage(const std::vector<uint8_t> &data);
+
+    /// Renders the given number of frames of interleaved stereo audio, with
+    /// samples in the range [-1, 1].
+    void render(float *output, int num_frames);
+
+    /// Stops all notes and resets the channel state.
+    void reset();
+
+    /// Returns the number of voices that are currently sounding.
+    int getActiveVoiceCount() const;
+
+private:
+    enum class Waveform : uint8_t
+    {
+        Sine,
+        Triangle,
+        Sawtooth,
+        Square,
+        Noise
+    };
+
+    /// Basic sound parameters for a family of General MIDI presets.
+    struct Patch
+    {
+        Waveform myWaveform;
+        float myAttack;
+        float myDecay;
+        float mySustain;
+        float myRelease;
+    };
+
+    enum class EnvelopeStage : uint8_t
+    {
+        Attack,
+        Decay,
+        Sustain,
+        Release,
+        Off
+    };
+
+    struct Voice
+    {
+        int myChannel = 0;
+        int myPitch = 0;
+        float myVelocity = 0;
+        const Patch *myPatch = nullptr;
+        double myPhase = 0;
+        float myEnvelope = 0;
+        EnvelopeStage myStage = EnvelopeStage::Off;
+        /// Set if the note was released while the hold pedal was down.
+        bool mySustained = false;
+        uint32_t myNoiseState = 1;
+        uint64_t myStartOrder = 0;
+    };
+
+    struct Channel
+    {
+        uint8_t myProgram = 0;
+        uint8_t myVolume = 100;
+        uint8_t myPan = 64;
+        uint8_t myModulation = 0;
+        bool myHoldPedal = false;
+        int myPitchBend = 8192;
+        int myPitchBendRange = 2;
+        uint8_t myRpnMsb = 127;
+        uint8_t myRpnLsb = 127;
+        double myVibratoPhase = 0;
+    };
+
+    void processMessage(const uint8_t *data, size_t size);
+    void noteOn(int channel, int pitch, int velocity);
+    void noteOff(int channel, int pitch);
+    void controlChange(int channel, uint8_t controller, uint8_t value);
+    void releaseVoice(Voice &voice);
+
+    const Patch &getPatch(int channel) const;
+    void renderVoice(Voice &voice, float *output, int num_frames);
+    float advanceEnvelope(Voice &voice);
+
+    const int mySampleRate;
+    std::array<Channel, NUM_CHANNELS> myChannels;
+    std::array<Voice, MAX_VOICES> myVoices;
+    uint64_t myNextStartOrder = 0;
+};
+
+#endif
@@ -18,6 +18,7 @@
 #include "score.h"
 
 #include <stdexcept>
+#include <utility>
 
 const int Score::MIN_LINE_SPACING = 6;
 const int Score::MAX_LINE_SPACING = 14;
@@ -64,6 +65,14 @@ void Score::insertSystem(const System &system, int index)
         mySystems.insert(mySystems.begin() + index, system);
 }
 
+void Score::insertSystem(System &&system, int index)
+{
+    if (index < 0)
+        mySystems.push_back(std::move(system));
+    else
+        mySystems.insert(mySystems.begin() + index, std::move(system));
+}
+
 void Score::removeSystem(int index)
 {
     mySystems.erase(mySystems.begin() + index);
@@ -61,6 +61,8 @@ public:
 
     /// Adds a new system to the score, optionally at a specific index.
     void insertSystem(const System &system, int index = -1);
+    /// Adds a new system to the score without copying it.
+    void insertSystem(System &&system, int index = -1);
     /// Removes the specified system from the score.
     void removeSystem(int index);
 
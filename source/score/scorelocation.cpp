@@ -93,7 +93,7 @@ const Position *ScoreLocation::findMultiBarRest() const
     {
         for (const Voice &voice : staff.getVoices())
         {
-            for (const Position &pos : ScoreUtils::findInRange(
+            for (const Position &pos : ScoreUtils::findInSortedRange(
                      voice.getPositions(), bar->getPosition(),
                      nextBar->getPosition()))
             {
@@ -116,9 +116,10 @@ bool ScoreLocation::isEmptyBar() const
     {
         for (const Voice &voice : staff.getVoices())
         {
-            if (!ScoreUtils::findInRange(voice.getPositions(),
-                                         bar->getPosition(),
-                                         nextBar->getPosition()).empty())
+            if (!ScoreUtils::findInSortedRange(voice.getPositions(),
+                                               bar->getPosition(),
+                                               nextBar->getPosition())
+                     .empty())
             {
                 return false;
             }
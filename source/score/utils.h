@@ -78,6 +78,27 @@ namespace ScoreUtils {
             range, InPositionRange(left, right));
     }
 
+    /// Returns the objects in the range [left, right]. Unlike findInRange(),
+    /// this uses a binary search, so the objects must be ordered by position
+    /// (as they are in a system or voice).
+    template <typename T>
+    boost::iterator_range<T>
+    findInSortedRange(const boost::iterator_range<T> &range, int left,
+                      int right)
+    {
+        const T begin = std::lower_bound(
+            range.begin(), range.end(), left,
+            [](const auto &obj, int position) {
+                return obj.getPosition() < position;
+            });
+        const T end = std::upper_bound(
+            begin, range.end(), right, [](int position, const auto &obj) {
+                return position < obj.getPosition();
+            });
+
+        return boost::iterator_range<T>(begin, end);
+    }
+
     // Some helper methods to reduce code duplication.
 
     /// Sorts objects by their positions in the system.
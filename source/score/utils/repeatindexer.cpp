@@ -17,9 +17,11 @@
 
 #include "repeatindexer.h"
 
+#include <algorithm>
 #include <optional>
 #include <score/score.h>
 #include <score/utils.h>
+#include <set>
 #include <stack>
 
 RepeatedSection::RepeatedSection(const SystemLocation &startBar)
@@ -133,6 +135,7 @@ RepeatIndexer::RepeatIndexer(const Score &score)
     // There may be nested repeats, so maintain a stack of the active repeats
     // as we go through the score.
     std::stack<RepeatedSection> repeats;
+    std::set<RepeatedSection> completed_repeats;
 
     // The start of the score can always act as a repeat start bar.
     repeats.push(SystemLocation(0, 0));
@@ -174,7 +177,7 @@ RepeatIndexer::RepeatIndexer(const Score &score)
                     activeRepeat.getAlternateEndingCount() >=
                         activeRepeat.getTotalRepeatCount())
                 {
-                    myRepeats.insert(activeRepeat);
+                    completed_repeats.insert(activeRepeat);
                     repeats.pop();
                 }
             }
@@ -198,7 +201,7 @@ RepeatIndexer::RepeatIndexer(const Score &score)
                 // done with this repeat.
                 if (activeRepeat.getAlternateEndingCount() == 0)
                 {
-                    myRepeats.insert(activeRepeat);
+                    completed_repeats.insert(activeRepeat);
                     repeats.pop();
                 }
             }
@@ -209,19 +212,47 @@ RepeatIndexer::RepeatIndexer(const Score &score)
 
     // TODO - report mismatched repeat start bars.
     // TODO - report missing / extra alternate endings.
+
+    myRepeats.assign(completed_repeats.begin(), completed_repeats.end());
+
+    // Find the previous longer section for each section, using a stack of the
+    // sections whose end bars haven't been passed yet.
+    std::vector<int> open_repeats;
+    myPrevLongerRepeats.reserve(myRepeats.size());
+    for (int i = 0; i < static_cast<int>(myRepeats.size()); ++i)
+    {
+        const SystemLocation &end = myRepeats[i].getLastEndBarLocation();
+        while (!open_repeats.empty() &&
+               myRepeats[open_repeats.back()].getLastEndBarLocation() <= end)
+        {
+            open_repeats.pop_back();
+        }
+
+        myPrevLongerRepeats.push_back(open_repeats.empty() ? -1
+                                                           : open_repeats.back());
+        open_repeats.push_back(i);
+    }
 }
 
 const RepeatedSection *RepeatIndexer::findRepeat(
     const SystemLocation &loc) const
 {
-    auto repeat = myRepeats.upper_bound(loc);
+    auto repeat = std::upper_bound(
+        myRepeats.begin(), myRepeats.end(), loc,
+        [](const SystemLocation &loc, const RepeatedSection &section) {
+            return loc < section.getStartBarLocation();
+        });
 
     // Search for a pair of start and end bars that surrounds this location.
-    while (repeat != myRepeats.begin())
+    // If a section ends before the location, so do any sections between it
+    // and the previous longer section.
+    int i = static_cast<int>(repeat - myRepeats.begin()) - 1;
+    while (i >= 0)
     {
-        --repeat;
-        if (repeat->getLastEndBarLocation() >= loc)
-            return &(*repeat);
+        if (myRepeats[i].getLastEndBarLocation() >= loc)
+            return &myRepeats[i];
+
+        i = myPrevLongerRepeats[i];
     }
 
     return nullptr;
@@ -22,8 +22,8 @@
 #include <map>
 #include <optional>
 #include <score/systemlocation.h>
-#include <set>
 #include <unordered_map>
+#include <vector>
 
 class AlternateEnding;
 class Score;
@@ -78,7 +78,7 @@ private:
 class RepeatIndexer
 {
 public:
-    typedef std::set<RepeatedSection>::const_iterator RepeatedSectionIterator;
+    typedef std::vector<RepeatedSection>::const_iterator RepeatedSectionIterator;
 
     RepeatIndexer(const Score &score);
 
@@ -91,7 +91,12 @@ public:
     boost::iterator_range<RepeatedSectionIterator> getRepeats() const;
 
 private:
-    std::set<RepeatedSection> myRepeats;
+    /// The repeated sections, ordered by their start bar.
+    std::vector<RepeatedSection> myRepeats;
+    /// For each repeated section, the index of the closest earlier section
+    /// that ends after it does (or -1), so that findRepeat() can skip over
+    /// sections that have already ended.
+    std::vector<int> myPrevLongerRepeats;
 };
 
 #endif
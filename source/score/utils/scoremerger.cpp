@@ -17,6 +17,7 @@
 
 #include "scoremerger.h"
 
+#include <algorithm>
 #include <list>
 #include <unordered_set>
 
@@ -97,6 +98,42 @@ private:
 
 typedef std::list<ExpandedBar> ExpandedBarList;
 
+/// Tracks the active players at the start of each system, so that the
+/// current players at a location can be found without searching from the
+/// start of the score.
+class PlayerChangeIndex
+{
+public:
+    explicit PlayerChangeIndex(const Score &score) : myScore(score)
+    {
+        const PlayerChange *current = nullptr;
+        for (const System &system : score.getSystems())
+        {
+            mySystemPlayers.push_back(current);
+            if (!system.getPlayerChanges().empty())
+                current = &system.getPlayerChanges().back();
+        }
+    }
+
+    /// Equivalent to ScoreUtils::getCurrentPlayers().
+    const PlayerChange *getCurrentPlayers(int system_index, int position) const
+    {
+        const PlayerChange *current = mySystemPlayers[system_index];
+        for (const PlayerChange &change :
+             myScore.getSystems()[system_index].getPlayerChanges())
+        {
+            if (change.getPosition() <= position)
+                current = &change;
+        }
+
+        return current;
+    }
+
+private:
+    const Score &myScore;
+    std::vector<const PlayerChange *> mySystemPlayers;
+};
+
 static void expandScore(Score &score, ExpandedBarList &expanded_bars)
 {
     Caret caret(score, theDefaultViewOptions);
@@ -245,8 +282,8 @@ static int copyNotes(ScoreLocation &dest, const ScoreLocation &src)
     int offset, left, right;
     getPositionRange(dest, src, offset, left, right);
 
-    auto positions =
-        ScoreUtils::findInRange(src.getVoice().getPositions(), left, right);
+    auto positions = ScoreUtils::findInSortedRange(
+        src.getVoice().getPositions(), left, right);
 
     if (!positions.empty())
     {
@@ -444,7 +481,9 @@ static const PlayerChange *findPlayerChange(
 
 static void mergePlayerChanges(ScoreLocation &dest_loc,
                                const ScoreLocation &guitar_loc,
+                               const PlayerChangeIndex &guitar_players,
                                const ScoreLocation &bass_loc,
+                               const PlayerChangeIndex &bass_players,
                                ExpandedBarList::const_iterator guitar_bar,
                                ExpandedBarList::const_iterator end_guitar_bar,
                                ExpandedBarList::const_iterator bass_bar,
@@ -471,18 +510,16 @@ static void mergePlayerChanges(ScoreLocation &dest_loc,
         {
             // If there is only a player change in the bass score, carry over
             // the current active players from the guitar score.
-            guitar_change = ScoreUtils::getCurrentPlayers(
-                guitar_loc.getScore(), guitar_loc.getSystemIndex(),
-                guitar_loc.getPositionIndex());
+            guitar_change = guitar_players.getCurrentPlayers(
+                guitar_loc.getSystemIndex(), guitar_loc.getPositionIndex());
         }
 
         if (!bass_change && bass_bar != end_bass_bar)
         {
             // If there is only a player change in the guitar score, carry over
             // the current active players from the bass score.
-            bass_change = ScoreUtils::getCurrentPlayers(
-                bass_loc.getScore(), bass_loc.getSystemIndex(),
-                bass_loc.getPositionIndex());
+            bass_change = bass_players.getCurrentPlayers(
+                bass_loc.getSystemIndex(), bass_loc.getPositionIndex());
         }
 
         // Merge in data from only the active staves.
@@ -621,6 +658,9 @@ static void combineScores(Score &dest_score, Score &guitar_score,
     Caret bass_caret(bass_score, theDefaultViewOptions);
     const ScoreLocation &bass_loc = bass_caret.getLocation();
 
+    const PlayerChangeIndex guitar_players(guitar_score);
+    const PlayerChangeIndex bass_players(bass_score);
+
     auto guitar_bar = guitar_bars.begin();
     const auto end_guitar_bar = guitar_bars.end();
     auto bass_bar = bass_bars.begin();
@@ -690,9 +730,10 @@ static void combineScores(Score &dest_score, Score &guitar_score,
                                                  bass_caret, *bass_bar, true));
         }
 
-        mergePlayerChanges(dest_loc, guitar_loc, bass_loc, guitar_bar,
-                           end_guitar_bar, bass_bar, end_bass_bar,
-                           num_guitar_staves, prev_num_guitar_staves);
+        mergePlayerChanges(dest_loc, guitar_loc, guitar_players, bass_loc,
+                           bass_players, guitar_bar, end_guitar_bar, bass_bar,
+                           end_bass_bar, num_guitar_staves,
+                           prev_num_guitar_staves);
 
         // Advance to the next bar in the source scores.
         if (guitar_bar != end_guitar_bar)
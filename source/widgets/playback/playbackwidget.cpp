@@ -79,6 +79,7 @@ PlaybackWidget::PlaybackWidget(const QAction &play_pause_command,
                                const QAction &rewind_command,
                                const QAction &stop_command,
                                const QAction &metronome_command,
+                               const QAction &loop_command,
                                QWidget *parent)
     : QWidget(parent),
       ui(new Ui::PlaybackWidget),
@@ -127,6 +128,14 @@ PlaybackWidget::PlaybackWidget(const QAction &play_pause_command,
                 .arg(getShortcutHint(metronome_command)));
     });
 
+    ui->loopToggleButton->setIcon(
+        style()->standardIcon(QStyle::SP_BrowserReload));
+    connect(&loop_command, &QAction::changed, [&]() {
+        ui->loopToggleButton->setToolTip(
+            tr("Click to toggle whether playback repeats the selected bars%1.")
+                .arg(getShortcutHint(loop_command)));
+    });
+
     ui->zoomComboBox->setValidator(new PercentageValidator(ui->zoomComboBox));
 
     connect(myVoices, qOverload<int>(&QButtonGroup::buttonClicked), this,
@@ -137,6 +146,7 @@ PlaybackWidget::PlaybackWidget(const QAction &play_pause_command,
             this, &PlaybackWidget::activeFilterChanged);
     connectButtonToAction(ui->playPauseButton, &play_pause_command);
     connectButtonToAction(ui->metronomeToggleButton, &metronome_command);
+    connectButtonToAction(ui->loopToggleButton, &loop_command);
     connectButtonToAction(ui->rewindToStartButton, &rewind_command);
     connectButtonToAction(ui->stopButton, &stop_command);
 
@@ -215,3 +225,32 @@ void PlaybackWidget::updateLocationLabel(const std::string &location)
 {
     ui->locationLabel->setText(QString::fromStdString(location));
 }
+
+/// Formats the time as minutes and seconds.
+static QString formatTime(std::chrono::milliseconds time)
+{
+    const auto seconds =
+        std::chrono::duration_cast<std::chrono::seconds>(time).count();
+    return QStringLiteral("%1:%2")
+        .arg(seconds / 60)
+        .arg(seconds % 60, 2, 10, QLatin1Char('0'));
+}
+
+void PlaybackWidget::updateTimeLabel(std::chrono::milliseconds elapsed,
+                                     std::chrono::milliseconds total)
+{
+    ui->timeLabel->setText(QStringLiteral("%1 / %2")
+                               .arg(formatTime(elapsed))
+                               .arg(formatTime(total)));
+}
+
+void PlaybackWidget::setDiagnosticsVisible(bool visible)
+{
+    ui->diagnosticsLine->setVisible(visible);
+    ui->diagnosticsLabel->setVisible(visible);
+}
+
+void PlaybackWidget::updateDiagnostics(const QString &text)
+{
+    ui->diagnosticsLabel->setText(text);
+}
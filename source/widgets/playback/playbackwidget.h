@@ -18,6 +18,7 @@
 #ifndef WIDGETS_PLAYBACKWIDGET_H
 #define WIDGETS_PLAYBACKWIDGET_H
 
+#include <chrono>
 #include <QWidget>
 
 namespace Ui {
@@ -35,7 +36,8 @@ public:
     explicit PlaybackWidget(const QAction &play_pause_command,
                             const QAction &rewind_command,
                             const QAction &stop_command,
-                            const QAction &metronome_command, QWidget *parent);
+                            const QAction &metronome_command,
+                            const QAction &loop_command, QWidget *parent);
     ~PlaybackWidget();
 
     /// Reload any settings for the given score.
@@ -50,6 +52,16 @@ public:
     /// Updates the text containing the caret's location.
     void updateLocationLabel(const std::string &location);
 
+    /// Updates the text containing the elapsed and total playback time.
+    void updateTimeLabel(std::chrono::milliseconds elapsed,
+                         std::chrono::milliseconds total);
+
+    /// Shows or hides the playback diagnostics.
+    void setDiagnosticsVisible(bool visible);
+
+    /// Updates the text containing the playback diagnostics.
+    void updateDiagnostics(const QString &text);
+
 signals:
     void playbackSpeedChanged(int speed);
     void activeVoiceChanged(int voice);
@@ -18,6 +18,7 @@
 #include <doctest/doctest.h>
 
 #include <audio/midioutputdevice.h>
+#include <audio/virtualmidioutputbackend.h>
 #include <RtMidi.h>
 
 TEST_CASE("Audio/MidiOutputDevice/Basic")
@@ -36,3 +37,83 @@ TEST_CASE("Audio/MidiOutputDevice/Basic")
     for (RtMidi::Api api : apis)
         REQUIRE(api != RtMidi::RTMIDI_DUMMY);
 }
+
+TEST_CASE("Audio/MidiOutputDevice/VirtualBackend")
+{
+    auto backend = std::make_shared<VirtualMidiOutputBackend>();
+    MidiOutputDevice device(backend);
+
+    REQUIRE(device.getApiCount() == 1);
+    REQUIRE(device.getPortCount(0) == 1);
+    REQUIRE(device.initialize(0, 0));
+
+    device.setChannelMaxVolume(2, 64);
+    device.setVolume(2, 127);
+    device.playNote(2, 60, 100);
+    device.stopNote(2, 60);
+
+    auto messages = backend->getMessages();
+    REQUIRE(messages.size() == 4);
+
+    // Setting the max volume also re-sends the active volume.
+    REQUIRE(messages[1].myData == std::vector<uint8_t>{ 0xB2, 7, 64 });
+    REQUIRE(messages[2].myData == std::vector<uint8_t>{ 0x92, 60, 100 });
+    REQUIRE(messages[3].myData == std::vector<uint8_t>{ 0x82, 60, 127 });
+
+    for (size_t i = 1; i < messages.size(); ++i)
+        REQUIRE(messages[i].myTimestamp >= messages[i - 1].myTimestamp);
+
+    backend->clear();
+    REQUIRE(backend->getMessages().empty());
+}
+
+TEST_CASE("Audio/MidiOutputDevice/RedundantMessages")
+{
+    auto backend = std::make_shared<VirtualMidiOutputBackend>();
+    MidiOutputDevice device(backend);
+    REQUIRE(device.initialize(0, 0));
+
+    device.setPan(0, 20);
+    device.setPan(0, 20);
+    device.setPan(1, 20);
+    device.setVibrato(0, 100);
+    device.setVibrato(0, 100);
+    device.setPitchBend(0, 70);
+    device.setPitchBend(0, 70);
+    device.setPatch(0, 25);
+    device.setPatch(0, 25);
+    // Notes and RPN data entry messages are always sent.
+    device.playNote(0, 60, 100);
+    device.playNote(0, 60, 100);
+    device.setPitchBendRange(0, 24);
+    device.setPitchBendRange(0, 24);
+
+    REQUIRE(backend->getMessages().size() == 15);
+
+    device.setPan(0, 21);
+    REQUIRE(backend->getMessages().size() == 16);
+}
+
+TEST_CASE("Audio/MidiOutputDevice/Batch")
+{
+    auto backend = std::make_shared<VirtualMidiOutputBackend>();
+    MidiOutputDevice device(backend);
+    REQUIRE(device.initialize(0, 0));
+
+    device.beginBatch();
+    device.playNote(0, 60, 100);
+    device.playNote(0, 64, 100);
+    device.setPan(0, 20);
+    REQUIRE(backend->getMessages().empty());
+
+    REQUIRE(device.endBatch());
+    auto messages = backend->getMessages();
+    REQUIRE(messages.size() == 3);
+    REQUIRE(messages[0].myData == std::vector<uint8_t>{ 0x90, 60, 100 });
+    REQUIRE(messages[2].myData == std::vector<uint8_t>{ 0xB0, 10, 20 });
+    REQUIRE(messages[0].myTimestamp == messages[2].myTimestamp);
+
+    // Messages are sent immediately after the batch ends.
+    device.stopNote(0, 60);
+    REQUIRE(backend->getMessages().size() == 4);
+}
@@ -0,0 +1,424 @@
+/*
+ * Copyright (C) 2020 Cameron White
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <doctest/doctest.h>
+
+#include <app/settingsmanager.h>
+#include <audio/midiplayer.h>
+#include <audio/playbackmetrics.h>
+#include <audio/settings.h>
+#include <audio/virtualmidioutputbackend.h>
+#include <score/score.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include "../testhelpers.h"
+
+static const int METRONOME_CHANNEL = 9;
+
+/// Returns the timestamps of the note-on messages that were sent for the
+/// score's notes (i.e. ignoring the metronome).
+static std::vector<std::chrono::microseconds>
+getNoteOnTimes(const VirtualMidiOutputBackend &backend)
+{
+    std::vector<std::chrono::microseconds> times;
+    for (auto &&message : backend.getMessages())
+    {
+        const std::vector<uint8_t> &data = message.myData;
+        if (data.size() == 3 && (data[0] & 0xF0) == 0x90 &&
+            (data[0] & 0x0F) != METRONOME_CHANNEL && data[2] != 0)
+        {
+            times.push_back(message.myTimestamp);
+        }
+    }
+
+    return times;
+}
+
+/// Returns the pitches of the note-on messages that were sent for the score's
+/// notes.
+static std::vector<uint8_t>
+getNoteOnPitches(const VirtualMidiOutputBackend &backend)
+{
+    std::vector<uint8_t> pitches;
+    for (auto &&message : backend.getMessages())
+    {
+        const std::vector<uint8_t> &data = message.myData;
+        if (data.size() == 3 && (data[0] & 0xF0) == 0x90 &&
+            (data[0] & 0x0F) != METRONOME_CHANNEL && data[2] != 0)
+        {
+            pitches.push_back(data[1]);
+        }
+    }
+
+    return pitches;
+}
+
+/// A virtual port which blocks the MIDI thread after a number of the score's
+/// notes have been played, so that the score can be edited at a known
+/// location.
+class PausingMidiOutputBackend : public VirtualMidiOutputBackend
+{
+public:
+    explicit PausingMidiOutputBackend(int num_notes)
+        : myNotesBeforePause(num_notes)
+    {
+    }
+
+    bool sendMessages(const MidiMessageBatch &messages) override
+    {
+        const bool result = VirtualMidiOutputBackend::sendMessages(messages);
+
+        for (size_t i = 0; i < messages.size(); ++i)
+        {
+            const uint8_t *data = messages.getData(i);
+            if (messages.getSize(i) == 3 && (data[0] & 0xF0) == 0x90 &&
+                (data[0] & 0x0F) != METRONOME_CHANNEL && data[2] != 0)
+            {
+                --myNotesBeforePause;
+            }
+        }
+
+        if (myNotesBeforePause == 0)
+        {
+            std::unique_lock<std::mutex> lock(myPauseMutex);
+            myIsPaused = true;
+            myPauseChanged.notify_all();
+            myPauseChanged.wait(lock, [this]() { return !myIsPaused; });
+        }
+
+        return result;
+    }
+
+    /// Waits until the MIDI thread has been blocked.
+    void waitUntilPaused()
+    {
+        std::unique_lock<std::mutex> lock(myPauseMutex);
+        myPauseChanged.wait(lock, [this]() { return myIsPaused; });
+    }
+
+    /// Unblocks the MIDI thread.
+    void resume()
+    {
+        std::lock_guard<std::mutex> lock(myPauseMutex);
+        myIsPaused = false;
+        myPauseChanged.notify_all();
+    }
+
+private:
+    /// Only accessed from the MIDI thread.
+    int myNotesBeforePause;
+    std::mutex myPauseMutex;
+    std::condition_variable myPauseChanged;
+    bool myIsPaused = false;
+};
+
+/// Changes the fret number of the note at the given position.
+static void editNote(Score &score, int position, int fret)
+{
+    Voice &voice = score.getSystems()[0].getStaves()[0].getVoices()[0];
+    voice.getPositions()[position].getNotes()[0].setFretNumber(fret);
+}
+
+static void disableCountIn(SettingsManager &settings_manager)
+{
+    auto settings = settings_manager.getWriteHandle();
+    settings->set(Settings::CountInEnabled, false);
+    settings->set(Settings::MetronomeEnabled, false);
+}
+
+/// Waits until the player has moved to a new location the given number of
+/// times, or has stopped playing.
+static void waitForLocationChanges(const MidiPlayer &player, uint64_t count)
+{
+    while (player.getLocationChangeCount() < count && player.isRunning())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+static void playScore(const Score &score, int speed,
+                      std::shared_ptr<VirtualMidiOutputBackend> backend)
+{
+    SettingsManager settings_manager;
+    disableCountIn(settings_manager);
+
+    MidiPlayer player(settings_manager, ScoreLocation(score), speed, backend);
+    player.start();
+    player.wait();
+}
+
+TEST_CASE("Audio/MidiPlayer/VirtualBackend")
+{
+    Score score;
+    TestHelpers::createScore(score, 4);
+
+    auto backend = std::make_shared<VirtualMidiOutputBackend>();
+    playScore(score, 400, backend);
+
+    auto times = getNoteOnTimes(*backend);
+    REQUIRE(times.size() == 4);
+    REQUIRE(std::is_sorted(times.begin(), times.end()));
+
+    // Eighth notes at 120bpm and 4x speed should be 62.5ms apart.
+    REQUIRE(times.back() - times.front() >= std::chrono::milliseconds(150));
+}
+
+TEST_CASE("Audio/MidiPlayer/PlaybackLocation")
+{
+    Score score;
+    TestHelpers::createScore(score, 4);
+
+    SettingsManager settings_manager;
+    disableCountIn(settings_manager);
+
+    auto backend = std::make_shared<VirtualMidiOutputBackend>();
+    MidiPlayer player(settings_manager, ScoreLocation(score), 400, backend);
+    REQUIRE(player.getPlaybackLocation() == SystemLocation(0, 0));
+    REQUIRE(player.getLocationChangeCount() == 0);
+
+    player.start();
+    player.wait();
+
+    // The location should have moved to each of the remaining notes.
+    REQUIRE(player.getPlaybackLocation() == SystemLocation(0, 3));
+    REQUIRE(player.getLocationChangeCount() == 3);
+}
+
+TEST_CASE("Audio/MidiPlayer/Metrics")
+{
+    Score score;
+    TestHelpers::createScore(score, 4);
+
+    SettingsManager settings_manager;
+    disableCountIn(settings_manager);
+
+    auto backend = std::make_shared<VirtualMidiOutputBackend>();
+    MidiPlayer player(settings_manager, ScoreLocation(score), 400, backend);
+    auto metrics = player.getMetrics();
+    REQUIRE(metrics->getSummary().myTimeToFirstNote == -1);
+
+    player.start();
+    player.wait();
+
+    const PlaybackMetrics::Summary summary = metrics->getSummary();
+    REQUIRE(summary.myGenerationTime > 0);
+    REQUIRE(summary.myTimeToFirstNote >= 0);
+    REQUIRE(summary.mySampleCount > 0);
+    REQUIRE(summary.myLatenessP50 <= summary.myLatenessMax);
+    REQUIRE(summary.myMessageCount >= 8);
+    REQUIRE(summary.myMessagesPerSecond > 0);
+}
+
+TEST_CASE("Audio/MidiPlayer/LiveEdit")
+{
+    // Two bars of four eighth notes.
+    Score score;
+    TestHelpers::createScore(score, 8);
+    score.getSystems()[0].insertBarline(Barline(4, Barline::SingleBar));
+
+    SettingsManager settings_manager;
+    disableCountIn(settings_manager);
+
+    auto backend = std::make_shared<PausingMidiOutputBackend>(2);
+    {
+        MidiPlayer player(settings_manager, ScoreLocation(score), 400,
+                          backend);
+        player.start();
+
+        // Edit a note in each bar while the first bar is being played. Only
+        // the edit to the second bar should be heard.
+        backend->waitUntilPaused();
+        editNote(score, 3, 20);
+        editNote(score, 6, 20);
+        player.updateScore();
+        player.waitForScoreUpdate();
+        backend->resume();
+        player.wait();
+    }
+
+    Score expected_score;
+    TestHelpers::createScore(expected_score, 8);
+    expected_score.getSystems()[0].insertBarline(
+        Barline(4, Barline::SingleBar));
+    editNote(expected_score, 6, 20);
+
+    auto expected_backend = std::make_shared<VirtualMidiOutputBackend>();
+    playScore(expected_score, 400, expected_backend);
+
+    REQUIRE(getNoteOnPitches(*backend) == getNoteOnPitches(*expected_backend));
+
+    // The timing of the second bar should be unaffected.
+    auto times = getNoteOnTimes(*backend);
+    REQUIRE(times.size() == 8);
+    REQUIRE(times[4] - times[3] >= std::chrono::milliseconds(50));
+}
+
+TEST_CASE("Audio/MidiPlayer/LiveEditInsertBar")
+{
+    // Three bars of four eighth notes.
+    auto create_score = [](Score &score) {
+        TestHelpers::createScore(score, 12);
+        score.getSystems()[0].insertBarline(Barline(4, Barline::SingleBar));
+        score.getSystems()[0].insertBarline(Barline(8, Barline::SingleBar));
+    };
+
+    Score score;
+    create_score(score);
+
+    SettingsManager settings_manager;
+    disableCountIn(settings_manager);
+
+    auto backend = std::make_shared<PausingMidiOutputBackend>(6);
+    {
+        MidiPlayer player(settings_manager, ScoreLocation(score), 400,
+                          backend);
+        player.start();
+
+        // Split the first bar while the second bar is being played. This
+        // changes the bars that were already played, so the edit should be
+        // ignored rather than e.g. repeating the second bar.
+        backend->waitUntilPaused();
+        score.getSystems()[0].insertBarline(Barline(2, Barline::SingleBar));
+        player.updateScore();
+        player.waitForScoreUpdate();
+        backend->resume();
+        player.wait();
+    }
+
+    Score original_score;
+    create_score(original_score);
+
+    auto expected_backend = std::make_shared<VirtualMidiOutputBackend>();
+    playScore(original_score, 400, expected_backend);
+
+    REQUIRE(getNoteOnPitches(*backend).size() == 12);
+    REQUIRE(getNoteOnPitches(*backend) == getNoteOnPitches(*expected_backend));
+}
+
+TEST_CASE("Audio/MidiPlayer/Loop")
+{
+    Score score;
+    TestHelpers::createScore(score, 4);
+
+    auto backend = std::make_shared<VirtualMidiOutputBackend>();
+    {
+        SettingsManager settings_manager;
+        disableCountIn(settings_manager);
+
+        MidiPlayer player(settings_manager, ScoreLocation(score), 400, backend);
+        player.setLoopRange(SystemLocation(0, 0), SystemLocation(0, 0));
+        player.start();
+
+        // Stop the player once it has reached the last note of the second
+        // pass. The first note of each pass doesn't change the location.
+        waitForLocationChanges(player, 7);
+    }
+
+    auto times = getNoteOnTimes(*backend);
+    REQUIRE(times.size() >= 8);
+
+    // The second pass should start one bar after the first pass.
+    REQUIRE(times[4] - times[0] >= std::chrono::milliseconds(200));
+}
+
+TEST_CASE("Audio/MidiPlayer/LoopHeldNotes")
+{
+    // Two bars of four eighth notes, where the last note of the first bar is
+    // tied into the second bar.
+    Score score;
+    TestHelpers::createScore(score, 8);
+    System &system = score.getSystems()[0];
+    system.insertBarline(Barline(4, Barline::SingleBar));
+    Voice &voice = system.getStaves()[0].getVoices()[0];
+    Note &tied_note = voice.getPositions()[4].getNotes()[0];
+    tied_note.setFretNumber(3);
+    tied_note.setProperty(Note::Tied);
+
+    auto backend = std::make_shared<VirtualMidiOutputBackend>();
+    {
+        SettingsManager settings_manager;
+        disableCountIn(settings_manager);
+
+        MidiPlayer player(settings_manager, ScoreLocation(score), 400, backend);
+        player.setLoopRange(SystemLocation(0, 0), SystemLocation(0, 0));
+        player.start();
+
+        waitForLocationChanges(player, 7);
+    }
+
+    // The tied note should be stopped at the end of each pass rather than
+    // left hanging.
+    const uint8_t pitch = getNoteOnPitches(*backend).at(3);
+    int num_active = 0;
+    int num_passes = 0;
+    for (auto &&message : backend->getMessages())
+    {
+        const std::vector<uint8_t> &data = message.myData;
+        if (data.size() != 3 || (data[0] & 0x0F) == METRONOME_CHANNEL ||
+            data[1] != pitch)
+        {
+            continue;
+        }
+
+        const bool note_on = (data[0] & 0xF0) == 0x90 && data[2] != 0;
+        const bool note_off = (data[0] & 0xF0) == 0x80 ||
+                              ((data[0] & 0xF0) == 0x90 && data[2] == 0);
+        if (note_on)
+        {
+            REQUIRE(num_active == 0);
+            ++num_active;
+            ++num_passes;
+        }
+        else if (note_off)
+            num_active = 0;
+    }
+
+    REQUIRE(num_passes >= 2);
+}
+
+TEST_CASE("Audio/MidiPlayer/SchedulingAccuracy" * doctest::skip())
+{
+    const int num_notes = 32;
+    Score score;
+    TestHelpers::createScore(score, num_notes);
+
+    auto backend = std::make_shared<VirtualMidiOutputBackend>();
+    playScore(score, 400, backend);
+
+    auto times = getNoteOnTimes(*backend);
+    REQUIRE(times.size() == num_notes);
+
+    // Compare against the ideal times, relative to the first note.
+    const std::chrono::microseconds interval(62500);
+    std::vector<int64_t> errors;
+    for (int i = 0; i < num_notes; ++i)
+    {
+        auto expected = times.front() + i * interval;
+        errors.push_back(std::abs((times[i] - expected).count()));
+    }
+
+    std::sort(errors.begin(), errors.end());
+    int64_t total = 0;
+    for (int64_t error : errors)
+        total += error;
+
+    MESSAGE("Mean scheduling error: " << total / num_notes << "us");
+    MESSAGE("95th percentile error: " << errors[num_notes * 95 / 100] << "us");
+    MESSAGE("Max scheduling error: " << errors.back() << "us");
+}
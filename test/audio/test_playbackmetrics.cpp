@@ -0,0 +1,74 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <doctest/doctest.h>
+
+#include <audio/playbackmetrics.h>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Audio/PlaybackMetrics/Summary")
+{
+    const auto start = PlaybackMetrics::Clock::now();
+    PlaybackMetrics metrics(start);
+    metrics.recordGenerationTime(5ms);
+    metrics.recordCountIn(1s);
+    // Messages before the first note should be ignored.
+    metrics.recordMessages(10, start + 500ms);
+    metrics.recordFirstNote(start + 1s + 20ms);
+
+    // Lateness of 1..100ms, in a shuffled order.
+    for (int i = 0; i < 100; ++i)
+        metrics.recordLateness(std::chrono::milliseconds((i * 37) % 100 + 1));
+
+    metrics.recordDriftCorrection(2ms);
+    metrics.recordDriftCorrection(3ms);
+    metrics.recordMessages(50, start + 1s + 20ms + 250ms);
+    metrics.recordMessages(50, start + 1s + 20ms + 500ms);
+
+    const PlaybackMetrics::Summary summary = metrics.getSummary();
+    REQUIRE(summary.myGenerationTime == 5000);
+    // The count-in is excluded.
+    REQUIRE(summary.myTimeToFirstNote == 20000);
+    REQUIRE(summary.mySampleCount == 100);
+    REQUIRE(summary.myLatenessP50 == 50000);
+    REQUIRE(summary.myLatenessP95 == 95000);
+    REQUIRE(summary.myLatenessP99 == 99000);
+    REQUIRE(summary.myLatenessMax == 100000);
+    REQUIRE(summary.myDriftCorrections == 2);
+    REQUIRE(summary.myDriftCorrectionTotal == 5000);
+    REQUIRE(summary.myMessageCount == 100);
+    REQUIRE(summary.myMessagesPerSecond == 200);
+}
+
+TEST_CASE("Audio/PlaybackMetrics/History")
+{
+    PlaybackMetrics metrics;
+    REQUIRE(metrics.getSummary().mySampleCount == 0);
+    REQUIRE(metrics.getSummary().myTimeToFirstNote == -1);
+
+    // Only the most recent samples are kept.
+    for (size_t i = 0; i < PlaybackMetrics::HISTORY_SIZE; ++i)
+        metrics.recordLateness(50ms);
+    for (size_t i = 0; i < PlaybackMetrics::HISTORY_SIZE; ++i)
+        metrics.recordLateness(1ms);
+
+    const PlaybackMetrics::Summary summary = metrics.getSummary();
+    REQUIRE(summary.mySampleCount == PlaybackMetrics::HISTORY_SIZE);
+    REQUIRE(summary.myLatenessMax == 1000);
+}
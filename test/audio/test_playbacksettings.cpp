@@ -0,0 +1,47 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <doctest/doctest.h>
+
+#include <app/settingsmanager.h>
+#include <audio/playbacksettings.h>
+#include <audio/settings.h>
+
+TEST_CASE("Audio/PlaybackSettings")
+{
+    SettingsManager settings_manager;
+    {
+        auto settings = settings_manager.getWriteHandle();
+        settings->set(Settings::MetronomeEnabled, false);
+        settings->set(Settings::CountInVolume, 80);
+    }
+
+    PlaybackSettingsPublisher publisher(settings_manager);
+    const PlaybackSettings &original = publisher.get();
+    REQUIRE(!original.myMetronomeEnabled);
+    REQUIRE(original.myCountInVolume == 80);
+
+    {
+        auto settings = settings_manager.getWriteHandle();
+        settings->set(Settings::MetronomeEnabled, true);
+    }
+
+    // A new snapshot is published, and the old snapshot is unchanged.
+    REQUIRE(publisher.get().myMetronomeEnabled);
+    REQUIRE(publisher.get().myCountInVolume == 80);
+    REQUIRE(!original.myMetronomeEnabled);
+}
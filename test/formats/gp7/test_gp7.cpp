@@ -18,7 +18,13 @@
 #include <doctest/doctest.h>
 
 #include <app/appinfo.h>
+#include <chrono>
+#include <formats/gp7/converter.h>
 #include <formats/gp7/gp7importer.h>
+#include <formats/gp7/parser.h>
+#include <fstream>
+#include <iterator>
+#include <sstream>
 #include <score/generalmidi.h>
 #include <score/keysignature.h>
 #include <score/note.h>
@@ -54,6 +60,23 @@ TEST_CASE("Formats/Gp7Import/ScoreInfo/Basic")
     REQUIRE(data.getPerformanceNotes() == "The instructions");
 }
 
+// Verify that an archive can be imported from memory.
+TEST_CASE("Formats/Gp7Import/ScoreInfo/FromMemory")
+{
+    std::ifstream file(AppInfo::getAbsolutePath("data/score_info.gp"),
+                       std::ios::in | std::ios::binary);
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                                    std::istreambuf_iterator<char>());
+    REQUIRE(!data.empty());
+
+    Score score;
+    REQUIRE_NOTHROW(Gp7Importer::load(data.data(), data.size(), score));
+
+    const SongData &song_data = score.getScoreInfo().getSongData();
+    REQUIRE(song_data.getTitle() == "The title");
+    REQUIRE(song_data.getArtist() == "The artist");
+}
+
 // Verify that the "Words & Music" style header is imported properly.
 TEST_CASE("Formats/Gp7Import/ScoreInfo/WordsAndMusic")
 {
@@ -865,3 +888,108 @@ TEST_CASE("Formats/Gp7Import/Harmonics")
                        Octave::Octave15ma);
     }
 }
+
+/// Creates a score.gpif document with the given number of tracks and bars,
+/// where each bar has eight eighth notes.
+static std::string
+createLargeDocument(int num_tracks, int num_bars)
+{
+    const int beats_per_bar = 8;
+
+    std::ostringstream xml;
+    xml << "<GPIF><Score><ScoreSystemsLayout>";
+    for (int i = 0; i < num_bars; i += 4)
+        xml << (i ? " " : "") << std::min(4, num_bars - i);
+    xml << "</ScoreSystemsLayout></Score>";
+
+    xml << "<Tracks>";
+    for (int track = 0; track < num_tracks; ++track)
+    {
+        xml << "<Track id=\"" << track << "\"><Name>Track " << track
+            << "</Name><Staves><Staff><Properties>"
+            << "<Property name=\"Tuning\"><Pitches>40 45 50 55 59 64"
+            << "</Pitches></Property></Properties></Staff></Staves>"
+            << "<Sounds><Sound><Label>Guitar</Label><MIDI><Program>25"
+            << "</Program></MIDI></Sound></Sounds></Track>";
+    }
+    xml << "</Tracks>";
+
+    xml << "<MasterBars>";
+    for (int bar = 0; bar < num_bars; ++bar)
+    {
+        xml << "<MasterBar><Time>4/4</Time><Bars>";
+        for (int track = 0; track < num_tracks; ++track)
+            xml << (track ? " " : "") << bar * num_tracks + track;
+        xml << "</Bars></MasterBar>";
+    }
+    xml << "</MasterBars>";
+
+    // Each bar has a single voice, with the same id.
+    const int num_voices = num_bars * num_tracks;
+    xml << "<Bars>";
+    for (int id = 0; id < num_voices; ++id)
+    {
+        xml << "<Bar id=\"" << id << "\"><Clef>G2</Clef><Voices>" << id
+            << " -1 -1 -1</Voices></Bar>";
+    }
+    xml << "</Bars><Voices>";
+    for (int id = 0; id < num_voices; ++id)
+    {
+        xml << "<Voice id=\"" << id << "\"><Beats>";
+        for (int i = 0; i < beats_per_bar; ++i)
+            xml << (i ? " " : "") << id * beats_per_bar + i;
+        xml << "</Beats></Voice>";
+    }
+
+    // Each beat has a single note, with the same id.
+    const int num_beats = num_voices * beats_per_bar;
+    xml << "</Voices><Beats>";
+    for (int id = 0; id < num_beats; ++id)
+    {
+        xml << "<Beat id=\"" << id << "\"><Rhythm ref=\"0\"/><Notes>" << id
+            << "</Notes></Beat>";
+    }
+    xml << "</Beats><Notes>";
+    for (int id = 0; id < num_beats; ++id)
+    {
+        xml << "<Note id=\"" << id << "\"><Properties>"
+            << "<Property name=\"String\"><String>" << id % 6
+            << "</String></Property><Property name=\"Fret\"><Fret>" << id % 12
+            << "</Fret></Property></Properties></Note>";
+    }
+    xml << "</Notes><Rhythms><Rhythm id=\"0\"><NoteValue>Eighth</NoteValue>"
+        << "</Rhythm></Rhythms></GPIF>";
+
+    return xml.str();
+}
+
+TEST_CASE("Formats/Gp7Import/Benchmark" * doctest::skip())
+{
+    const std::string xml = createLargeDocument(8, 500);
+
+    pugi::xml_document xml_doc;
+    REQUIRE(xml_doc.load_string(xml.c_str()));
+
+    using Clock = std::chrono::high_resolution_clock;
+    const int num_passes = 10;
+
+    auto start = Clock::now();
+    Gp7::Document doc;
+    for (int i = 0; i < num_passes; ++i)
+        doc = Gp7::parse(xml_doc, Gp7::Version::V7);
+    const std::chrono::duration<double> parse_time = Clock::now() - start;
+
+    start = Clock::now();
+    for (int i = 0; i < num_passes; ++i)
+    {
+        Score score;
+        Gp7::convert(doc, score);
+        REQUIRE(score.getSystems().size() == 125);
+    }
+    const std::chrono::duration<double> convert_time = Clock::now() - start;
+
+    MESSAGE(doc.myBars.size() << " bars, " << doc.myBeats.size() << " beats");
+    MESSAGE("Parsed in " << parse_time.count() * 1000 / num_passes << "ms");
+    MESSAGE("Converted in " << convert_time.count() * 1000 / num_passes
+                            << "ms");
+}
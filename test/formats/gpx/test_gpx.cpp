@@ -18,8 +18,12 @@
 #include <doctest/doctest.h>
 
 #include <app/appinfo.h>
+#include <chrono>
+#include <formats/gpx/filesystem.h>
 #include <formats/gpx/gpximporter.h>
+#include <fstream>
 #include <score/score.h>
+#include <sstream>
 
 TEST_CASE("Formats/GpxImport/Text")
 {
@@ -33,3 +37,34 @@ TEST_CASE("Formats/GpxImport/Text")
     REQUIRE(system.getTextItems()[0].getPosition() == 9);
     REQUIRE(system.getTextItems()[0].getContents() == "foo");
 }
+
+TEST_CASE("Formats/GpxImport/DecompressionBenchmark" * doctest::skip())
+{
+    const char *filenames[] = { "data/text.gpx" };
+
+    using Clock = std::chrono::high_resolution_clock;
+    const int num_passes = 200;
+
+    for (const char *filename : filenames)
+    {
+        std::ifstream file(AppInfo::getAbsolutePath(filename),
+                           std::ios::in | std::ios::binary);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        const std::string data = buffer.str();
+        REQUIRE(!data.empty());
+
+        auto start = Clock::now();
+        for (int i = 0; i < num_passes; ++i)
+        {
+            std::istringstream input(data);
+            Gpx::FileSystem filesystem(input);
+            REQUIRE(!filesystem.getFileContents("score.gpif").empty());
+        }
+        const std::chrono::duration<double> time = Clock::now() - start;
+
+        const double num_bytes = static_cast<double>(data.size()) * num_passes;
+        MESSAGE(filename << ": " << data.size() << " bytes, "
+                         << num_bytes / time.count() / 1e6 << " MB/s");
+    }
+}
@@ -18,8 +18,12 @@
 #include <doctest/doctest.h>
 
 #include <app/appinfo.h>
+#include <formats/guitar_pro/document.h>
 #include <formats/guitar_pro/guitarproimporter.h>
+#include <formats/guitar_pro/inputstream.h>
+#include <fstream>
 #include <score/score.h>
+#include <sstream>
 
 static void loadTest(GuitarProImporter &importer, const char *filename,
                      Score &score)
@@ -502,3 +506,22 @@ TEST_CASE("Formats/GuitarPro/Bends")
         REQUIRE(note.getBend().getBentPitch() == 4);
     }
 }
+
+// Verify that a truncated file produces an error rather than reading past the
+// end of the data.
+TEST_CASE("Formats/GuitarPro/TruncatedFile")
+{
+    std::ifstream file(AppInfo::getAbsolutePath("data/notes.gp5"),
+                       std::ios::in | std::ios::binary);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string data = buffer.str();
+    REQUIRE(data.size() > 100);
+
+    std::istringstream input(data.substr(0, data.size() / 2));
+    Gp::InputStream stream(input);
+    REQUIRE(stream.version() == Gp::Version5_1);
+
+    Gp::Document document;
+    REQUIRE_THROWS_AS(document.load(stream), FileFormatException);
+}
@@ -0,0 +1,186 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <doctest/doctest.h>
+
+#include <app/appinfo.h>
+#include <app/settingsmanager.h>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <formats/midi/midiexporter.h>
+#include <formats/powertab_old/powertaboldimporter.h>
+#include <iterator>
+#include <midi/midifile.h>
+#include <score/score.h>
+#include <util/scopeexit.h>
+#include "../../testhelpers.h"
+
+static uint32_t readVariableLength(const std::vector<uint8_t> &data,
+                                   size_t &offset)
+{
+    uint32_t value = 0;
+    uint8_t byte;
+    do
+    {
+        byte = data[offset++];
+        value = (value << 7) | (byte & 0x7f);
+    } while (byte & 0x80);
+
+    return value;
+}
+
+/// Decodes the events in a track chunk, expanding any running status.
+static std::vector<std::pair<int, std::vector<uint8_t>>>
+readTrack(const std::vector<uint8_t> &data, size_t offset, size_t end)
+{
+    std::vector<std::pair<int, std::vector<uint8_t>>> events;
+    uint8_t running_status = 0;
+    while (offset < end)
+    {
+        const int ticks = readVariableLength(data, offset);
+
+        std::vector<uint8_t> message;
+        uint8_t status = data[offset];
+        if (status & 0x80)
+            ++offset;
+        else
+            status = running_status;
+
+        message.push_back(status);
+        if (status == 0xff)
+        {
+            message.push_back(data[offset++]);
+            const size_t start = offset;
+            const uint32_t length = readVariableLength(data, offset);
+            message.insert(message.end(), data.begin() + start,
+                           data.begin() + offset + length);
+            offset += length;
+            running_status = 0;
+        }
+        else
+        {
+            const int num_bytes =
+                ((status & 0xf0) == 0xc0 || (status & 0xf0) == 0xd0) ? 1 : 2;
+            message.insert(message.end(), data.begin() + offset,
+                           data.begin() + offset + num_bytes);
+            offset += num_bytes;
+            running_status = status;
+        }
+
+        events.emplace_back(ticks, std::move(message));
+    }
+
+    return events;
+}
+
+static void loadScore(Score &score)
+{
+    PowerTabOldImporter importer;
+    importer.load(AppInfo::getAbsolutePath("data/notes.ptb"), score);
+}
+
+static std::vector<uint8_t> readFile(const boost::filesystem::path &path)
+{
+    boost::filesystem::ifstream is(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(is)),
+                                std::istreambuf_iterator<char>());
+}
+
+static boost::filesystem::path getTempPath()
+{
+    return boost::filesystem::temp_directory_path() /
+           boost::filesystem::unique_path("%%%%-%%%%-%%%%.mid");
+}
+
+TEST_CASE("Formats/MidiExport/RunningStatus")
+{
+    Score score;
+    loadScore(score);
+
+    MidiFile file;
+    file.load(score, MidiFile::LoadOptions());
+    const std::vector<uint8_t> data = MidiExporter::serialize(file);
+
+    REQUIRE(std::string(data.begin(), data.begin() + 4) == "MThd");
+    REQUIRE(TestHelpers::readBigEndianUInt32(data, 4) == 6);
+
+    size_t offset = 14;
+    size_t full_size = 14;
+    for (const MidiEventList &track : file.getTracks())
+    {
+        REQUIRE(std::string(data.begin() + offset,
+                            data.begin() + offset + 4) == "MTrk");
+        const size_t length =
+            TestHelpers::readBigEndianUInt32(data, offset + 4);
+        offset += 8;
+
+        // The decoded events should match the original events.
+        auto events = readTrack(data, offset, offset + length);
+        REQUIRE(events.size() == track.size());
+        size_t i = 0;
+        for (const MidiEvent &event : track)
+        {
+            REQUIRE(events[i].first == event.getTicks());
+            REQUIRE(events[i].second == event.getData());
+            ++i;
+        }
+
+        offset += length;
+
+        full_size += 8;
+        for (const MidiEvent &event : track)
+        {
+            size_t ticks_size = 1;
+            for (int ticks = event.getTicks(); ticks >= 0x80; ticks >>= 7)
+                ++ticks_size;
+            full_size += ticks_size + event.getData().size();
+        }
+    }
+
+    REQUIRE(offset == data.size());
+    // Running status should omit some of the status bytes.
+    REQUIRE(data.size() < full_size);
+}
+
+TEST_CASE("Formats/MidiExport/SaveAll")
+{
+    Score score1, score2;
+    loadScore(score1);
+    loadScore(score2);
+    score2.getSystems()[0].getStaves()[0].getVoices()[0].getPositions()[0]
+        .getNotes()[0].setFretNumber(12);
+
+    const boost::filesystem::path path = getTempPath();
+    const std::vector<boost::filesystem::path> paths = { getTempPath(),
+                                                         getTempPath() };
+    Util::ScopeExit remove_files([&]() {
+        boost::filesystem::remove(path);
+        for (auto &&p : paths)
+            boost::filesystem::remove(p);
+    });
+
+    SettingsManager settings_manager;
+    MidiExporter exporter(settings_manager);
+    exporter.saveAll(paths, { &score1, &score2 });
+
+    exporter.save(path, score1);
+    REQUIRE(readFile(paths[0]) == readFile(path));
+
+    exporter.save(path, score2);
+    REQUIRE(readFile(paths[1]) == readFile(path));
+    REQUIRE(readFile(paths[0]) != readFile(paths[1]));
+}
@@ -0,0 +1,320 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <doctest/doctest.h>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <chrono>
+#include <formats/fileformat.h>
+#include <formats/midi/midiexporter.h>
+#include <formats/midi/midiimporter.h>
+#include <formats/midi/smfreader.h>
+#include <midi/midifile.h>
+#include <score/generalmidi.h>
+#include <score/score.h>
+#include <util/scopeexit.h>
+#include "../../testhelpers.h"
+
+static std::vector<uint8_t> exportScore(const Score &score, MidiFile &file)
+{
+    file.load(score, MidiFile::LoadOptions());
+    return MidiExporter::serialize(file);
+}
+
+TEST_CASE("Formats/MidiImport/Reader")
+{
+    Score score;
+    TestHelpers::createScore(score, 32);
+
+    MidiFile file;
+    const std::vector<uint8_t> data = exportScore(score, file);
+
+    SmfReader reader(data.data(), data.size());
+    REQUIRE(reader.getFormat() == 1);
+    REQUIRE(reader.getTrackCount() == static_cast<int>(file.getTracks().size()));
+    REQUIRE(reader.getTicksPerBeat() == file.getTicksPerBeat());
+
+    // The events should match the MIDI file's events.
+    for (const MidiEventList &track : file.getTracks())
+    {
+        REQUIRE(reader.nextTrack());
+
+        uint32_t ticks = 0;
+        SmfReader::Event event;
+        for (const MidiEvent &expected : track)
+        {
+            REQUIRE(reader.nextEvent(event));
+
+            ticks += expected.getTicks();
+            REQUIRE(event.myTicks == ticks);
+
+            const std::vector<uint8_t> &expected_data = expected.getData();
+            REQUIRE(event.myStatus == expected_data[0]);
+            REQUIRE(std::equal(event.myData, event.myData + event.mySize,
+                               expected_data.end() - event.mySize));
+        }
+
+        REQUIRE(!reader.nextEvent(event));
+    }
+
+    REQUIRE(!reader.nextTrack());
+
+    // Truncated files should be rejected.
+    REQUIRE_THROWS_AS(SmfReader(data.data(), 10), FileFormatException);
+    SmfReader truncated(data.data(), data.size() - 4);
+    SmfReader::Event event;
+    auto read_all = [&]() {
+        while (truncated.nextTrack())
+        {
+            while (truncated.nextEvent(event))
+                ;
+        }
+    };
+    REQUIRE_THROWS_AS(read_all(), FileFormatException);
+}
+
+TEST_CASE("Formats/MidiImport/RoundTrip")
+{
+    Score score;
+    score.insertPlayer(Player());
+    Instrument instrument;
+    instrument.setMidiPreset(Midi::MIDI_PRESET_ACOUSTIC_GUITAR_STEEL);
+    score.insertInstrument(instrument);
+
+    {
+        System system;
+        Staff staff;
+        Voice &voice = staff.getVoices()[0];
+
+        Position pos0(0, Position::QuarterNote);
+        pos0.insertNote(Note(2, 2));
+        voice.insertPosition(pos0);
+
+        Position pos1(1, Position::EighthNote);
+        pos1.insertNote(Note(0, 3));
+        voice.insertPosition(pos1);
+
+        Position pos2(2, Position::EighthNote);
+        pos2.insertNote(Note(1, 1));
+        voice.insertPosition(pos2);
+
+        Position pos3(3, Position::QuarterNote);
+        pos3.setProperty(Position::Dotted);
+        pos3.insertNote(Note(3, 2));
+        pos3.insertNote(Note(4, 2));
+        pos3.insertNote(Note(5, 0));
+        voice.insertPosition(pos3);
+
+        Position pos4(4, Position::EighthNote);
+        pos4.setRest();
+        voice.insertPosition(pos4);
+
+        system.insertStaff(staff);
+        system.getBarlines()[1] = Barline(5, Barline::SingleBar);
+
+        PlayerChange change(0);
+        change.insertActivePlayer(0, ActivePlayer(0, 0));
+        system.insertPlayerChange(change);
+        score.insertSystem(system);
+    }
+
+    MidiFile file;
+    const std::vector<uint8_t> data = exportScore(score, file);
+
+    Score imported;
+    MidiImporter::load(data.data(), data.size(), imported);
+
+    REQUIRE(imported.getPlayers().size() == 1);
+    REQUIRE(imported.getInstruments().size() == 1);
+    REQUIRE(imported.getInstruments()[0].getMidiPreset() ==
+            Midi::MIDI_PRESET_ACOUSTIC_GUITAR_STEEL);
+    REQUIRE(imported.getSystems().size() == 1);
+
+    const System &system = imported.getSystems()[0];
+    REQUIRE(system.getStaves().size() == 1);
+    REQUIRE(system.getBarlines().size() == 2);
+    REQUIRE(system.getTempoMarkers().size() == 1);
+
+    const Voice &expected_voice =
+        score.getSystems()[0].getStaves()[0].getVoices()[0];
+    const Voice &voice = system.getStaves()[0].getVoices()[0];
+    REQUIRE(voice.getPositions().size() == expected_voice.getPositions().size());
+
+    for (size_t i = 0; i < voice.getPositions().size(); ++i)
+    {
+        const Position &expected = expected_voice.getPositions()[i];
+        const Position &pos = voice.getPositions()[i];
+
+        REQUIRE(pos.getDurationType() == expected.getDurationType());
+        REQUIRE(pos.hasProperty(Position::Dotted) ==
+                expected.hasProperty(Position::Dotted));
+        REQUIRE(pos.isRest() == expected.isRest());
+        REQUIRE(pos.getNotes().size() == expected.getNotes().size());
+
+        for (size_t j = 0; j < pos.getNotes().size(); ++j)
+        {
+            REQUIRE(pos.getNotes()[j].getString() ==
+                    expected.getNotes()[j].getString());
+            REQUIRE(pos.getNotes()[j].getFretNumber() ==
+                    expected.getNotes()[j].getFretNumber());
+        }
+    }
+}
+
+TEST_CASE("Formats/MidiImport/TempoAndTimeSignatureChanges")
+{
+    // A bar of 4/4 at 120 bpm, followed by a bar of 3/4 at 100 bpm.
+    const std::vector<uint8_t> track = {
+        0x00, 0xff, 0x58, 0x04, 0x04, 0x02, 0x18, 0x08,
+        0x00, 0xff, 0x51, 0x03, 0x07, 0xa1, 0x20,
+        0x00, 0x90, 0x40, 0x64,
+        0x83, 0x00, 0x80, 0x40, 0x00,
+        0x00, 0xff, 0x58, 0x04, 0x03, 0x02, 0x18, 0x08,
+        0x00, 0xff, 0x51, 0x03, 0x09, 0x27, 0xc0,
+        0x00, 0x90, 0x40, 0x64,
+        0x82, 0x20, 0x80, 0x40, 0x00,
+        0x00, 0xff, 0x2f, 0x00
+    };
+
+    std::vector<uint8_t> data = {
+        'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96,
+        'M', 'T', 'r', 'k', 0, 0, 0, static_cast<uint8_t>(track.size())
+    };
+    data.insert(data.end(), track.begin(), track.end());
+
+    Score score;
+    MidiImporter::load(data.data(), data.size(), score);
+
+    REQUIRE(score.getSystems().size() == 1);
+    const System &system = score.getSystems()[0];
+    REQUIRE(system.getBarlines().size() == 3);
+
+    const TimeSignature &time_sig1 =
+        system.getBarlines()[0].getTimeSignature();
+    REQUIRE(time_sig1.getBeatsPerMeasure() == 4);
+    REQUIRE(time_sig1.isVisible());
+
+    const TimeSignature &time_sig2 =
+        system.getBarlines()[1].getTimeSignature();
+    REQUIRE(time_sig2.getBeatsPerMeasure() == 3);
+    REQUIRE(time_sig2.getBeatValue() == 4);
+    REQUIRE(time_sig2.isVisible());
+
+    REQUIRE(system.getTempoMarkers().size() == 2);
+    REQUIRE(system.getTempoMarkers()[0].getPosition() == 0);
+    REQUIRE(system.getTempoMarkers()[0].getBeatsPerMinute() == 120);
+    REQUIRE(system.getTempoMarkers()[1].getPosition() ==
+            system.getBarlines()[1].getPosition() + 1);
+    REQUIRE(system.getTempoMarkers()[1].getBeatsPerMinute() == 100);
+
+    const Voice &voice = system.getStaves()[0].getVoices()[0];
+    REQUIRE(voice.getPositions().size() == 2);
+    REQUIRE(voice.getPositions()[1].getDurationType() == Position::HalfNote);
+    REQUIRE(voice.getPositions()[1].hasProperty(Position::Dotted));
+}
+
+TEST_CASE("Formats/MidiImport/HeldNotes")
+{
+    // A note that lasts for a bar and a half.
+    const std::vector<uint8_t> data = {
+        'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96,
+        'M', 'T', 'r', 'k', 0, 0, 0, 13,
+        0x00, 0x90, 0x40, 0x64,
+        0x84, 0x40, 0x80, 0x40, 0x00,
+        0x00, 0xff, 0x2f, 0x00
+    };
+
+    Score score;
+    MidiImporter::load(data.data(), data.size(), score);
+
+    REQUIRE(score.getSystems().size() == 1);
+    const System &system = score.getSystems()[0];
+    REQUIRE(system.getBarlines().size() == 3);
+
+    // The note should continue into the second bar as a tied note.
+    const Voice &voice = system.getStaves()[0].getVoices()[0];
+    REQUIRE(voice.getPositions().size() == 3);
+
+    const Position &pos1 = voice.getPositions()[0];
+    REQUIRE(pos1.getDurationType() == Position::WholeNote);
+    REQUIRE(pos1.getNotes().size() == 1);
+    REQUIRE(!pos1.getNotes()[0].hasProperty(Note::Tied));
+
+    const Position &pos2 = voice.getPositions()[1];
+    REQUIRE(pos2.getPosition() > system.getBarlines()[1].getPosition());
+    REQUIRE(pos2.getDurationType() == Position::HalfNote);
+    REQUIRE(pos2.getNotes().size() == 1);
+    REQUIRE(pos2.getNotes()[0].hasProperty(Note::Tied));
+    REQUIRE(pos2.getNotes()[0].getString() == pos1.getNotes()[0].getString());
+    REQUIRE(pos2.getNotes()[0].getFretNumber() ==
+            pos1.getNotes()[0].getFretNumber());
+
+    REQUIRE(voice.getPositions()[2].isRest());
+}
+
+TEST_CASE("Formats/MidiImport/EmptyFile")
+{
+    const boost::filesystem::path path =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("%%%%-%%%%-%%%%.mid");
+    boost::filesystem::ofstream(path).close();
+    Util::ScopeExit remove_file([&]() { boost::filesystem::remove(path); });
+
+    Score score;
+    MidiImporter importer;
+    REQUIRE_THROWS_AS(importer.load(path, score), FileFormatException);
+}
+
+TEST_CASE("Formats/MidiImport/Benchmark" * doctest::skip())
+{
+    Score score;
+    TestHelpers::createScore(score, 32);
+    const System system = score.getSystems()[0];
+    for (int i = 1; i < 500; ++i)
+        score.insertSystem(system);
+
+    MidiFile file;
+    const std::vector<uint8_t> data = exportScore(score, file);
+
+    using Clock = std::chrono::high_resolution_clock;
+    const int num_passes = 20;
+
+    auto start = Clock::now();
+    size_t num_events = 0;
+    for (int i = 0; i < num_passes; ++i)
+    {
+        SmfReader reader(data.data(), data.size());
+        SmfReader::Event event;
+        while (reader.nextTrack())
+        {
+            while (reader.nextEvent(event))
+                ++num_events;
+        }
+    }
+    const std::chrono::duration<double> read_time = Clock::now() - start;
+
+    start = Clock::now();
+    Score imported;
+    MidiImporter::load(data.data(), data.size(), imported);
+    const std::chrono::duration<double> import_time = Clock::now() - start;
+
+    MESSAGE("File size: " << data.size() << " bytes, "
+                          << num_events / num_passes << " events");
+    MESSAGE("Parsed " << num_events / read_time.count() << " events/sec");
+    MESSAGE("Imported in " << import_time.count() * 1000 << "ms");
+}
@@ -0,0 +1,62 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <doctest/doctest.h>
+
+#include <app/appinfo.h>
+#include <app/settingsmanager.h>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <formats/powertab_old/powertaboldimporter.h>
+#include <formats/wav/wavexporter.h>
+#include <iterator>
+#include <score/score.h>
+#include <util/scopeexit.h>
+#include "../../testhelpers.h"
+
+TEST_CASE("Formats/WavExport/Basic")
+{
+    Score score;
+    PowerTabOldImporter importer;
+    importer.load(AppInfo::getAbsolutePath("data/notes.ptb"), score);
+
+    const boost::filesystem::path path =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("%%%%-%%%%-%%%%.wav");
+    Util::ScopeExit remove_file([&]() { boost::filesystem::remove(path); });
+
+    SettingsManager settings_manager;
+    WavExporter exporter(settings_manager);
+    exporter.save(path, score);
+
+    boost::filesystem::ifstream is(path, std::ios::binary);
+    const std::vector<char> data((std::istreambuf_iterator<char>(is)),
+                                 std::istreambuf_iterator<char>());
+
+    REQUIRE(data.size() > 44);
+    REQUIRE(std::string(data.data(), 4) == "RIFF");
+    REQUIRE(std::string(data.data() + 8, 4) == "WAVE");
+    REQUIRE(TestHelpers::readLittleEndianUInt32(data, 4) == data.size() - 8);
+    // Sample rate.
+    REQUIRE(TestHelpers::readLittleEndianUInt32(data, 24) == 44100);
+    // Size of the sample data.
+    REQUIRE(TestHelpers::readLittleEndianUInt32(data, 40) == data.size() - 44);
+
+    // The file should contain some audio.
+    REQUIRE(std::any_of(data.begin() + 44, data.end(),
+                        [](char c) { return c != 0; }));
+}
@@ -0,0 +1,90 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <doctest/doctest.h>
+
+#include <midi/midifile.h>
+#include <score/score.h>
+
+#include <utility>
+#include "../testhelpers.h"
+
+/// Creates a score with a single quarter note, which is bent up a whole step
+/// over the duration of the note.
+static void createBendScore(Score &score)
+{
+    TestHelpers::createScore(score, 1, Position::QuarterNote);
+
+    Note &note = score.getSystems()[0].getStaves()[0].getVoices()[0]
+                     .getPositions()[0].getNotes()[0];
+    note.setFretNumber(5);
+    note.setBend(Bend(Bend::NormalBend, 4, 0, 1));
+}
+
+/// Returns the (tick, amount) pairs for the pitch wheel events.
+static std::vector<std::pair<int, int>> getPitchWheelEvents(MidiFile &file)
+{
+    std::vector<std::pair<int, int>> events;
+    for (MidiEventList &track : file.getTracks())
+    {
+        track.convertToAbsoluteTicks();
+        for (const MidiEvent &event : track)
+        {
+            if ((event.getStatusByte() & 0xf0) == MidiEvent::PitchWheel)
+                events.emplace_back(event.getTicks(), event.getData()[2]);
+        }
+    }
+
+    return events;
+}
+
+TEST_CASE("Midi/MidiFile/Bends")
+{
+    Score score;
+    createBendScore(score);
+
+    SUBCASE("Full resolution")
+    {
+        MidiFile file;
+        file.load(score, MidiFile::LoadOptions());
+
+        // There is an event for each step of the pitch wheel, followed by a
+        // return to the default bend at the end of the note.
+        const std::vector<std::pair<int, int>> expected = {
+            { 96, 65 },  { 192, 66 }, { 288, 67 },
+            { 384, 68 }, { 480, 69 }, { 480, 64 }
+        };
+        REQUIRE(getPitchWheelEvents(file) == expected);
+    }
+
+    SUBCASE("Reduced resolution")
+    {
+        MidiFile::LoadOptions options;
+        options.myCurveResolution = 2;
+
+        MidiFile file;
+        file.load(score, options);
+
+        // Only two events per beat are used, but the bend still reaches the
+        // same pitch.
+        const std::vector<std::pair<int, int>> expected = {
+            { 240, 66 }, { 480, 69 }, { 480, 64 }
+        };
+        REQUIRE(getPitchWheelEvents(file) == expected);
+    }
+}
@@ -0,0 +1,72 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <doctest/doctest.h>
+
+#include <midi/midieventlist.h>
+#include <midi/midiseekindex.h>
+
+TEST_CASE("Midi/MidiSeekIndex")
+{
+    const Midi::Tempo tempo(400000);
+
+    MidiEventList events;
+    events.append(MidiEvent::programChange(0, 0, 25));
+    events.append(MidiEvent::volumeChange(0, 0, 100));
+    events.append(MidiEvent::noteOn(0, 0, 60, 127, SystemLocation(0, 0)));
+    events.append(MidiEvent::pitchWheel(240, 0, 80));
+    events.append(MidiEvent::noteOff(960, 0, 60, SystemLocation(0, 0)));
+    events.append(MidiEvent::setTempo(960, tempo));
+    events.append(MidiEvent::noteOn(960, 1, 62, 127, SystemLocation(0, 4)));
+    events.append(MidiEvent::volumeChange(1200, 1, 50));
+    events.append(MidiEvent::noteOff(1920, 1, 62, SystemLocation(0, 4)));
+
+    // Two bars, with the first bar repeated.
+    std::vector<MidiFile::PerformedBar> bars = {
+        { 0, 0, 4, 0, Midi::BEAT_DURATION_120_BPM },
+        { 0, 0, 4, 960, Midi::BEAT_DURATION_120_BPM },
+        { 0, 4, 8, 1920, tempo },
+    };
+
+    const PlaybackOrder order({ { SystemLocation(0, 0), 0, 4, false },
+                                { SystemLocation(0, 0), 0, 4, true },
+                                { SystemLocation(0, 4), 4, 8, false } });
+
+    MidiSeekIndex index(events, bars, order);
+
+    // The first performance of the first bar has no state.
+    const MidiSeekIndex::Snapshot *snapshot =
+        index.findSnapshot(SystemLocation(0, 2));
+    REQUIRE(snapshot);
+    REQUIRE(snapshot->myEventIndex == 0);
+    REQUIRE(snapshot->getRestoreMessages().empty());
+
+    // The state at the start of the second bar.
+    snapshot = index.findSnapshot(SystemLocation(0, 4));
+    REQUIRE(snapshot);
+    REQUIRE(snapshot->myEventIndex == 8);
+    REQUIRE(snapshot->myTempo == tempo);
+
+    const std::vector<std::vector<uint8_t>> expected = {
+        { 0xc0, 25 }, { 0xb0, 7, 100 }, { 0xe0, 0, 80 }, { 0xb1, 7, 50 }
+    };
+    REQUIRE(snapshot->getRestoreMessages() == expected);
+
+    // Locations outside the performed bars.
+    REQUIRE(!index.findSnapshot(SystemLocation(0, 8)));
+    REQUIRE(!index.findSnapshot(SystemLocation(1, 0)));
+}
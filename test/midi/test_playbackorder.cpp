@@ -0,0 +1,59 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <doctest/doctest.h>
+
+#include <midi/playbackorder.h>
+#include <score/score.h>
+
+TEST_CASE("Midi/PlaybackOrder/Repeats")
+{
+    Score score;
+    System system;
+    system.insertBarline(Barline(8, Barline::RepeatStart));
+    system.insertBarline(Barline(16, Barline::RepeatEnd, 2));
+    system.getBarlines().back().setPosition(24);
+    score.insertSystem(system);
+    score.insertSystem(System());
+
+    PlaybackOrder order(score);
+    const std::vector<PlaybackOrder::Bar> &bars = order.getBars();
+    REQUIRE(bars.size() == 5);
+
+    REQUIRE(bars[0].myLocation == SystemLocation(0, 0));
+    REQUIRE(bars[0].myBarEnd == 8);
+    REQUIRE(bars[1].myBarStart == 8);
+    REQUIRE(!bars[1].myIsJump);
+    // The repeated section.
+    REQUIRE(bars[2].myLocation == SystemLocation(0, 8));
+    REQUIRE(bars[2].myBarStart == 8);
+    REQUIRE(bars[2].myBarEnd == 16);
+    REQUIRE(bars[2].myIsJump);
+    REQUIRE(bars[3].myBarStart == 16);
+    REQUIRE(!bars[3].myIsJump);
+    // The next system.
+    REQUIRE(bars[4].myLocation == SystemLocation(1, 0));
+
+    REQUIRE(order.findFirstPerformance(SystemLocation(0, 3)) == 0);
+    REQUIRE(order.findFirstPerformance(SystemLocation(0, 12)) == 1);
+    REQUIRE(order.findFirstPerformance(SystemLocation(0, 16)) == 3);
+    REQUIRE(order.findFirstPerformance(SystemLocation(1, 5)) == 4);
+    REQUIRE(order.findFirstPerformance(SystemLocation(2, 0)) == -1);
+
+    REQUIRE(order.isFirstPerformance(1));
+    REQUIRE(!order.isFirstPerformance(2));
+}
@@ -0,0 +1,123 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <doctest/doctest.h>
+
+#include <midi/midifile.h>
+#include <midi/scoretimeline.h>
+#include <score/score.h>
+#include "../testhelpers.h"
+
+using namespace std::chrono_literals;
+
+/// Creates a score with two bars of quarter notes that are repeated, and a
+/// tempo change to 60bpm in the second bar.
+static void createScore(Score &score)
+{
+    TestHelpers::createScore(score, 8, Position::QuarterNote);
+
+    System &system = score.getSystems()[0];
+    system.insertBarline(Barline(4, Barline::SingleBar));
+    system.getBarlines().back() = Barline(8, Barline::RepeatEnd, 2);
+
+    TempoMarker marker(4);
+    marker.setBeatsPerMinute(60);
+    system.insertTempoMarker(marker);
+}
+
+static void checkSameBars(const ScoreTimeline &timeline,
+                          const ScoreTimeline &expected)
+{
+    REQUIRE(timeline.getBars().size() == expected.getBars().size());
+    for (size_t i = 0; i < timeline.getBars().size(); ++i)
+    {
+        const ScoreTimeline::Bar &bar = timeline.getBars()[i];
+        const ScoreTimeline::Bar &expected_bar = expected.getBars()[i];
+        REQUIRE(bar.myStartTick == expected_bar.myStartTick);
+        REQUIRE(bar.myDuration == expected_bar.myDuration);
+        REQUIRE(bar.myTempo == expected_bar.myTempo);
+        REQUIRE(bar.myStartTime == expected_bar.myStartTime);
+    }
+
+    REQUIRE(timeline.getTotalTime() == expected.getTotalTime());
+}
+
+TEST_CASE("Midi/ScoreTimeline")
+{
+    Score score;
+    createScore(score);
+
+    ScoreTimeline timeline(score, MidiFile::DEFAULT_PPQ);
+    const std::vector<ScoreTimeline::Bar> &bars = timeline.getBars();
+    REQUIRE(bars.size() == 4);
+    REQUIRE(timeline.getTotalTicks() == 4 * 1920);
+    // 2s for the first bar at 120bpm, and 4s for each of the other bars.
+    REQUIRE(timeline.getTotalTime() == 14s);
+    REQUIRE(bars[2].myStartTime == 6s);
+
+    SUBCASE("Consistent with MidiFile")
+    {
+        MidiFile file;
+        file.load(score, MidiFile::LoadOptions());
+
+        const auto &performed_bars = file.getPerformedBars();
+        REQUIRE(performed_bars.size() == bars.size());
+        for (size_t i = 0; i < bars.size(); ++i)
+        {
+            REQUIRE(bars[i].mySystemIndex == performed_bars[i].mySystemIndex);
+            REQUIRE(bars[i].myBarStart == performed_bars[i].myBarStart);
+            REQUIRE(bars[i].myStartTick == performed_bars[i].myStartTick);
+            REQUIRE(bars[i].myTempo == performed_bars[i].myTempo);
+        }
+    }
+
+    SUBCASE("Lookups")
+    {
+        REQUIRE(timeline.getTime(SystemLocation(0, 0)) == 0s);
+        REQUIRE(timeline.getTime(SystemLocation(0, 2)) == 1s);
+        REQUIRE(timeline.getTime(SystemLocation(0, 6)) == 4s);
+        // The end of the system.
+        REQUIRE(timeline.getTime(SystemLocation(0, 8)) == 6s);
+        REQUIRE(!timeline.getTime(SystemLocation(1, 0)));
+
+        REQUIRE(timeline.findBarAtTime(0s) == 0);
+        REQUIRE(timeline.findBarAtTime(3s) == 1);
+        REQUIRE(timeline.findBarAtTime(6s) == 2);
+        REQUIRE(timeline.findBarAtTime(14s) == -1);
+        REQUIRE(timeline.findBarAtTick(1920 * 3) == 3);
+        REQUIRE(timeline.findBarAtTick(1920 * 4) == -1);
+    }
+
+    SUBCASE("Incremental update")
+    {
+        System &system = score.getSystems()[0];
+        TempoMarker marker = system.getTempoMarkers().front();
+        system.removeTempoMarker(marker);
+        marker.setBeatsPerMinute(240);
+        system.insertTempoMarker(marker);
+
+        timeline.updateSystem(0);
+        REQUIRE(timeline.getTotalTime() == 2s + 1s + 1s + 1s);
+        checkSameBars(timeline, ScoreTimeline(score, MidiFile::DEFAULT_PPQ));
+
+        // Adding a system requires the entire timeline to be rebuilt.
+        score.insertSystem(score.getSystems()[0]);
+        timeline.updateSystem(1);
+        checkSameBars(timeline, ScoreTimeline(score, MidiFile::DEFAULT_PPQ));
+    }
+}
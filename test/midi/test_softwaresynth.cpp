@@ -0,0 +1,87 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <doctest/doctest.h>
+
+#include <midi/midievent.h>
+#include <midi/softwaresynth.h>
+
+#include <algorithm>
+#include <cmath>
+
+static float getPeak(SoftwareSynth &synth, int num_frames)
+{
+    std::vector<float> buffer(2 * num_frames);
+    synth.render(buffer.data(), num_frames);
+
+    float peak = 0;
+    for (float sample : buffer)
+        peak = std::max(peak, std::abs(sample));
+    return peak;
+}
+
+TEST_CASE("Midi/SoftwareSynth/NoteOnOff")
+{
+    SoftwareSynth synth;
+    const SystemLocation location;
+
+    CHECK(getPeak(synth, 512) == 0);
+
+    synth.processMessage(
+        MidiEvent::noteOn(0, 0, 60, 127, location).getData());
+    REQUIRE(synth.getActiveVoiceCount() == 1);
+    CHECK(getPeak(synth, 512) > 0);
+
+    // After releasing the note, it should eventually become silent.
+    synth.processMessage(MidiEvent::noteOff(0, 0, 60, location).getData());
+    getPeak(synth, synth.getSampleRate());
+    CHECK(synth.getActiveVoiceCount() == 0);
+    CHECK(getPeak(synth, 512) == 0);
+}
+
+TEST_CASE("Midi/SoftwareSynth/HoldPedal")
+{
+    SoftwareSynth synth;
+    const SystemLocation location;
+
+    synth.processMessage(MidiEvent::programChange(0, 0, 48).getData());
+    synth.processMessage(MidiEvent::holdPedal(0, 0, true).getData());
+    synth.processMessage(
+        MidiEvent::noteOn(0, 0, 60, 127, location).getData());
+    synth.processMessage(MidiEvent::noteOff(0, 0, 60, location).getData());
+
+    // The note should be sustained until the pedal is released.
+    getPeak(synth, synth.getSampleRate());
+    CHECK(synth.getActiveVoiceCount() == 1);
+
+    synth.processMessage(MidiEvent::holdPedal(0, 0, false).getData());
+    getPeak(synth, synth.getSampleRate());
+    CHECK(synth.getActiveVoiceCount() == 0);
+}
+
+TEST_CASE("Midi/SoftwareSynth/InvalidDataBytes")
+{
+    SoftwareSynth synth;
+    const SystemLocation location;
+
+    // A program number outside of 0-127 should not select a missing patch.
+    synth.processMessage({ 0xc0, 0xff });
+    synth.processMessage(
+        MidiEvent::noteOn(0, 0, 60, 127, location).getData());
+    REQUIRE(synth.getActiveVoiceCount() == 1);
+    CHECK(getPeak(synth, 512) > 0);
+}
@@ -0,0 +1,157 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <doctest/doctest.h>
+
+#include <score/score.h>
+#include <score/utils/scoremerger.h>
+
+#include <chrono>
+#include "../testhelpers.h"
+
+static constexpr int theBarsPerSystem = 4;
+static constexpr int theBarWidth = 8;
+
+/// Creates a score resembling an imported v1.7 guitar or bass score, with a
+/// repeated section every few systems, and some multi-bar rests and player
+/// changes.
+static void createScore(Score &score, int num_systems, int string_count,
+                        int multibar_rest_interval, int player_change_interval)
+{
+    TestHelpers::addPlayer(score);
+
+    for (int i = 0; i < num_systems; ++i)
+    {
+        System system;
+        Staff staff(string_count);
+        Voice &voice = staff.getVoices()[0];
+
+        for (int bar = 0; bar < theBarsPerSystem; ++bar)
+        {
+            const int start = bar * theBarWidth;
+            if (bar > 0)
+                system.insertBarline(Barline(start, Barline::SingleBar));
+
+            if (i % multibar_rest_interval == 1 && bar == 1)
+            {
+                Position rest(start + 1, Position::WholeNote);
+                rest.setRest();
+                rest.setMultiBarRest(4);
+                voice.insertPosition(rest);
+                continue;
+            }
+
+            for (int j = 1; j <= 4; ++j)
+            {
+                Position pos(start + j, Position::QuarterNote);
+                pos.insertNote(Note(j % string_count, bar + j));
+                voice.insertPosition(pos);
+            }
+        }
+
+        // Repeat every fourth system.
+        if (i % 4 == 0)
+            system.getBarlines()[0].setBarType(Barline::RepeatStart);
+        system.getBarlines().back() =
+            Barline(theBarsPerSystem * theBarWidth,
+                    i % 4 == 0 ? Barline::RepeatEnd : Barline::SingleBar,
+                    i % 4 == 0 ? 2 : 0);
+
+        if (i % player_change_interval == 0)
+            TestHelpers::addPlayerChange(system);
+
+        system.insertStaff(staff);
+        score.insertSystem(system);
+    }
+}
+
+static int countNotes(const Score &score, int staff_begin, int staff_end)
+{
+    int count = 0;
+    for (const System &system : score.getSystems())
+    {
+        for (int i = staff_begin;
+             i < std::min(staff_end, static_cast<int>(system.getStaves().size()));
+             ++i)
+        {
+            for (const Position &pos :
+                 system.getStaves()[i].getVoices()[0].getPositions())
+            {
+                count += static_cast<int>(pos.getNotes().size());
+            }
+        }
+    }
+
+    return count;
+}
+
+static int countBars(const Score &score, Barline::BarType type)
+{
+    int count = 0;
+    for (const System &system : score.getSystems())
+    {
+        for (const Barline &bar : system.getBarlines())
+            count += bar.getBarType() == type;
+    }
+
+    return count;
+}
+
+TEST_CASE("Score/ScoreMerger/Merge")
+{
+    Score guitar_score, bass_score;
+    createScore(guitar_score, 20, 6, 5, 10);
+    createScore(bass_score, 20, 4, 5, 10);
+
+    Score score;
+    ScoreMerger::merge(score, guitar_score, bass_score);
+
+    REQUIRE(score.getPlayers().size() == 2);
+    REQUIRE(score.getInstruments().size() == 2);
+
+    // Each system has a guitar and a bass staff.
+    for (const System &system : score.getSystems())
+    {
+        REQUIRE(system.getStaves().size() == 2);
+        REQUIRE(system.getStaves()[0].getStringCount() == 6);
+        REQUIRE(system.getStaves()[1].getStringCount() == 4);
+    }
+
+    // The repeated sections line up, so they should be kept rather than
+    // being expanded, and no notes should be duplicated or dropped.
+    REQUIRE(countBars(score, Barline::RepeatStart) ==
+            countBars(guitar_score, Barline::RepeatStart));
+    REQUIRE(countNotes(score, 0, 1) == countNotes(guitar_score, 0, 1));
+    REQUIRE(countNotes(score, 1, 2) == countNotes(bass_score, 0, 1));
+}
+
+TEST_CASE("Score/ScoreMerger/Benchmark" * doctest::skip())
+{
+    Score guitar_score, bass_score;
+    createScore(guitar_score, 4000, 6, 5, 10);
+    createScore(bass_score, 4000, 4, 7, 3);
+
+    using Clock = std::chrono::high_resolution_clock;
+    auto start = Clock::now();
+    Score score;
+    ScoreMerger::merge(score, guitar_score, bass_score);
+    const std::chrono::duration<double> merge_time = Clock::now() - start;
+
+    MESSAGE("Merged " << guitar_score.getSystems().size() * theBarsPerSystem
+                      << " bars into " << score.getSystems().size()
+                      << " systems in " << merge_time.count() * 1000 << "ms");
+}
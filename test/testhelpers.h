@@ -0,0 +1,88 @@
+/*
+  * Copyright (C) 2020 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEST_TESTHELPERS_H
+#define TEST_TESTHELPERS_H
+
+#include <score/score.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace TestHelpers {
+
+    /// Adds a player and an instrument to the score.
+    inline void addPlayer(Score &score)
+    {
+        score.insertPlayer(Player());
+        score.insertInstrument(Instrument());
+    }
+
+    /// Assigns the score's first player to the system's first staff.
+    inline void addPlayerChange(System &system)
+    {
+        PlayerChange change(0);
+        change.insertActivePlayer(0, ActivePlayer(0, 0));
+        system.insertPlayerChange(change);
+    }
+
+    /// Creates a score with a single player and a bar of notes with the
+    /// given duration, on the second string.
+    inline void createScore(Score &score, int num_notes,
+                            Position::DurationType duration =
+                                Position::EighthNote)
+    {
+        addPlayer(score);
+
+        System system;
+        Staff staff;
+        for (int i = 0; i < num_notes; ++i)
+        {
+            Position pos(i, duration);
+            pos.insertNote(Note(1, i % 12));
+            staff.getVoices()[0].insertPosition(pos);
+        }
+        system.insertStaff(staff);
+
+        system.getBarlines().back() = Barline(num_notes, Barline::SingleBar);
+        addPlayerChange(system);
+
+        score.insertSystem(system);
+    }
+
+    /// Reads a big-endian 32-bit integer from a byte buffer.
+    template <typename Buffer>
+    uint32_t readBigEndianUInt32(const Buffer &data, size_t offset)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+            value = (value << 8) | static_cast<uint8_t>(data[offset + i]);
+        return value;
+    }
+
+    /// Reads a little-endian 32-bit integer from a byte buffer.
+    template <typename Buffer>
+    uint32_t readLittleEndianUInt32(const Buffer &data, size_t offset)
+    {
+        uint32_t value = 0;
+        for (int i = 3; i >= 0; --i)
+            value = (value << 8) | static_cast<uint8_t>(data[offset + i]);
+        return value;
+    }
+}
+
+#endif